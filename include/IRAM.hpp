@@ -2,17 +2,25 @@
 #define IRAM_HPP
 
 #include "arnoldi.hpp"
+#include "sstep.hpp"
+#include "pipeline.hpp"
 #include "shift.hpp"
+#include "arena.hpp"
+#include "adaptive.hpp"
+
+#include <functional>
+#include <limits>
+#include <numeric>
 
 // #define DBG_INTERNALS
 #ifdef DBG_INTERNALS
-template <typename M, typename DS, size_t N, size_t A, size_t B, size_t C>
-void IRAM_dbg_check(DS* d_evecs, DS* d_h, const M& Q, const M& H_tilde) {
-    constexpr size_t ALLOC_SIZE = BasisTraits<M>::ALLOC_SIZE;
-    M initial_evecs = M::Zero(N, B + 1);
-    M initial_h = M::Zero(B + 1, B);
-    cudaMemcpyChecked(initial_evecs.data(), d_evecs, N * (B+1) * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-    cudaMemcpyChecked(initial_h.data(), d_h, (B + 1) * B * ALLOC_SIZE, cudaMemcpyDeviceToHost);
+template <typename OM, typename DS, typename BK = DefaultBackend>
+void IRAM_dbg_check(DS* d_evecs, DS* d_h, const Eigen::Ref<const OM>& Q, const Eigen::Ref<const OM>& H_tilde, size_t N, size_t B, size_t C) {
+    constexpr size_t ALLOC_SIZE = sizeof(DS);
+    OM initial_evecs = OM::Zero(N, B + 1);
+    OM initial_h = OM::Zero(B + 1, B);
+    BK::memcpy(initial_evecs.data(), d_evecs, N * (B+1) * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+    BK::memcpy(initial_h.data(), d_h, (B + 1) * B * ALLOC_SIZE, MemcpyKind::DeviceToHost);
     // std::cout << "Initial Evecs:\n" << initial_evecs << std::endl;
     assert(initial_h.isApprox(H_tilde));
     assert(initial_evecs.block(0,0,N,C).isApprox(Q.block(0,0,N,C)));
@@ -20,99 +28,498 @@ void IRAM_dbg_check(DS* d_evecs, DS* d_h, const M& Q, const M& H_tilde) {
 }
 #endif
 
-template <typename M, size_t N, size_t A, size_t B, size_t C> //A is max iters, B is basis size, C is restart size
-ComplexEigenPairs IRAM(const M& M_, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle, const HostPrecision& tol = default_tol) {
-    using S = typename BasisTraits<M>::S;
-    using DS = typename BasisTraits<M>::DS;
-    using V = typename BasisTraits<M>::V;
-    using OM = typename BasisTraits<M>::OM;
-    constexpr size_t ALLOC_SIZE = BasisTraits<M>::ALLOC_SIZE;
-    const HostPrecision matnorm = M_.norm();
-
-    OM Q(N, B + 1);
-    OM H_tilde(B + 1, B);
-
-    assert(B < N && "max_iters must be leq than leading dimension of M");
-    Vector norms(B);
-    V v0 = randVecGen<V>(N);
-
-
-
-    size_t m = 1;
-    const size_t ROWS = DYNAMIC_ROW_ALLOC(N);
-
-    // CUDA Allocations
-    DS* d_evecs = cudaMallocChecked<DS>((B + 1) * N * ALLOC_SIZE);
-    DS* d_proj = cudaMallocChecked<DS>((B + 1) * ALLOC_SIZE);
-    DS* d_y = cudaMallocChecked<DS>(N * ALLOC_SIZE);
-    DS* d_M = cudaMallocChecked<DS>(ROWS * N * ALLOC_SIZE);
-    DS* d_result = cudaMallocChecked<DS>(N * ALLOC_SIZE);
-    DS* d_h = cudaMallocChecked<DS>((B + 1) * B * ALLOC_SIZE);
-
-    // Initial setup
-    cudaMemcpyChecked(d_y, v0.data(), N * ALLOC_SIZE, cudaMemcpyHostToDevice);
-    cudaMemcpyChecked(d_evecs, v0.data(), N * ALLOC_SIZE, cudaMemcpyHostToDevice);
-
-    ComplexMatrix Q_block(N, B);
-    ComplexMatrix H_square(B, B);
-
-    const size_t num_loops = std::ceil(A / B);
-    std::cout << "Entering Arnoldi Iteration" << std::endl;
-    for (int i = 0; i < num_loops; i++) {
-        auto start_iter = std::chrono::high_resolution_clock::now();
-        if (i == 0) {KrylovIterInternal<M, DS, N, N, B>(M_, d_M, d_y, d_result, d_evecs, d_h, norms, ROWS, handle, matnorm);}
-        else {        
-            cudaMemcpyChecked(d_evecs, Q.data(), N * C * ALLOC_SIZE, cudaMemcpyHostToDevice); //Ideally looking to make the shifting be on GPU to avoid memcpy, but not end of world
-            cudaMemset(d_evecs + N * C, 0, N * (B + 1 - C) * ALLOC_SIZE);
-            cudaMemcpyChecked(d_h, H_tilde.data(), (B+1) * C * ALLOC_SIZE, cudaMemcpyHostToDevice);
-            cudaMemset(d_h + (B+1) * C, 0, (B+1) * (B - C) * ALLOC_SIZE); //Since is Hessenberg, we just need to set subsequent cols to zero
-            cudaMemcpyChecked(d_y, d_evecs, N * ALLOC_SIZE, cudaMemcpyDeviceToDevice);
-                        
-            #ifdef DBG_INTERNALS
-            IRAM_dbg_check<M, DS, N, A, B, C>(d_evecs, d_h, Q, H_tilde);
-            #endif
-
-            cudaMemcpyChecked(d_y, v0.data(), N * ALLOC_SIZE, cudaMemcpyHostToDevice);
-            KrylovIterInternal<M, DS, N, N, B, C - 1>(M_, d_M, d_y, d_result, d_evecs, d_h, norms, ROWS, handle, matnorm);
+// How a cycle shrinks the basis from basis_size back to restart_size columns
+enum class RestartMethod {
+    SHIFTED_QR,   // Implicit restart, m - k shifted QR steps rotating the basis (reduceArnoldiPairDynamic)
+    KRYLOV_SCHUR  // Ordered Schur form and one N x m x k product (krylovSchurRestart), real Schur form for real bases
+};
+
+// Runtime counterparts of IRAM's template parameters: rows := N, max_iters := A, basis_size := B, restart_size := C
+struct SolverConfig {
+    size_t rows = 0;
+    size_t max_iters = 1000;
+    size_t basis_size = 50;
+    size_t restart_size = 10;
+    size_t num_pairs = 10;    // Returned Ritz pairs, capped at restart_size
+    HostPrecision tol = default_tol;
+    HostPrecision breakdown_tol = 1e-5; // Arnoldi stops early once h_{j+1,j} < breakdown_tol ||A||, an invariant subspace
+    bool verbose = false;     // Per-cycle timing output
+    bool huge_pages = false;  // Back the host arena with transparent huge pages, fixed at solver construction
+    RestartMethod restart = RestartMethod::SHIFTED_QR;
+    BasisUpdate basis_update = BasisUpdate::ACCUMULATE; // Shifted QR only: per-shift basis sweeps or one gemm
+    bool locking = true;      // Krylov-Schur only: converged Schur vectors leave the active basis and are never recomputed
+    Orthogonalization orthogonalization = Orthogonalization::MGS;
+    size_t s_step = 1;        // Krylov vectors per block orthogonalization (sstep.hpp), 1 := one reduction set per vector
+    bool pipelined = false;   // One reduction per step overlapped with the next matvec (pipeline.hpp), always CGS2 based, s_step = 1 only (solve() throws otherwise)
+    bool full_reorth = false; // Lanczos: Gram-Schmidt against the whole basis twice per step (off := three-term recurrence)
+    bool adaptive_precision = false; // Early float cycles, then HostPrecision (adaptive.hpp), CPU only. A dense A is re-rounded into a kept copy of half its size each solve
+};
+
+// IRAM with runtime sizes. The solver owns its backend and host workspaces and only grows them, so a second solve of the
+// same or a smaller problem reuses every buffer. Host matrices are Eigen maps carved from one aligned arena, never owning
+// storage, and the restart runs on that arena too: once warm a restart cycle makes no heap allocation.
+template <typename S = ComplexType, typename BK = DefaultBackend>
+class IRAMSolver {
+public:
+    using OM = std::conditional_t<is_complex_v<S>, ComplexMatrix, Matrix>;
+    using V = typename BasisTraits<OM>::V;
+    using DS = typename BasisTraits<OM>::DS;
+    static constexpr size_t ALLOC_SIZE = BasisTraits<OM>::ALLOC_SIZE;
+
+    // Called at the top of every Arnoldi cycle with the cycle index, instrumentation only
+    using CycleHook = std::function<void(size_t)>;
+
+    explicit IRAMSolver(const SolverConfig& config = {}) : config_(config), arena_(0, config.huge_pages) {
+        if (config_.rows) {reserve(config_.rows, config_.basis_size);}
+    }
+    IRAMSolver(const IRAMSolver&) = delete;
+    IRAMSolver& operator=(const IRAMSolver&) = delete;
+    ~IRAMSolver() { release(); }
+
+    inline const SolverConfig& config() const { return config_; }
+    inline void configure(const SolverConfig& config) { config_ = config; }
+    inline size_t workspaceAllocations() const { return allocations_ + arena_.blockAllocations(); } // Buffer (re)allocations since construction
+    inline const WorkspaceArena& arena() const { return arena_; }
+    inline void setCycleHook(CycleHook hook) { cycle_hook_ = std::move(hook); }
+
+    // Grows every workspace to hold an N x (B + 1) basis, no-op when already large enough. ROWS staging is sized lazily
+    void reserve(size_t N, size_t B) {
+        ensure(d_evecs_, (B + 1) * N);
+        ensure(d_y_, N);
+        ensure(d_result_, N);
+        ensure(d_h_, (B + 1) * B);
+        ensure(d_work_, B + 1);
+        ensure(d_coeffs_, config_.s_step > 1 ? (B + 1) * config_.s_step : 0);
+        arena_.reset();
+        arena_.reserve(hostFootprint(N, B));
+    }
+
+    // Host arena bytes for an N x (B + 1) basis: Q, H, the restart copies, norms and the restart scratch. Everything
+    // N-sized is in the basis scalar, a real solve never holds a complex N x B block
+    static size_t hostFootprint(size_t N, size_t B) {
+        return WorkspaceArena::footprint<S>(N * (B + 1)) + WorkspaceArena::footprint<S>((B + 1) * B)
+             + WorkspaceArena::footprint<S>(N * B) + WorkspaceArena::footprint<S>(B * B)
+             + WorkspaceArena::footprint<HostPrecision>(B) + RestartWorkspace::footprint(B)
+             + WorkspaceArena::footprint<ComplexType>(B) + WorkspaceArena::footprint<size_t>(B);
+    }
+
+    template <typename M>
+    ComplexEigenPairs solve(const M& M_, typename BK::BlasHandle& handle, typename BK::SolverHandle& solver_handle, KrylovStats* stats = nullptr) {
+        // A real dense matrix also runs in a complex basis, applied without a complex copy (matmul_internal)
+        static_assert(std::is_same_v<typename BasisTraits<M>::S, S> || (is_complex_v<S> && !is_linear_operator_v<M>),
+                      "IRAMSolver scalar must match the operator scalar.");
+        const size_t N = M_.rows();
+        const size_t A = config_.max_iters;
+        const size_t B = config_.basis_size;
+        const size_t C = config_.restart_size;
+        if (C == 0 || C >= B || B >= N) {
+            throw std::invalid_argument("IRAMSolver needs 0 < restart_size < basis_size < rows, got " + std::to_string(C) + ", "
+                                        + std::to_string(B) + ", " + std::to_string(N));
+        }
+        if (config_.adaptive_precision && !BK::HOST_RESIDENT) {throw std::invalid_argument("Adaptive precision runs on the CPU backend only");}
+        if (config_.pipelined && config_.s_step > 1) {throw std::invalid_argument("Pipelined Arnoldi needs s_step = 1, got " + std::to_string(config_.s_step));}
+        const bool krylov_schur = config_.restart == RestartMethod::KRYLOV_SCHUR;
+        const HostPrecision matnorm = operatorNorm(M_);
+        const bool verbose = config_.verbose;
+        KrylovStats local_stats;
+        KrylovStats& st = stats ? *stats : local_stats;
+        st = KrylovStats{};
+
+        reserve(N, B);
+        const size_t ROWS = is_linear_operator_v<M> ? 0 : BK::rowAlloc(N); // Operators never need the staging buffer
+        ensure(d_M_, ROWS * N);
+        DS* d_evecs = d_evecs_.ptr;
+        DS* d_y = d_y_.ptr;
+        DS* d_result = d_result_.ptr;
+        DS* d_h = d_h_.ptr;
+        DS* d_M = d_M_.ptr;
+
+        Eigen::Map<OM> Q(arena_.allocate<S>(N * (B + 1)), N, B + 1);
+        Eigen::Map<OM> H_tilde(arena_.allocate<S>((B + 1) * B), B + 1, B);
+        Eigen::Map<OM> Q_block(arena_.allocate<S>(N * B), N, B);
+        Eigen::Map<OM> H_square(arena_.allocate<S>(B * B), B, B);
+        HostPrecision* norms = arena_.allocate<HostPrecision>(B);
+        ritz_vector_ = arena_.allocate<ComplexType>(B);
+        ritz_order_ = arena_.allocate<size_t>(B);
+        restart_.bind(arena_, B);
+        restart_.update = config_.basis_update;
+
+        // Normalized random start vector, drawn straight into the basis workspace
+        Q.col(0).setRandom();
+        Q.col(0).normalize();
+        const size_t total_loops = std::max<size_t>(1, A / B);
+        const size_t nev = std::min(config_.num_pairs, C);
+        // Adaptive precision replaces the start vector by the one promoted from the single-precision cycles
+        const size_t single_cycles = config_.adaptive_precision ? singlePrecisionCycles(M_, handle, Q, H_tilde, Q_block, H_square, norms,
+                                                                                        total_loops - 1, nev, matnorm, st) : 0;
+        BK::memset(d_h, 0, (B + 1) * B * ALLOC_SIZE); // MGS only writes the upper Hessenberg part of each column
+        BK::memcpy(d_y, Q.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
+        BK::memcpy(d_evecs, Q.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
+
+        size_t m = 1;
+        const size_t num_loops = total_loops - single_cycles;
+        const size_t promoted = st.restarts; // Restarts of the single-precision phase, its H does not carry over
+        const HostPrecision tol = config_.tol * matnorm;
+        size_t locked = 0;        // Leading converged Schur vectors, Krylov-Schur with locking only
+        size_t restart_cols = C;  // Columns kept by the last restart, C + 1 when a real Krylov-Schur restart keeps a split pair
+        if (verbose) {std::cout << "Entering Arnoldi Iteration" << std::endl;}
+        for (size_t i = 0; i < num_loops; i++) {
+            if (cycle_hook_) {cycle_hook_(single_cycles + i);}
+            auto start_iter = std::chrono::high_resolution_clock::now();
+            // Shifted QR recomputes the last kept column, Krylov-Schur keeps all C and extends from the old residual q_{B+1}
+            const size_t kept = krylov_schur ? restart_cols + 1 : C;
+            const size_t first = (i == 0) ? 0 : kept - 1;
+            if (i > 0) {
+                BK::memcpy(d_evecs, Q.data(), N * kept * ALLOC_SIZE, MemcpyKind::HostToDevice); //Ideally looking to make the shifting be on GPU to avoid memcpy, but not end of world
+                BK::memset(d_evecs + N * kept, 0, N * (B + 1 - kept) * ALLOC_SIZE);
+                BK::memcpy(d_h, H_tilde.data(), (B+1) * restart_cols * ALLOC_SIZE, MemcpyKind::HostToDevice);
+                BK::memset(d_h + (B+1) * restart_cols, 0, (B+1) * (B - restart_cols) * ALLOC_SIZE); //Since is Hessenberg, we just need to set subsequent cols to zero
+
+                #ifdef DBG_INTERNALS
+                IRAM_dbg_check<OM, DS, BK>(d_evecs, d_h, Q, H_tilde, N, B, C);
+                #endif
+
+                BK::memcpy(d_y, d_evecs + N * first, N * ALLOC_SIZE, MemcpyKind::DeviceToDevice); // Extend from the last retained column
+            }
+            if (config_.s_step > 1) {
+                m = SStepKrylovIterDynamic<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, norms, ROWS, N, B, first, config_.s_step,
+                                                      d_coeffs_.ptr, handle, matnorm, config_.breakdown_tol, config_.orthogonalization,
+                                                      d_work_.ptr, &st);
+            } else if (config_.pipelined) {
+                if (!pool_) {pool_ = std::make_unique<WorkerPool>(1);}
+                m = PipelinedKrylovIterDynamic<M, DS, BK>(M_, d_M, d_evecs, d_h, norms, ROWS, N, B, first, *pool_, handle, matnorm,
+                                                          config_.breakdown_tol, d_work_.ptr, &st);
+            } else {
+                m = KrylovIterDynamic<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, norms, ROWS, N, N, B, first, handle, matnorm,
+                                                 config_.breakdown_tol, config_.orthogonalization, d_work_.ptr, &st);
+            }
+            st.matvecs += m - first;
+            st.matrix_passes += m - first;
+            BK::memcpy(Q.data(), d_evecs, N * (B + 1) * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+            BK::memcpy(H_tilde.data(), d_h, (B + 1) * B * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+            for (size_t j = first; j < B; ++j) { H_tilde(j + 1, j) = norms[j]; } // Insert norms back into Hessenberg diagonal, restarted columns keep theirs
+
+            assert(isOrthonormal<OM>(Q.leftCols(std::min<size_t>(m, 10))));
+
+            auto end_iter = std::chrono::high_resolution_clock::now();
+            if (verbose) {
+                std::cout << "Arnoldi Iteration " << i << ", Performed in :"
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(end_iter - start_iter).count()
+                          << " ms" << std::endl;
+            }
+            // Converged: the nev wanted Ritz pairs of this basis already meet tol, every further cycle would be wasted
+            // Locked pairs count as converged, only the active block is searched for the rest
+            const size_t active = m - locked;
+            const size_t done = std::min(locked, nev);
+            H_square.topLeftCorner(active, active) = H_tilde.block(locked, locked, active, active);
+            st.converged = done + convergedPairs(H_square.topLeftCorner(active, active), std::abs(H_tilde(m, m - 1)),
+                                                 !(krylov_schur && st.restarts > promoted), nev - done, tol);
+            if (verbose) {std::cout << "Arnoldi Iteration " << i << ", converged " << st.converged << " / " << nev << std::endl;}
+            // Breakdown: the leading m columns span an invariant subspace, its Ritz pairs are exact so stop restarting
+            if (st.converged == nev || m < B || i + 1 == num_loops) {break;}
+
+            auto start_reduce = std::chrono::high_resolution_clock::now();
+            if (krylov_schur) {
+                restart_cols = krylovSchurRestart<OM, BK>(Q, H_tilde, N, B, C, handle, Q_block, H_square, restart_, locked, config_.locking ? tol : 0, verbose);
+                st.locked = locked;
+            } else {
+                reduceArnoldiPairDynamic<OM, BK>(Q, H_tilde, N, B, C, handle, solver_handle, Q_block, H_square, restart_, verbose);
+            }
+            auto end_reduce = std::chrono::high_resolution_clock::now();
+            if (verbose) {
+                std::cout << "Arnoldi Reduction " << i << ", Performed in :"
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(end_reduce - start_reduce).count()
+                          << " ms" << std::endl;
+            }
+            st.restarts++;
+
+            assert(isOrthonormal<OM>(Q.leftCols(restart_cols)));
+            assert(krylov_schur || isHessenberg<OM>(H_tilde.block(0,0,C, C)));
+            m = restart_cols;
         }
-        cudaMemcpyChecked(Q.data(), d_evecs, N * (B + 1) * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-        cudaMemcpyChecked(H_tilde.data(), d_h, (B + 1) * B * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-        for (int j = 0; j < B; ++j) { H_tilde(j + 1, j) = norms[j]; } // Insert norms back into Hessenberg diagonal
-
-        assert(isOrthonormal<OM>(Q.block(0,0,N,10)));
-        // assert(isHessenberg<OM>(H_tilde));
-
-        auto end_iter = std::chrono::high_resolution_clock::now();
-        std::cout << "Arnoldi Iteration " << i << ", Performed in :"
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(end_iter - start_iter).count()
-                  << " ms" << std::endl;
-        auto start_reduce = std::chrono::high_resolution_clock::now();
-        reduceArnoldiPairInternal<M, N, B>(Q, H_tilde, C, handle, solver_handle, H_square, Q_block);
-        auto end_reduce = std::chrono::high_resolution_clock::now();
-        std::cout << "Arnoldi Reduction " << i << ", Performed in :"
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(end_reduce - start_reduce).count()
-                  << " ms" << std::endl;
-
-        assert(isOrthonormal<OM>(Q.leftCols(C)));
-        assert(isHessenberg<OM>(H_tilde.block(0,0,C, C)));
+
+        // After a Krylov-Schur restart row C of H carries b^T, so the projected matrix needs a general eigensolver. A real
+        // H is decomposed in real arithmetic, complex numbers first appear in its eigenvectors
+        ComplexEigenPairs ritzPairs{};
+        if (krylov_schur && st.restarts > promoted) {eigSolver<OM>(H_tilde.block(0,0,m, m), ritzPairs, m);}
+        else {hessEigSolver<OM>(H_tilde.block(0,0,m, m), ritzPairs, m);}
+        const size_t k = std::min({config_.num_pairs, C, m});
+        const HostPrecision beta = std::abs(H_tilde(m, m - 1));
+        st.residuals.resize(k);
+        for (size_t j = 0; j < k; ++j) {st.residuals[j] = beta * std::abs(ritzPairs.vectors(m - 1, j)) / ritzPairs.vectors.col(j).norm();}
+        st.converged = (st.residuals.array() < tol).count();
+        st.orthogonality_loss = orthogonalityLoss<OM>(Q.leftCols(m));
+        ComplexMatrix ritzVectors;
+        if constexpr (is_complex_v<S>) {ritzVectors = Q.leftCols(m) * ritzPairs.vectors.leftCols(k);}
+        else {
+            // Conjugate pairs share one real and one imaginary column, so the expansion is one real N x m x k gemm at most
+            Matrix Y(m, k + 1);
+            const Eigen::Index cols = packConjugatePairs(ritzPairs.values.head(k), ritzPairs.vectors, Y);
+            const Matrix X = Q.leftCols(m) * Y.leftCols(cols);
+            ritzVectors = expandConjugatePairs(ritzPairs.values.head(k), X);
         }
+        restoreOrder(M_, ritzVectors);
+        return {ritzPairs.values.head(k), ritzVectors, k};
+    }
+
+private:
+    // Number of the nev largest Ritz values of H_m whose residual estimate |h_{m+1,m} e_m^T y_i| is below tol, worst
+    // receives the largest of their estimates. The unit eigenvectors y_i come from a Schur form H_m = U T U^H by back
+    // substitution on T, only their last entries are kept
+    size_t convergedPairs(Eigen::Ref<ComplexMatrix> H_m, HostPrecision beta, bool hessenberg, size_t nev, HostPrecision tol,
+                          HostPrecision* worst = nullptr) {
+        const Eigen::Index m = H_m.rows();
+        Eigen::ComplexSchur<ComplexMatrix>& schur = restart_.schur;
+        if (hessenberg) {schur.computeFromHessenberg(H_m, ComplexMatrix::Identity(m, m), true);}
+        else {schur.compute(H_m, true);}
+        const ComplexMatrix& T = schur.matrixT();
+        const ComplexMatrix& U = schur.matrixU();
+        std::iota(ritz_order_, ritz_order_ + m, size_t(0));
+        std::partial_sort(ritz_order_, ritz_order_ + nev, ritz_order_ + m,
+                          [&T](size_t a, size_t b) {return magnitude(T(a, a)) > magnitude(T(b, b));});
+
+        size_t converged = 0;
+        if (worst) {*worst = 0;}
+        ComplexType* z = ritz_vector_;
+        for (size_t p = 0; p < nev; ++p) {
+            const Eigen::Index i = ritz_order_[p];
+            const ComplexType lambda = T(i, i);
+            const HostPrecision smin = std::max(std::numeric_limits<HostPrecision>::epsilon() * std::abs(lambda),
+                                                std::numeric_limits<HostPrecision>::min());
+            z[i] = 1;
+            for (Eigen::Index j = i - 1; j >= 0; --j) {
+                ComplexType acc = 0;
+                for (Eigen::Index l = j + 1; l <= i; ++l) {acc += T(j, l) * z[l];}
+                ComplexType d = T(j, j) - lambda;
+                if (std::abs(d) < smin) {d = smin;}
+                z[j] = -acc / d;
+            }
+            HostPrecision norm = 0;
+            ComplexType last = 0;
+            for (Eigen::Index l = 0; l <= i; ++l) {
+                norm += std::norm(z[l]);
+                last += U(m - 1, l) * z[l];
+            }
+            const HostPrecision estimate = beta * std::abs(last) / std::sqrt(norm);
+            converged += (estimate < tol);
+            if (worst) {*worst = std::max(*worst, estimate);}
+        }
+        return converged;
+    }
+
+    // Real counterpart on H_m = U T U^T with T quasi-triangular. The eigenvector of a real eigenvalue is real. For a
+    // complex one the 2 x 2 block's null vector seeds a complex back substitution, one 1 x 1 or 2 x 2 block at a time
+    size_t convergedPairs(Eigen::Ref<Matrix> H_m, HostPrecision beta, bool hessenberg, size_t nev, HostPrecision tol,
+                          HostPrecision* worst = nullptr) {
+        const Eigen::Index m = H_m.rows();
+        Eigen::RealSchur<Matrix>& schur = restart_.real_schur;
+        Eigen::Map<Matrix> U_h(restart_.real_accumulated, m, m);
+        if (hessenberg) {U_h.setIdentity();}
+        else {hessenbergReduce(H_m, U_h, restart_.cosines);} // H_m is a scratch copy
+        schur.computeFromHessenberg(H_m, U_h, true);
+        const Matrix& T = schur.matrixT();
+        const Matrix& U = schur.matrixU();
+        ComplexType* values = restart_.shifts;
+        quasiTriangularEigenvalues(T, values);
+        std::iota(ritz_order_, ritz_order_ + m, size_t(0));
+        std::partial_sort(ritz_order_, ritz_order_ + nev, ritz_order_ + m,
+                          [values](size_t a, size_t b) {return magnitude(values[a]) > magnitude(values[b]);});
+
+        size_t converged = 0;
+        if (worst) {*worst = 0;}
+        ComplexType* z = ritz_vector_;
+        for (size_t p = 0; p < nev; ++p) {
+            const Eigen::Index i = ritz_order_[p];
+            const ComplexType lambda = values[i];
+            const HostPrecision smin = std::max(std::numeric_limits<HostPrecision>::epsilon() * std::abs(lambda),
+                                                std::numeric_limits<HostPrecision>::min());
+            Eigen::Index b = i, end = i + 1;
+            if (i > 0 && T(i, i - 1) != 0) {b = i - 1;}
+            else if (i + 1 < m && T(i + 1, i) != 0) {end = i + 2;}
+            if (end - b == 1) {z[b] = 1;}
+            else {end = b + 2; z[b] = T(b, b + 1); z[b + 1] = lambda - T(b, b);}
+            for (Eigen::Index r = b - 1; r >= 0;) {
+                const Eigen::Index top = r > 0 && T(r, r - 1) != 0 ? r - 1 : r;
+                ComplexType acc[2] = {0, 0};
+                for (Eigen::Index l = r + 1; l < end; ++l) {
+                    acc[0] += T(top, l) * z[l];
+                    if (top < r) {acc[1] += T(r, l) * z[l];}
+                }
+                if (top == r) {
+                    ComplexType d = T(r, r) - lambda;
+                    if (std::abs(d) < smin) {d = smin;}
+                    z[r] = -acc[0] / d;
+                } else {
+                    const ComplexType a = T(top, top) - lambda, d = T(r, r) - lambda;
+                    ComplexType det = a * d - T(top, r) * T(r, top);
+                    if (std::abs(det) < smin) {det = smin;}
+                    z[top] = (T(top, r) * acc[1] - d * acc[0]) / det;
+                    z[r] = (T(r, top) * acc[0] - a * acc[1]) / det;
+                }
+                r = top - 1;
+            }
+            HostPrecision norm = 0;
+            ComplexType last = 0;
+            for (Eigen::Index l = 0; l < end; ++l) {
+                norm += std::norm(z[l]);
+                last += U(m - 1, l) * z[l];
+            }
+            const HostPrecision estimate = beta * std::abs(last) / std::sqrt(norm);
+            converged += (estimate < tol);
+            if (worst) {*worst = std::max(*worst, estimate);}
+        }
+        return converged;
+    }
+
+    // Adaptive precision (adaptive.hpp). Dense matrices are applied through a float copy kept by the solver and re-rounded
+    // in place each solve, operators through their single-precision apply. Returns the cycles used and leaves the
+    // promoted start vector in Q.col(0)
+    template <typename M>
+    size_t singlePrecisionCycles(const M& M_, typename BK::BlasHandle& handle, Eigen::Map<OM>& Q, Eigen::Map<OM>& H_tilde,
+                                 Eigen::Map<OM>& Q_block, Eigen::Map<OM>& H_square, HostPrecision* norms, size_t max_cycles,
+                                 size_t nev, HostPrecision matnorm, KrylovStats& st) {
+        if constexpr (std::is_same_v<SingleScalar<S>, S> || !BK::HOST_RESIDENT) {
+            return 0; // Already single precision, or not a host backend (rejected by solve)
+        } else if constexpr (!is_linear_operator_v<M>) {
+            // Real storage for a real matrix, even in a complex basis
+            auto& copy = [this]() -> auto& {
+                if constexpr (is_complex_v<typename M::Scalar>) {return f_complex_copy_;}
+                else {return f_real_copy_;}
+            }();
+            copy.assign(M_);
+            copy.setNumThreads(handle.num_threads);
+            return singlePrecisionCycles(copy, handle, Q, H_tilde, Q_block, H_square, norms, max_cycles, nev, matnorm, st);
+        } else if constexpr (!std::is_same_v<typename M::Scalar, SingleScalar<S>>) {
+            if constexpr (SinglePrecisionOperator<M, S>) {
+                return singlePrecisionCycles(SinglePrecisionView<M, S>(M_), handle, Q, H_tilde, Q_block, H_square, norms, max_cycles, nev,
+                                             matnorm, st);
+            } else {
+                throw std::invalid_argument("Adaptive precision needs a dense matrix or an operator with a single-precision apply");
+            }
+        } else {
+            // Krylov-Schur cycles on the float basis. The restart runs on a virtual basis W = I_{B+1} carved from Q, so it
+            // only computes the transformation, then the float basis takes it in one N x B x k gemm
+            using FS = SingleScalar<S>;
+            using FOM = Eigen::Matrix<FS, Eigen::Dynamic, Eigen::Dynamic>;
+            const size_t N = M_.rows(), B = config_.basis_size, C = config_.restart_size;
+            const bool verbose = config_.verbose;
+            ensure(f_evecs_, N * (B + 1));
+            ensure(f_h_, (B + 1) * B);
+            ensure(f_y_, N);
+            ensure(f_result_, N);
+            ensure(f_work_, B + 1);
+            ensure(f_block_, N * B);
+            ensure(f_transform_, B * B);
+            Eigen::Map<FOM> Qf(f_evecs_.ptr, N, B + 1);
+            Eigen::Map<FOM> Hf(f_h_.ptr, B + 1, B);
+            Eigen::Map<OM> W(Q.data(), B + 1, B + 1);
+            Eigen::Map<OM> W_block(Q_block.data(), B + 1, B);
+            const FS one = getOne<FS>(), zero = getZero<FS>();
+
+            Qf.col(0) = Q.col(0).template cast<FS>();
+            Hf.setZero();
+            size_t m = 1, restart_cols = C, locked = 0, cycles = 0;
+            HostPrecision previous = std::numeric_limits<HostPrecision>::infinity();
+            for (; cycles < max_cycles; ++cycles) {
+                if (cycle_hook_) {cycle_hook_(cycles);}
+                const size_t first = cycles == 0 ? 0 : restart_cols;
+                if (cycles > 0) {
+                    Qf.rightCols(B - restart_cols).setZero();
+                    Hf.leftCols(restart_cols) = H_tilde.leftCols(restart_cols).template cast<FS>();
+                    Hf.rightCols(B - restart_cols).setZero();
+                }
+                m = KrylovIterDynamic<M, FS, BK>(M_, nullptr, f_y_.ptr, f_result_.ptr, f_evecs_.ptr, f_h_.ptr, norms, 0, N, N, B, first,
+                                                 handle, matnorm, config_.breakdown_tol, config_.orthogonalization, f_work_.ptr, &st);
+                st.matvecs += m - first;
+                st.matrix_passes += m - first;
+                st.single_precision_cycles++;
+                // Restarted columns keep their HostPrecision values, only the new ones come from the float recurrence
+                H_tilde.rightCols(B - first) = Hf.rightCols(B - first).template cast<S>();
+                for (size_t j = first; j < B; ++j) {H_tilde(j + 1, j) = norms[j];}
+
+                HostPrecision worst = 0;
+                H_square.topLeftCorner(m, m) = H_tilde.topLeftCorner(m, m);
+                convergedPairs(H_square.topLeftCorner(m, m), std::abs(H_tilde(m, m - 1)), cycles == 0, nev, 0, &worst);
+                const HostPrecision level = worst / (SINGLE_EPS * matnorm);
+                if (verbose) {std::cout << "Single-precision cycle " << cycles << ", worst residual estimate " << level << " eps ||A||" << std::endl;}
+                // Invariant subspace: a later cycle promotes the Schur vectors kept by the last restart, the first one gives up
+                if (m < B) {
+                    if (cycles == 0) {return 0;}
+                    ++cycles;
+                    break;
+                }
+
+                // Ordered Schur form on W even when promoting, its leading columns are the wanted Schur vectors
+                W.setIdentity();
+                restart_cols = krylovSchurRestart<OM, BK>(W, H_tilde, B + 1, B, C, handle, W_block, H_square, restart_, locked, 0, verbose);
+                Eigen::Map<FOM> T(f_transform_.ptr, B, restart_cols);
+                T = W.topLeftCorner(B, restart_cols).template cast<FS>();
+                BK::template gemm<FS>(handle, BlasOp::N, BlasOp::N, N, restart_cols, B, &one, Qf.data(), N, T.data(), B, &zero,
+                                      f_block_.ptr, N);
+                Qf.col(restart_cols) = Qf.col(B);
+                Qf.leftCols(restart_cols) = Eigen::Map<FOM>(f_block_.ptr, N, restart_cols);
+                st.restarts++;
+                const bool stalled = level < ADAPTIVE_STALL_LEVEL && worst > ADAPTIVE_STALL_RATIO * previous;
+                previous = worst;
+                if (level < ADAPTIVE_PROMOTE_LEVEL || stalled) {++cycles; break;}
+            }
+            if (cycles == 0) {return 0;}
+            // Start vector with a component along each wanted Schur vector, accumulated in HostPrecision
+            const size_t wanted = std::min(nev, restart_cols);
+            Q.col(0).setZero();
+            for (size_t j = 0; j < wanted; ++j) {Q.col(0) += Qf.col(j).template cast<S>();}
+            Q.col(0).normalize();
+            if (verbose) {std::cout << "Promoted to full precision after " << cycles << " single-precision cycles" << std::endl;}
+            return cycles;
+        }
+    }
+
+    template <typename T>
+    struct Buffer {
+        T* ptr = nullptr;
+        size_t size = 0;
+    };
+
+    template <typename T>
+    void ensure(Buffer<T>& buf, size_t elems) {
+        if (elems <= buf.size) {return;}
+        BK::free(buf.ptr);
+        buf.ptr = BK::template malloc<T>(elems * sizeof(T));
+        buf.size = elems;
+        allocations_++;
+    }
 
-    // Free device memory
-    cudaFree(d_evecs);
-    cudaFree(d_proj);
-    cudaFree(d_y);
-    cudaFree(d_M);
-    cudaFree(d_result);
-    cudaFree(d_h);
+    void release() {
+        for (Buffer<DS>* b : {&d_evecs_, &d_y_, &d_result_, &d_h_, &d_work_, &d_coeffs_, &d_M_}) {BK::free(b->ptr); *b = {};}
+        for (Buffer<FS>* b : {&f_evecs_, &f_h_, &f_y_, &f_result_, &f_work_, &f_block_, &f_transform_}) {BK::free(b->ptr); *b = {};}
+    }
 
-    ComplexEigenPairs ritzPairs{};
-    hessEigSolver<ComplexMatrix>(H_tilde.block(0,0,C, C), ritzPairs, C);
-    // std::cout << ritzPairs.vectors.cols() << " " << ritzPairs.vectors.rows() << std::endl;
-    // std::cout << Q.leftCols(C) << std::endl;
-    return {ritzPairs.values, Q.leftCols(C) * ritzPairs.vectors, C};
+    SolverConfig config_;
+    size_t allocations_ = 0;
 
+    // Backend workspaces
+    Buffer<DS> d_evecs_, d_y_, d_result_, d_h_, d_work_, d_coeffs_, d_M_; // d_work_: CGS2 corrections, d_coeffs_: s-step panel projections
+    // Adaptive precision: the single-precision basis and its scratch, allocated by the first adaptive solve
+    using FS = SingleScalar<S>;
+    Buffer<FS> f_evecs_, f_h_, f_y_, f_result_, f_work_, f_block_, f_transform_;
+    ReducedMatrix<float, HostPrecision> f_real_copy_; // Float copy of a dense matrix, storage reused by later solves
+    ReducedMatrix<float, ComplexType> f_complex_copy_;
+    // Host workspaces, carved from the arena at the start of every solve
+    WorkspaceArena arena_;
+    RestartWorkspace restart_;
+    ComplexType* ritz_vector_ = nullptr;
+    size_t* ritz_order_ = nullptr;
+    CycleHook cycle_hook_;
+    std::unique_ptr<WorkerPool> pool_; // Pipelined matvec lane, started by the first pipelined solve
+};
 
+template <typename M, size_t N, size_t A, size_t B, size_t C, typename BK = DefaultBackend> //A is max iters, B is basis size, C is restart size
+ComplexEigenPairs IRAM(const M& M_, typename BK::BlasHandle& handle, typename BK::SolverHandle& solver_handle, const HostPrecision& tol = default_tol,
+                       RestartMethod restart = RestartMethod::SHIFTED_QR, KrylovStats* stats = nullptr, bool verbose = false) {
+    IRAMSolver<typename BasisTraits<M>::S, BK> solver({.rows = N, .max_iters = A, .basis_size = B, .restart_size = C,
+                                                       .num_pairs = C, .tol = tol, .verbose = verbose, .restart = restart});
+    return solver.solve(M_, handle, solver_handle, stats);
 }
 
 
-#endif //IRAM_HPP
\ No newline at end of file
+#endif //IRAM_HPP
@@ -0,0 +1,50 @@
+// Adaptive precision. The first restart cycles only have to find the wanted invariant subspace roughly, so IRAMSolver
+// can run them on a single-precision basis (SolverConfig::adaptive_precision): the matvec, the Gram-Schmidt sweeps and
+// the basis update stream half the bytes, at twice the SIMD width. The projected matrix and the restart stay in
+// HostPrecision. Once the wanted residual estimates reach a few dozen float rounding units of ||A||, the float relation
+// A Q = Q H + E with ||E|| ~ eps_float ||A|| cannot take the true residuals further. The wanted Schur vectors are then
+// promoted into one HostPrecision start vector and the remaining cycles run in full precision. A restart from one vector
+// is used rather than promoting the whole basis, because a promoted basis would carry E into every later cycle and cap
+// the residuals at float accuracy. The full-precision phase still has to take the residuals from ~1e-5 to the tolerance,
+// so the saving is the share of cycles spent in float, at about half their cost each.
+#ifndef ADAPTIVE_HPP
+#define ADAPTIVE_HPP
+
+#include <limits>
+#include "operator.hpp"
+#include "precision.hpp"
+
+// Promotion thresholds, worst wanted residual estimate in units of eps_float ||A||. The estimates come from the projected
+// matrix and keep falling below the float floor, so the level decides, the stall test only catches true stagnation
+constexpr HostPrecision ADAPTIVE_PROMOTE_LEVEL = 64;  // Promote once every estimate is below this
+constexpr HostPrecision ADAPTIVE_STALL_LEVEL = 1024;  // Below this, also promote when a cycle improves the worst estimate
+constexpr HostPrecision ADAPTIVE_STALL_RATIO = 0.9;   // by less than this factor
+
+constexpr HostPrecision SINGLE_EPS = std::numeric_limits<float>::epsilon();
+
+// Operators that can also apply themselves to a single-precision S basis, such as ReducedMatrix. S defaults to the
+// operator scalar, a real ReducedMatrix also serves a complex basis
+template <typename Op, typename S = typename Op::Scalar>
+concept SinglePrecisionOperator = LinearOperator<Op> && requires(const Op& op, const SingleScalar<S>* x, SingleScalar<S>* y) {
+    { op.apply(x, y) };
+};
+
+// The single-precision face of such an operator, a LinearOperator on SingleScalar<S> vectors
+template <typename Op, typename S = typename Op::Scalar>
+    requires SinglePrecisionOperator<Op, S>
+class SinglePrecisionView {
+public:
+    using Scalar = SingleScalar<S>;
+
+    explicit SinglePrecisionView(const Op& op) : op_(op) {}
+
+    inline size_t rows() const { return op_.rows(); }
+    inline size_t cols() const { return op_.cols(); }
+    inline HostPrecision norm() const { return operatorNorm(op_); }
+    inline void apply(const Scalar* x, Scalar* y) const { op_.apply(x, y); }
+
+private:
+    const Op& op_;
+};
+
+#endif // ADAPTIVE_HPP
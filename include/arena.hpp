@@ -0,0 +1,124 @@
+// Host scratch arena. One 64-byte aligned block (optionally backed by transparent huge pages) that solvers carve their
+// workspaces out of with a bump pointer. Carving never touches the heap; a request past the block spills to a side
+// allocation, and the next reset() folds every spill into a single block of the high-water size, so after one warm-up
+// cycle a solver runs without heap traffic.
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "cpu_manager.hpp"
+
+class WorkspaceArena {
+public:
+    static constexpr size_t ALIGNMENT = CPU_ALIGNMENT;
+    static constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+    explicit WorkspaceArena(size_t bytes = 0, bool huge_pages = false) : huge_pages_(huge_pages) {
+        if (bytes) {grow(bytes);}
+    }
+    WorkspaceArena(const WorkspaceArena&) = delete;
+    WorkspaceArena& operator=(const WorkspaceArena&) = delete;
+    ~WorkspaceArena() {
+        releaseSpills();
+        releaseBlock();
+    }
+
+    inline size_t capacity() const { return capacity_; }
+    inline size_t used() const { return offset_; }
+    inline size_t highWater() const { return high_water_; }
+    inline size_t blockAllocations() const { return block_allocations_; } // Heap/mmap calls made by the arena so far
+    inline bool hugePages() const { return huge_pages_; }
+
+    // Bytes an allocate<T>(elems) call consumes, for sizing reserve() up front
+    template <typename T>
+    static inline size_t footprint(size_t elems) { return padded(elems * sizeof(T)); }
+
+    // Grows the block to at least bytes. Only legal while nothing is carved, every pointer handed out so far dies
+    void reserve(size_t bytes) {
+        assert(offset_ == 0 && spills_.empty() && "WorkspaceArena::reserve called with live allocations");
+        if (bytes > capacity_) {grow(bytes);}
+    }
+
+    // Uninitialized, ALIGNMENT-aligned storage for elems values, valid until the next reset()
+    template <typename T>
+    T* allocate(size_t elems) {
+        static_assert(alignof(T) <= ALIGNMENT, "WorkspaceArena cannot align beyond a cache line.");
+        const size_t bytes = padded(elems * sizeof(T));
+        high_water_ = std::max(high_water_, offset_ + spilled_ + bytes);
+        if (offset_ + bytes <= capacity_) {
+            T* ptr = reinterpret_cast<T*>(base_ + offset_);
+            offset_ += bytes;
+            return ptr;
+        }
+        // Past the block: a side allocation keeps earlier pointers valid, reset() folds it back in
+        T* ptr = cpuMallocChecked<T>(bytes);
+        spills_.push_back(ptr);
+        spilled_ += bytes;
+        block_allocations_++;
+        return ptr;
+    }
+
+    // Hands the whole block back. A cycle that spilled regrows the block to its high-water mark here
+    void reset() {
+        offset_ = 0;
+        if (!spills_.empty()) {
+            releaseSpills();
+            grow(high_water_);
+        }
+    }
+
+private:
+    static inline size_t padded(size_t bytes) { return ((bytes + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT; }
+
+    void grow(size_t bytes) {
+        releaseBlock();
+        bytes = padded(bytes);
+        if (huge_pages_) {
+            // Over-map by one huge page so the usable range starts on a 2 MB boundary THP can back
+            mapped_bytes_ = ((bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES + 1) * HUGE_PAGE_BYTES;
+            void* map = ::mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (map == MAP_FAILED) {throw CpuError("mmap failed for " + std::to_string(mapped_bytes_) + " byte arena");}
+            mapping_ = static_cast<char*>(map);
+            const uintptr_t aligned = (reinterpret_cast<uintptr_t>(mapping_) + HUGE_PAGE_BYTES - 1) & ~(uintptr_t(HUGE_PAGE_BYTES) - 1);
+            base_ = reinterpret_cast<char*>(aligned);
+            ::madvise(base_, mapped_bytes_ - (base_ - mapping_), MADV_HUGEPAGE); // Advisory, kernels without THP ignore it
+        } else {
+            base_ = cpuMallocChecked<char>(bytes);
+        }
+        capacity_ = bytes;
+        block_allocations_++;
+    }
+
+    void releaseBlock() {
+        if (mapping_) {::munmap(mapping_, mapped_bytes_);}
+        else {cpuFreeChecked(base_);}
+        base_ = mapping_ = nullptr;
+        capacity_ = mapped_bytes_ = 0;
+    }
+
+    void releaseSpills() {
+        for (void* p : spills_) {cpuFreeChecked(p);}
+        spills_.clear();
+        spilled_ = 0;
+    }
+
+    bool huge_pages_;
+    char* base_ = nullptr;
+    char* mapping_ = nullptr; // Non-null only for huge page blocks
+    size_t mapped_bytes_ = 0;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    size_t high_water_ = 0;
+    size_t spilled_ = 0;
+    size_t block_allocations_ = 0;
+    std::vector<void*> spills_;
+};
+
+#endif // ARENA_HPP
@@ -6,7 +6,8 @@
 #include <iostream>
 #include <vector>
 #include "matmul.hpp"
-#include "cuda_manager.hpp"
+#include "operator.hpp"
+#include "backend.hpp"
 #include "vector.hpp"
 #include "eigenSolver.hpp"
 
@@ -36,6 +37,9 @@ struct BasisTraits<M, std::enable_if_t<std::is_same_v<typename M::Scalar, Comple
     constexpr static size_t ALLOC_SIZE = sizeof(DS);
 };
 
+// Host scalar of a backend basis: the basis scalar rather than the operator's, a real matrix may run in a complex basis
+template <typename DS>
+using BasisScalar = std::conditional_t<std::is_same_v<DS, DevicePrecision>, HostPrecision, ComplexType>;
 
 template <typename S>
 struct KrylovPair {
@@ -45,45 +49,115 @@ struct KrylovPair {
     size_t m;
 };
 
-// Internal Logic on Mem Buffers, only possible Memcpy is with matmul. Will handle the small size adequately later but this is as optimal as possible for batched matmuls
-template <typename M, typename DS, size_t N, size_t L, size_t num_iters, size_t first_ind = 0>
-int KrylovIterInternal(const M& M_, DS* d_M, DS* d_y, DS* d_result, DS* d_evecs, DS* d_h, Vector& norms, const size_t& ROWS, cublasHandle_t& handle, const HostPrecision& matnorm = 1, const HostPrecision& tol = 1e-5) {
-        size_t m = 1;
-        constexpr size_t ALLOC_SIZE = BasisTraits<M>::ALLOC_SIZE;
-        for (int i = 0; i < num_iters - first_ind; i++) {
-        matmul_internal<M, DS>(M_, d_M, d_y, d_result, ROWS, N, L, handle);
-
-        cublas::MGS<DS>(handle, d_evecs, d_h, d_result, N, num_iters, i + first_ind);;
-        cublas::norm<DS>(handle, L, d_result, 1, &norms[i]);
-        DevicePrecision inv_eval = 1.0 / norms[i];
-        cublas::scale<DS>(handle, N, &inv_eval, d_result, 1);
+// How each new Krylov vector is orthogonalized against the basis
+enum class Orthogonalization {
+    MGS, // Modified Gram-Schmidt, two length-N kernels per basis vector
+    CGS2 // Classical Gram-Schmidt as two gemv sweeps, DGKS second pass only when the norm drops (BK::CGS2)
+};
 
-        //Device to Device Memcpys
-        cudaMemcpyChecked(&d_evecs[(first_ind + i + 1) * N], d_result, N * ALLOC_SIZE, cudaMemcpyDeviceToDevice);
-        cudaMemcpyChecked(d_y, d_result, N * ALLOC_SIZE, cudaMemcpyDeviceToDevice);
+// Convergence bookkeeping filled by the solvers that take a KrylovStats* (nullptr := not collected)
+struct KrylovStats {
+    size_t restarts = 0;
+    size_t matvecs = 0;       // Single-vector operator applications
+    size_t matrix_passes = 0; // Sweeps over the operator, a block matvec of p vectors is one pass
+    size_t converged = 0;
+    size_t locked = 0;        // Converged pairs deflated out of the active basis (Krylov-Schur locking)
+    size_t reorthogonalizations = 0; // DGKS second passes (CGS2 only)
+    size_t reductions = 0;    // Global reductions (dot products, norms, Q^H w products) in the basis expansion
+    size_t s_step_fallbacks = 0; // s-step blocks rejected for conditioning and redone with standard Arnoldi steps
+    size_t pipeline_refreshes = 0; // Pipelined steps whose A q came from a direct matvec instead of the recurrence
+    size_t single_precision_cycles = 0; // Adaptive precision: restart cycles run on the single-precision basis
+    HostPrecision orthogonality_loss = 0; // ||I - Q^H Q||_F of the final basis
+    Vector residuals;         // ||A x_i - lambda_i x_i|| estimates of the returned pairs
+
+    inline HostPrecision passesPerConvergedPair() const {
+        return converged ? static_cast<HostPrecision>(matrix_passes) / converged : static_cast<HostPrecision>(matrix_passes);
+    }
+};
 
-        if (norms[i] < tol * matnorm) {
-            m++;
-            break;
+inline std::ostream& operator<<(std::ostream& os, const KrylovStats& s) {
+    os << "restarts " << s.restarts << ", matvecs " << s.matvecs << ", matrix passes " << s.matrix_passes
+       << ", converged " << s.converged << " (" << s.passesPerConvergedPair() << " passes/pair)";
+    return os;
+}
+
+// ||I - Q^H Q||_F, the loss of orthogonality of a basis
+template <typename OM>
+inline HostPrecision orthogonalityLoss(const Eigen::Ref<const OM>& Q) {
+    return (OM::Identity(Q.cols(), Q.cols()) - Q.adjoint() * Q).norm();
+}
+
+// One Arnoldi step from q_j (column j of d_evecs): column j + 1 receives q_{j+1}, column j of d_h its projections and
+// the return value is h_{j+1,j}. For square operators the matvec reads q_j from the basis and CGS2 runs fused in place
+// (BK::orthonormalize); otherwise A q_j goes through d_result, and d_y carries the input when N != L
+template <typename M, typename DS, typename BK = DefaultBackend>
+HostPrecision arnoldiStep(const M& M_, DS* d_M, DS* d_y, DS* d_result, DS* d_evecs, DS* d_h, const size_t& ROWS, size_t N, size_t L,
+                          size_t num_iters, size_t j, typename BK::BlasHandle& handle, Orthogonalization orth, DS* d_work,
+                          KrylovStats* stats) {
+    constexpr size_t ALLOC_SIZE = sizeof(DS);
+    DS* q = d_evecs + j * N;
+    bool again = false;
+    HostPrecision h_next = 0;
+    if (orth == Orthogonalization::CGS2 && N == L) {
+        assert(d_work && "CGS2 needs num_iters + 1 scalars of backend scratch");
+        applyOperator<M, DS, BK>(M_, d_M, q, q + N, ROWS, N, L, handle);
+        h_next = BK::template orthonormalize<DS>(handle, d_evecs, d_h, d_work, N, num_iters, j, &again);
+        if (stats) {stats->reductions += 1 + again;}
+    } else {
+        applyOperator<M, DS, BK>(M_, d_M, N == L ? q : d_y, d_result, ROWS, N, L, handle);
+        if (orth == Orthogonalization::CGS2) {
+            assert(d_work && "CGS2 needs num_iters + 1 scalars of backend scratch");
+            h_next = BK::template CGS2<DS>(handle, d_evecs, d_h, d_result, d_work, N, num_iters, j, &again);
+            if (stats) {stats->reductions += 3 + again * 2;}
         } else {
-            m++;
+            BK::template MGS<DS>(handle, d_evecs, d_h, d_result, N, num_iters, j);
+            BK::template norm<DS>(handle, L, d_result, 1, &h_next);
+            if (stats) {stats->reductions += j + 2;}
         }
+        DevicePrecision inv_eval = 1.0 / h_next;
+        BK::template scale<DS>(handle, N, &inv_eval, d_result, 1);
+
+        //Device to Device Memcpys
+        BK::memcpy(q + N, d_result, N * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+        if (N != L) {BK::memcpy(d_y, d_result, N * ALLOC_SIZE, MemcpyKind::DeviceToDevice);}
     }
+    if (stats) {stats->reorthogonalizations += again;}
+    return h_next;
+}
 
-    m -= 1;
+// M is either a dense Eigen matrix or a LinearOperator (operator.hpp)
+// Internal Logic on Mem Buffers, only possible Memcpy is with matmul. Will handle the small size adequately later but this is as optimal as possible for batched matmuls
+// Runtime-sized core, columns first_ind + 1 .. num_iters of d_evecs are produced. d_h has leading dimension num_iters + 1
+template <typename M, typename DS, typename BK = DefaultBackend>
+int KrylovIterDynamic(const M& M_, DS* d_M, DS* d_y, DS* d_result, DS* d_evecs, DS* d_h, HostPrecision* norms, const size_t& ROWS,
+                      size_t N, size_t L, size_t num_iters, size_t first_ind, typename BK::BlasHandle& handle,
+                      const HostPrecision& matnorm = 1, const HostPrecision& tol = 1e-5,
+                      Orthogonalization orth = Orthogonalization::MGS, DS* d_work = nullptr, KrylovStats* stats = nullptr) {
+    for (size_t j = first_ind; j < num_iters; ++j) {
+        // Indexed by basis column so restarts keep H's subdiagonal aligned
+        norms[j] = arnoldiStep<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, ROWS, N, L, num_iters, j, handle, orth, d_work, stats);
+        if (norms[j] < tol * matnorm) {return static_cast<int>(j + 1);}
+    }
+    return static_cast<int>(num_iters); // Complete Hessenberg columns, < num_iters only on breakdown
+}
 
-    return 0;
+template <typename M, typename DS, size_t N, size_t L, size_t num_iters, size_t first_ind = 0, typename BK = DefaultBackend>
+int KrylovIterInternal(const M& M_, DS* d_M, DS* d_y, DS* d_result, DS* d_evecs, DS* d_h, Vector& norms, const size_t& ROWS, typename BK::BlasHandle& handle, const HostPrecision& matnorm = 1, const HostPrecision& tol = 1e-5) {
+    return KrylovIterDynamic<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, norms.data(), ROWS, N, L, num_iters, first_ind, handle, matnorm, tol);
 }
 
 
-template <typename M, size_t N, size_t L, size_t max_iters>
-KrylovPair<typename M::Scalar> KrylovIter(const M& M_, cublasHandle_t& handle, const HostPrecision& tol = default_tol) {
-    using S = typename BasisTraits<M>::S;
+// Runtime-sized Arnoldi factorization A Q_m = Q_{m+1} H_{m+1,m} with N = rows(M), L = cols(M)
+template <typename M, typename BK = DefaultBackend>
+KrylovPair<typename M::Scalar> KrylovIter(const M& M_, typename BK::BlasHandle& handle, size_t max_iters, const HostPrecision& tol = default_tol,
+                                          Orthogonalization orth = Orthogonalization::MGS) {
     using DS = typename BasisTraits<M>::DS;
     using V = typename BasisTraits<M>::V;
     using OM = typename BasisTraits<M>::OM;
     constexpr size_t ALLOC_SIZE = BasisTraits<M>::ALLOC_SIZE;
-    const HostPrecision matnorm = M_.norm();
+    const size_t N = M_.rows();
+    const size_t L = M_.cols();
+    const HostPrecision matnorm = operatorNorm(M_);
 
     OM Q(N, max_iters + 1);
     OM H_tilde(max_iters + 1, max_iters);
@@ -92,48 +166,55 @@ KrylovPair<typename M::Scalar> KrylovIter(const M& M_, cublasHandle_t& handle, c
     Vector norms(max_iters);
     V v0 = randVecGen<V>(N);
 
-    size_t m = 1;
-    const size_t ROWS = DYNAMIC_ROW_ALLOC(N);
+    const size_t ROWS = is_linear_operator_v<M> ? 0 : BK::rowAlloc(N); // Operators never need the staging buffer
 
-    // CUDA Allocations
-    DS* d_evecs = cudaMallocChecked<DS>((max_iters + 1) * N * ALLOC_SIZE);
-    DS* d_proj = cudaMallocChecked<DS>((max_iters + 1) * ALLOC_SIZE);
-    DS* d_y = cudaMallocChecked<DS>(N * ALLOC_SIZE);
-    DS* d_M = cudaMallocChecked<DS>(ROWS * N * ALLOC_SIZE);
-    DS* d_result = cudaMallocChecked<DS>(N * ALLOC_SIZE);
-    DS* d_h = cudaMallocChecked<DS>((max_iters + 1) * max_iters * ALLOC_SIZE);
+    // Backend Allocations
+    DS* d_evecs = BK::template malloc<DS>((max_iters + 1) * N * ALLOC_SIZE);
+    DS* d_y = BK::template malloc<DS>(N * ALLOC_SIZE);
+    DS* d_M = BK::template malloc<DS>(ROWS * N * ALLOC_SIZE);
+    DS* d_result = BK::template malloc<DS>(N * ALLOC_SIZE);
+    DS* d_h = BK::template malloc<DS>((max_iters + 1) * max_iters * ALLOC_SIZE);
+    DS* d_work = BK::template malloc<DS>((max_iters + 1) * ALLOC_SIZE);
+    BK::memset(d_h, 0, (max_iters + 1) * max_iters * ALLOC_SIZE); // MGS only writes the upper Hessenberg part of each column
 
     // Initial setup
-    cudaMemcpyChecked(d_y, v0.data(), N * ALLOC_SIZE, cudaMemcpyHostToDevice);
-    cudaMemcpyChecked(d_evecs, v0.data(), N * ALLOC_SIZE, cudaMemcpyHostToDevice);
+    BK::memcpy(d_y, v0.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
+    BK::memcpy(d_evecs, v0.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
 
-    KrylovIterInternal<M, DS, N, L, max_iters>(M_, d_M, d_y, d_result, d_evecs, d_h, norms, ROWS, handle, matnorm, tol);
+    // m < max_iters only on breakdown, then Q_m spans an invariant subspace and H_m is all that is meaningful
+    const size_t m = KrylovIterDynamic<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, norms.data(), ROWS, N, L, max_iters, 0,
+                                                  handle, matnorm, tol, orth, d_work);
 
-    cudaMemcpyChecked(Q.data(), d_evecs, (max_iters + 1) * N * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-    cudaMemcpyChecked(H_tilde.data(), d_h, (max_iters + 1) * m * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-    for (int j = 0; j < max_iters; ++j) { H_tilde(j + 1, j) = norms[j]; } // Insert norms back into Hessenberg diagonal
+    BK::memcpy(Q.data(), d_evecs, (max_iters + 1) * N * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+    BK::memcpy(H_tilde.data(), d_h, (max_iters + 1) * max_iters * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+    for (size_t j = 0; j < m; ++j) { H_tilde(j + 1, j) = norms[j]; } // Insert norms back into Hessenberg diagonal
 
-    
-    assert(isOrthonormal<OM>(Q.block(0,0,N,max_iters)));
-    assert(isHessenberg<OM>(H_tilde.block(0,0,m, max_iters)));
+    assert(isOrthonormal<OM>(Q.block(0,0,N,m)));
+    assert(isHessenberg<OM>(H_tilde.block(0,0,m + 1,m)));
 
     // Free device memory
-    cudaFree(d_evecs);
-    cudaFree(d_proj);
-    cudaFree(d_y);
-    cudaFree(d_M);
-    cudaFree(d_result);
-    cudaFree(d_h);
-
-    return {Q, H_tilde, max_iters};
+    BK::free(d_evecs);
+    BK::free(d_y);
+    BK::free(d_M);
+    BK::free(d_result);
+    BK::free(d_h);
+    BK::free(d_work);
+
+    return {Q, H_tilde, m};
 }
 
-template <typename M, size_t N, size_t L, size_t max_iters>
-ComplexEigenPairs NaiveArnoldi(const M& M_, cublasHandle_t& handle, const HostPrecision& tol = 1e-5) {
+template <typename M, size_t N, size_t L, size_t max_iters, typename BK = DefaultBackend>
+KrylovPair<typename M::Scalar> KrylovIter(const M& M_, typename BK::BlasHandle& handle, const HostPrecision& tol = default_tol) {
+    return KrylovIter<M, BK>(M_, handle, max_iters, tol);
+}
+
+template <typename M, typename BK = DefaultBackend>
+ComplexEigenPairs NaiveArnoldi(const M& M_, typename BK::BlasHandle& handle, size_t max_iters, const HostPrecision& tol = 1e-5) {
     using OM = typename BasisTraits<M>::OM;
+    const size_t N = M_.rows();
 
     // Step 1: Perform Arnoldi iteration to get Q and H_tilde
-    KrylovPair<typename M::Scalar> krylovResult = KrylovIter<M, N, L, max_iters>(M_, handle);
+    KrylovPair<typename M::Scalar> krylovResult = KrylovIter<M, BK>(M_, handle, max_iters, tol);
     const size_t& m = krylovResult.m;
     const OM& Q = krylovResult.Q.block(0, 0, N, m);
     const OM& H_square = krylovResult.H.block(0, 0, m, m);
@@ -144,7 +225,14 @@ ComplexEigenPairs NaiveArnoldi(const M& M_, cublasHandle_t& handle, const HostPr
     const ComplexVector& eigenvalues = H_eigensolution.values;
     const ComplexMatrix& H_EigenVectors = H_eigensolution.vectors;
 
-    return {eigenvalues, Q * H_EigenVectors, m};
+    ComplexMatrix ritzVectors = Q * H_EigenVectors;
+    restoreOrder(M_, ritzVectors);
+    return {eigenvalues, ritzVectors, m};
+}
+
+template <typename M, size_t N, size_t L, size_t max_iters, typename BK = DefaultBackend>
+ComplexEigenPairs NaiveArnoldi(const M& M_, typename BK::BlasHandle& handle, const HostPrecision& tol = 1e-5) {
+    return NaiveArnoldi<M, BK>(M_, handle, max_iters, tol);
 }
 
 
@@ -0,0 +1,222 @@
+// Compile-time execution backend policy. Solver templates take a Backend parameter (defaulting to DefaultBackend)
+// and only ever talk to device memory and BLAS through it, so the same Krylov code runs on cuBLAS or on host threads.
+#ifndef BACKEND_HPP
+#define BACKEND_HPP
+
+#include <cstddef>
+#include "vector.hpp"
+#include "cpu_manager.hpp"
+
+#ifdef USE_CUDA
+    #include "cuda_manager.hpp"
+#endif
+
+enum class MemcpyKind : char {
+    HostToDevice = 'H',
+    DeviceToHost = 'D',
+    DeviceToDevice = 'X'
+};
+
+enum class CuRetType {
+    HOST,
+    DEVICE
+};
+
+enum class BlasOp : char {
+    N = 'N',
+    T = 'T',
+    C = 'C'
+};
+
+// ==================== CPU BACKEND ====================
+
+struct CpuBackend {
+    using BlasHandle = cpublas::Handle;
+    using SolverHandle = cpublas::SolverHandle;
+    static constexpr bool HOST_RESIDENT = true; // Operators can be read in place, no staging buffer needed
+
+    static inline void createHandle(BlasHandle& handle) { handle = BlasHandle{}; }
+    static inline void createHandle(SolverHandle& handle) { handle = SolverHandle{}; }
+    static inline void destroyHandle(BlasHandle&) {}
+    static inline void destroyHandle(SolverHandle&) {}
+
+    template <typename T>
+    static inline T* malloc(size_t size) { return cpuMallocChecked<T>(size); }
+    static inline void free(void* ptr) { cpuFreeChecked(ptr); }
+    static inline void memcpy(void* dst, const void* src, size_t count, MemcpyKind) { cpuMemcpyChecked(dst, src, count); }
+    static inline void memset(void* dst, int value, size_t count) { if (count) {std::memset(dst, value, count);} }
+
+    // The whole operator is already resident, no row blocking
+    static inline size_t rowAlloc(const size_t&) { return 0; }
+
+    template <typename T>
+    static inline void gemv(BlasHandle& handle, BlasOp trans, int m, int n, const T* alpha, const T* A, int lda,
+                            const T* x, int incx, const T* beta, T* y, int incy) {
+        cpublas::gemv<T>(handle, static_cast<cpublas::Operation>(trans), m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    // y = alpha * op(A) x + beta * y for a real A under complex x, y (matmul_internal on a real Matrix in a complex basis)
+    template <typename T>
+    static inline void gemvReal(BlasHandle& handle, BlasOp trans, int m, int n, const T* alpha, const DevicePrecision* A, int lda,
+                                const T* x, int incx, const T* beta, T* y, int incy) {
+        cpublas::gemv<T>(handle, static_cast<cpublas::Operation>(trans), m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    template <typename T>
+    static inline void gemm(BlasHandle& handle, BlasOp transA, BlasOp transB, int m, int n, int k, const T* alpha,
+                            const T* A, int lda, const T* B, int ldb, const T* beta, T* C, int ldc) {
+        cpublas::gemm<T>(handle, static_cast<cpublas::Operation>(transA), static_cast<cpublas::Operation>(transB),
+                         m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    template <typename T>
+    static inline void norm(BlasHandle& handle, int N, const T* x, int incx, HostPrecision* result) {
+        cpublas::norm<T>(handle, N, x, incx, result);
+    }
+
+    template <typename T>
+    static inline void scale(BlasHandle& handle, int N, const DevicePrecision* alpha, T* x, int incx) {
+        cpublas::scale<T>(handle, N, alpha, x, incx);
+    }
+
+    template <typename T>
+    static inline void axpy(BlasHandle& handle, int N, const T* alpha, const T* x, int incx, T* y, int incy) {
+        cpublas::axpy(handle, N, *cpublas::host(alpha), cpublas::host(x), incx, cpublas::host(y), incy);
+    }
+
+    template <typename T>
+    static inline void MGS(BlasHandle& handle, const T* d_evecs, T* d_h, T* d_result, int N, int num_iters, int i) {
+        cpublas::MGS<T>(handle, d_evecs, d_h, d_result, N, num_iters, i);
+    }
+
+    template <typename T>
+    static inline HostPrecision CGS2(BlasHandle& handle, const T* d_evecs, T* d_h, T* d_result, T* d_work, int N, int num_iters, int i,
+                                     bool* reorthogonalized = nullptr) {
+        return cpublas::CGS2<T>(handle, d_evecs, d_h, d_result, d_work, N, num_iters, i, reorthogonalized);
+    }
+
+    // CGS2 on column i + 1 of d_evecs, normalized in place into q_{i+1}. Returns h_{i+1,i}
+    template <typename T>
+    static inline HostPrecision orthonormalize(BlasHandle& handle, T* d_evecs, T* d_h, T* d_work, int N, int num_iters, int i,
+                                               bool* reorthogonalized = nullptr) {
+        return cpublas::orthonormalize<T>(handle, d_evecs, d_h, d_work, N, num_iters, i, reorthogonalized);
+    }
+
+    // Pipelined step finish: q_{i+1} from column i + 1 and, when advance is set, A q_{i+1} from A u in column i + 2
+    template <typename T>
+    static inline HostPrecision pipelinedOrthonormalize(BlasHandle& handle, T* d_evecs, T* d_h, T* d_work, int N, int num_iters, int i,
+                                                        bool advance, HostPrecision* projected_norm, bool* reorthogonalized,
+                                                        bool* advanced) {
+        return cpublas::pipelinedOrthonormalize<T>(handle, d_evecs, d_h, d_work, N, num_iters, i, advance, projected_norm, reorthogonalized,
+                                                          advanced);
+    }
+};
+
+// ==================== CUDA BACKEND ====================
+
+#ifdef USE_CUDA
+struct CudaBackend {
+    using BlasHandle = cublasHandle_t;
+    using SolverHandle = cusolverDnHandle_t;
+    static constexpr bool HOST_RESIDENT = false;
+
+    static inline void createHandle(BlasHandle& handle) { cublasCreate(&handle); }
+    static inline void createHandle(SolverHandle& handle) { cusolverDnCreate(&handle); }
+    static inline void destroyHandle(BlasHandle& handle) { cublasDestroy(handle); }
+    static inline void destroyHandle(SolverHandle& handle) { cusolverDnDestroy(handle); }
+
+    template <typename T>
+    static inline T* malloc(size_t size) { return cudaMallocChecked<T>(size); }
+    static inline void free(void* ptr) { cudaFree(ptr); }
+    static inline void memset(void* dst, int value, size_t count) { cudaMemset(dst, value, count); }
+
+    static inline void memcpy(void* dst, const void* src, size_t count, MemcpyKind kind) {
+        cudaMemcpyKind cudaKind = cudaMemcpyDeviceToDevice;
+        switch (kind) {
+            case MemcpyKind::HostToDevice: cudaKind = cudaMemcpyHostToDevice; break;
+            case MemcpyKind::DeviceToHost: cudaKind = cudaMemcpyDeviceToHost; break;
+            case MemcpyKind::DeviceToDevice: cudaKind = cudaMemcpyDeviceToDevice; break;
+        }
+        cudaMemcpyChecked(dst, src, count, cudaKind);
+    }
+
+    static inline size_t rowAlloc(const size_t& N) { return DYNAMIC_ROW_ALLOC(N); }
+
+    static inline cublasOperation_t toCublas(BlasOp op) {
+        switch (op) {
+            case BlasOp::T: return CUBLAS_OP_T;
+            case BlasOp::C: return CUBLAS_OP_C;
+            default: return CUBLAS_OP_N;
+        }
+    }
+
+    template <typename T>
+    static inline void gemv(BlasHandle& handle, BlasOp trans, int m, int n, const T* alpha, const T* A, int lda,
+                            const T* x, int incx, const T* beta, T* y, int incy) {
+        cublas::gemv<T>(handle, toCublas(trans), m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    template <typename T>
+    static inline void gemvReal(BlasHandle& handle, BlasOp trans, int m, int n, const T* alpha, const DevicePrecision* A, int lda,
+                                const T* x, int incx, const T* beta, T* y, int incy) {
+        cublas::gemvReal<T>(handle, toCublas(trans), m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    template <typename T>
+    static inline void gemm(BlasHandle& handle, BlasOp transA, BlasOp transB, int m, int n, int k, const T* alpha,
+                            const T* A, int lda, const T* B, int ldb, const T* beta, T* C, int ldc) {
+        cublas::gemm<T>(handle, toCublas(transA), toCublas(transB), m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    template <typename T>
+    static inline void norm(BlasHandle& handle, int N, const T* x, int incx, HostPrecision* result) {
+        cublas::norm<T>(handle, N, x, incx, result);
+    }
+
+    template <typename T>
+    static inline void scale(BlasHandle& handle, int N, const DevicePrecision* alpha, T* x, int incx) {
+        cublas::scale<T>(handle, N, alpha, x, incx);
+    }
+
+    template <typename T>
+    static inline void axpy(BlasHandle& handle, int N, const T* alpha, const T* x, int incx, T* y, int incy) {
+        cublas::axpy<T>(handle, N, alpha, x, incx, y, incy);
+    }
+
+    template <typename T>
+    static inline void MGS(BlasHandle& handle, const T* d_evecs, T* d_h, T* d_result, int N, int num_iters, int i) {
+        cublas::MGS<T>(handle, d_evecs, d_h, d_result, N, num_iters, i);
+    }
+
+    template <typename T>
+    static inline HostPrecision CGS2(BlasHandle& handle, const T* d_evecs, T* d_h, T* d_result, T* d_work, int N, int num_iters, int i,
+                                     bool* reorthogonalized = nullptr) {
+        return cublas::CGS2<T>(handle, d_evecs, d_h, d_result, d_work, N, num_iters, i, reorthogonalized);
+    }
+
+    // CGS2 on column i + 1 of d_evecs, normalized in place into q_{i+1}. Returns h_{i+1,i}
+    template <typename T>
+    static inline HostPrecision orthonormalize(BlasHandle& handle, T* d_evecs, T* d_h, T* d_work, int N, int num_iters, int i,
+                                               bool* reorthogonalized = nullptr) {
+        return cublas::orthonormalize<T>(handle, d_evecs, d_h, d_work, N, num_iters, i, reorthogonalized);
+    }
+
+    // Pipelined step finish: q_{i+1} from column i + 1 and, when advance is set, A q_{i+1} from A u in column i + 2
+    template <typename T>
+    static inline HostPrecision pipelinedOrthonormalize(BlasHandle& handle, T* d_evecs, T* d_h, T* d_work, int N, int num_iters, int i,
+                                                        bool advance, HostPrecision* projected_norm, bool* reorthogonalized,
+                                                        bool* advanced) {
+        return cublas::pipelinedOrthonormalize<T>(handle, d_evecs, d_h, d_work, N, num_iters, i, advance, projected_norm, reorthogonalized,
+                                                          advanced);
+    }
+};
+
+using DefaultBackend = CudaBackend;
+#else
+using DefaultBackend = CpuBackend;
+#endif
+
+using blasHandle_t = DefaultBackend::BlasHandle;
+using solverHandle_t = DefaultBackend::SolverHandle;
+
+#endif // BACKEND_HPP
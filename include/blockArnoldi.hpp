@@ -0,0 +1,158 @@
+// Block Arnoldi with explicit restarts. Each step expands p basis vectors at once: one block matvec (gemm for dense
+// matrices, SpMM for sparse ones) and block classical Gram-Schmidt with reorthogonalization, so each pass over the
+// operator does p vectors' worth of work and eigenvalue clusters up to multiplicity p are resolved together.
+#ifndef BLOCK_ARNOLDI_HPP
+#define BLOCK_ARNOLDI_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include "arnoldi.hpp"
+#include "tsqr.hpp"
+
+struct BlockArnoldiParams {
+    size_t block_size = 4;     // p, vectors expanded per step
+    size_t num_blocks = 10;    // Blocks per cycle, basis holds num_blocks * block_size vectors
+    size_t num_pairs = 10;     // Wanted Ritz pairs, largest magnitude first
+    size_t max_restarts = 100;
+    HostPrecision tol = 1e-8;  // Pair i converged once ||A x_i - lambda_i x_i|| <= tol * max(|lambda_i|, ||A|| eps)
+};
+
+// QR of the p columns in d_W (N x p) by TSQR (tsqr.hpp): the Q factor overwrites d_W and R is returned. Columns whose R
+// diagonal falls below drop_tol (rank-deficient block) are reorthogonalized against the first `cols` columns of d_V
+// before a second factorization, so the basis stays orthonormal when the block loses rank. positive_diagonal gives R a
+// real nonnegative diagonal, as Arnoldi's subdiagonal norms need
+template <typename OM, typename DS, typename BK = DefaultBackend>
+OM blockQR(DS* d_W, const DS* d_V, size_t N, size_t p, size_t cols, HostPrecision drop_tol, DS* d_C, typename BK::BlasHandle& handle,
+           bool positive_diagonal = false) {
+    const DS ONE = getOne<DS>();
+    const DS ZERO = getZero<DS>();
+    const DS NEG_ONE = getNegOne<DS>();
+    constexpr BlasOp ADJ = is_complex_v<typename OM::Scalar> ? BlasOp::C : BlasOp::T;
+
+    OM R = tsqr<OM, DS, BK>(d_W, N, p, handle, positive_diagonal);
+    bool deficient = false;
+    for (size_t i = 0; i < p; ++i) {deficient |= std::abs(R(i, i)) < drop_tol;}
+    if (deficient && cols > 0) {
+        // W = Q R with tiny R_ii, so Q's i-th column is arbitrary: project it off V and refactor, R absorbs the rotation
+        for (int pass = 0; pass < 2; ++pass) {
+            BK::template gemm<DS>(handle, ADJ, BlasOp::N, cols, p, N, &ONE, d_V, N, d_W, N, &ZERO, d_C, cols);
+            BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, p, cols, &NEG_ONE, d_V, N, d_C, cols, &ONE, d_W, N);
+        }
+        const OM R2 = tsqr<OM, DS, BK>(d_W, N, p, handle, positive_diagonal);
+        R = R2 * R;
+    }
+    return R;
+}
+
+template <typename M, typename BK = DefaultBackend>
+ComplexEigenPairs BlockArnoldi(const M& M_, typename BK::BlasHandle& handle, const BlockArnoldiParams& params = {}, KrylovStats* stats = nullptr) {
+    using S = typename BasisTraits<M>::S;
+    using DS = typename BasisTraits<M>::DS;
+    using OM = typename BasisTraits<M>::OM;
+    constexpr size_t ALLOC_SIZE = BasisTraits<M>::ALLOC_SIZE;
+    constexpr BlasOp ADJ = is_complex_v<S> ? BlasOp::C : BlasOp::T;
+
+    const size_t N = M_.rows();
+    const size_t p = params.block_size;
+    const size_t K = params.num_blocks * p;
+    const size_t k = params.num_pairs;
+    if (p == 0 || params.num_blocks == 0 || k > K || K + p > N) {
+        throw std::invalid_argument("BlockArnoldi needs 0 < num_pairs <= num_blocks * block_size < N - block_size, got p = "
+                                    + std::to_string(p) + ", basis " + std::to_string(K) + ", N = " + std::to_string(N));
+    }
+    const HostPrecision matnorm = operatorNorm(M_);
+    const HostPrecision drop_tol = 1e-12 * matnorm;
+    const DS ONE = getOne<DS>();
+    const DS ZERO = getZero<DS>();
+    const DS NEG_ONE = getNegOne<DS>();
+    KrylovStats local_stats;
+    KrylovStats& st = stats ? *stats : local_stats;
+    st = KrylovStats{};
+
+    const size_t ROWS = is_linear_operator_v<M> ? 0 : BK::rowAlloc(N);
+    DS* d_V = BK::template malloc<DS>((K + p) * N * ALLOC_SIZE);
+    DS* d_W = BK::template malloc<DS>(p * N * ALLOC_SIZE);
+    DS* d_C = BK::template malloc<DS>((K + p) * std::max(p, k) * ALLOC_SIZE);
+    DS* d_M = BK::template malloc<DS>(ROWS * N * ALLOC_SIZE);
+
+    // Random orthonormal start block
+    OM V0 = OM::Random(N, p);
+    BK::memcpy(d_W, V0.data(), N * p * ALLOC_SIZE, MemcpyKind::HostToDevice);
+    blockQR<OM, DS, BK>(d_W, d_V, N, p, 0, drop_tol, d_C, handle);
+    BK::memcpy(d_V, d_W, N * p * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+
+    OM H = OM::Zero(K + p, K);
+    OM C(K + p, p);
+    ComplexEigenPairs ritz{};
+    size_t Km = K;
+    Vector residuals(k);
+
+    for (size_t restart = 0; restart <= params.max_restarts; ++restart) {
+        H.setZero();
+        Km = K;
+        for (size_t j = 0; j < params.num_blocks; ++j) {
+            const size_t cols = (j + 1) * p;
+            applyOperatorBlock<M, DS, BK>(M_, d_M, d_V + j * p * N, d_W, ROWS, N, N, p, handle);
+            st.matrix_passes++;
+            st.matvecs += p;
+
+            // Block CGS2: H_j = V^H W, W -= V H_j, twice
+            for (int pass = 0; pass < 2; ++pass) {
+                BK::template gemm<DS>(handle, ADJ, BlasOp::N, cols, p, N, &ONE, d_V, N, d_W, N, &ZERO, d_C, cols);
+                BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, p, cols, &NEG_ONE, d_V, N, d_C, cols, &ONE, d_W, N);
+                BK::memcpy(C.data(), d_C, cols * p * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+                H.block(0, j * p, cols, p) += Eigen::Map<const OM>(C.data(), cols, p);
+            }
+
+            HostPrecision block_norm = 0;
+            BK::template norm<DS>(handle, N * p, d_W, 1, &block_norm);
+            if (block_norm < drop_tol) {Km = cols; break;} // Invariant subspace, the Ritz pairs of H_Km are exact
+
+            H.block(cols, j * p, p, p) = blockQR<OM, DS, BK>(d_W, d_V, N, p, cols, drop_tol, d_C, handle);
+            BK::memcpy(d_V + cols * N, d_W, N * p * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+        }
+
+        // Ritz pairs of the block Hessenberg projection, residual ||H_{m+1,m} E_m^T y_i||
+        const ComplexMatrix H_square = H.topLeftCorner(Km, Km).template cast<ComplexType>();
+        eigSolver<ComplexMatrix>(H_square, ritz, Km);
+        const size_t kk = std::min(k, Km);
+        size_t converged = 0;
+        for (size_t i = 0; i < kk; ++i) {
+            const ComplexVector y = ritz.vectors.col(i) / ritz.vectors.col(i).norm();
+            residuals[i] = Km < K ? 0 : (H.block(Km, Km - p, p, p).template cast<ComplexType>() * y.tail(p)).norm();
+            converged += residuals[i] <= params.tol * std::max(std::abs(ritz.values[i]), matnorm * HostPrecision(1e-14));
+        }
+        st.converged = converged;
+        if (converged == kk || Km < K || restart == params.max_restarts) {break;}
+        st.restarts++;
+
+        // Explicit restart: start block column c sums the wanted Ritz vectors i = c mod p, real part for real bases
+        ComplexMatrix Z = ComplexMatrix::Zero(Km, p);
+        for (size_t i = 0; i < kk; ++i) {Z.col(i % p) += ritz.vectors.col(i) / ritz.vectors.col(i).norm();}
+        for (size_t c = kk; c < p; ++c) {Z.col(c) = ComplexVector::Random(Km);} // Fewer wanted pairs than lanes
+        OM Zb(Km, p);
+        if constexpr (is_complex_v<S>) {Zb = Z;}
+        else {Zb = Z.real();}
+        BK::memcpy(d_C, Zb.data(), Km * p * ALLOC_SIZE, MemcpyKind::HostToDevice);
+        BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, p, Km, &ONE, d_V, N, d_C, Km, &ZERO, d_W, N);
+        blockQR<OM, DS, BK>(d_W, d_V, N, p, 0, drop_tol, d_C, handle);
+        BK::memcpy(d_V, d_W, N * p * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+    }
+
+    const size_t kk = std::min(k, Km);
+    OM V(N, Km);
+    BK::memcpy(V.data(), d_V, N * Km * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+    ComplexMatrix ritzVectors = V.template cast<ComplexType>() * ritz.vectors.leftCols(kk);
+    for (size_t i = 0; i < kk; ++i) {ritzVectors.col(i).normalize();}
+    restoreOrder(M_, ritzVectors);
+    st.residuals = residuals.head(kk);
+
+    BK::free(d_V);
+    BK::free(d_W);
+    BK::free(d_C);
+    BK::free(d_M);
+
+    return {ritz.values.head(kk), ritzVectors, kk};
+}
+
+#endif // BLOCK_ARNOLDI_HPP
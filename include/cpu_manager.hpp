@@ -0,0 +1,658 @@
+#ifndef CPU_MANAGER_HPP
+#define CPU_MANAGER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "vector.hpp"
+
+#ifndef USE_CUDA
+using DeviceComplexType = ComplexType;
+
+template <typename T>
+constexpr T getOne() { return T(1.0); }
+
+template <typename T>
+constexpr T getZero() { return T(0.0); }
+
+template <typename T>
+constexpr T getNegOne() { return T(-1.0); }
+#endif
+
+    class CpuError : public std::runtime_error {
+    public:
+        explicit CpuError(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    constexpr size_t CPU_ALIGNMENT = 64; // Cache line, also covers AVX-512 loads
+
+    template <typename T>
+    inline T* cpuMallocChecked(size_t size) {
+        if (size == 0) {return nullptr;}
+        const size_t padded = ((size + CPU_ALIGNMENT - 1) / CPU_ALIGNMENT) * CPU_ALIGNMENT;
+        void* ptr = std::aligned_alloc(CPU_ALIGNMENT, padded);
+        if (ptr == nullptr) {throw CpuError("aligned_alloc failed for " + std::to_string(size) + " bytes");}
+        return static_cast<T*>(ptr);
+    }
+
+    inline void cpuMemcpyChecked(void* dst, const void* src, size_t count) {
+        if (count == 0 || dst == src) {return;}
+        if (dst == nullptr || src == nullptr) {throw CpuError("cpuMemcpy called with null pointer");}
+        std::memcpy(dst, src, count);
+    }
+
+    inline void cpuFreeChecked(void* ptr) {
+        std::free(ptr);
+    }
+
+namespace cpublas {
+    enum Operation : char {
+        OP_N = 'N',
+        OP_T = 'T',
+        OP_C = 'C'
+    };
+
+    // Stand-in for cublasHandle_t, only carries the thread count (0 := runtime default)
+    struct Handle {
+        int num_threads = 0;
+    };
+
+    // cuSOLVER handle counterpart, the CPU restart path runs through Eigen so nothing to hold
+    struct SolverHandle {};
+
+    inline int threadCount(const Handle& handle) {
+        #ifdef _OPENMP
+            return handle.num_threads > 0 ? handle.num_threads : omp_get_max_threads();
+        #else
+            return 1;
+        #endif
+    }
+
+    // Device scalar -> host scalar, cuDoubleComplex/cuComplex share std::complex layout. Host scalars map to themselves,
+    // so the kernels also run on a basis narrower than HostPrecision (adaptive precision, adaptive.hpp)
+    template <typename T>
+    using HostScalar = std::conditional_t<std::is_same_v<T, DevicePrecision>, HostPrecision,
+                                          std::conditional_t<std::is_floating_point_v<T> || is_complex_v<T>, T, ComplexType>>;
+
+    template <typename T>
+    inline auto* host(T* ptr) { return reinterpret_cast<HostScalar<std::remove_const_t<T>>*>(ptr); }
+
+    template <typename T>
+    inline const auto* host(const T* ptr) { return reinterpret_cast<const HostScalar<T>*>(ptr); }
+
+    template <typename S>
+    inline S conjugate(const S& x) {
+        if constexpr (is_complex_v<S>) {return std::conj(x);}
+        else {return x;}
+    }
+
+    // acc += x * y without the C99 Annex G inf/nan recovery of std::complex multiplication, which blocks vectorization
+    template <typename S>
+    inline void multiplyAdd(S& acc, const S& x, const S& y) {
+        if constexpr (is_complex_v<S>) {
+            acc = S(acc.real() + x.real() * y.real() - x.imag() * y.imag(), acc.imag() + x.real() * y.imag() + x.imag() * y.real());
+        } else {
+            acc += x * y;
+        }
+    }
+
+    // acc += conj(x) * y, same reasoning
+    template <typename S>
+    inline void conjMultiplyAdd(S& acc, const S& x, const S& y) {
+        if constexpr (is_complex_v<S>) {
+            acc = S(acc.real() + x.real() * y.real() + x.imag() * y.imag(), acc.imag() + x.real() * y.imag() - x.imag() * y.real());
+        } else {
+            acc += x * y;
+        }
+    }
+
+    // Real matrix element times complex vector element: two real FMAs, the matrix is never promoted
+    template <typename R>
+    inline void multiplyAdd(std::complex<R>& acc, const R& a, const std::complex<R>& y) {
+        acc = std::complex<R>(acc.real() + a * y.real(), acc.imag() + a * y.imag());
+    }
+
+    template <typename R>
+    inline void conjMultiplyAdd(std::complex<R>& acc, const R& a, const std::complex<R>& y) { multiplyAdd(acc, a, y); }
+
+    // Minimum number of elements per thread before a kernel goes parallel
+    constexpr size_t PARALLEL_GRAIN = 1 << 14;
+    // Bytes of A one gemm row panel may span, sized to sit in L2 alongside the C panel
+    constexpr size_t GEMM_PANEL_BYTES = size_t(256) << 10;
+    constexpr int GEMM_COLUMN_BLOCK = 4;
+    // Rows per gemv panel, the x or y panel stays in L1 while the matrix streams past
+    constexpr size_t GEMV_PANEL = 1024;
+
+    // y[r0, r1) += alpha * A[r0, r1) x, GEMM_COLUMN_BLOCK columns per pass over the y panel. A may be real under a
+    // complex x and y (SA := its scalar)
+    template <typename SA, typename S>
+    inline void panelUpdate(const SA* A, size_t lda, int n, const S& alpha, const S* x, size_t incx, S* y, size_t incy, size_t r0, size_t r1) {
+        int j = 0;
+        for (; j + GEMM_COLUMN_BLOCK <= n; j += GEMM_COLUMN_BLOCK) {
+            const SA* c0 = A + static_cast<size_t>(j) * lda;
+            const SA* c1 = c0 + lda;
+            const SA* c2 = c1 + lda;
+            const SA* c3 = c2 + lda;
+            const S x0 = alpha * x[static_cast<size_t>(j) * incx], x1 = alpha * x[static_cast<size_t>(j + 1) * incx];
+            const S x2 = alpha * x[static_cast<size_t>(j + 2) * incx], x3 = alpha * x[static_cast<size_t>(j + 3) * incx];
+            for (size_t r = r0; r < r1; ++r) {
+                S acc = y[r * incy];
+                multiplyAdd(acc, c0[r], x0);
+                multiplyAdd(acc, c1[r], x1);
+                multiplyAdd(acc, c2[r], x2);
+                multiplyAdd(acc, c3[r], x3);
+                y[r * incy] = acc;
+            }
+        }
+        for (; j < n; ++j) {
+            const S xj = alpha * x[static_cast<size_t>(j) * incx];
+            const SA* col = A + static_cast<size_t>(j) * lda;
+            for (size_t r = r0; r < r1; ++r) {multiplyAdd(y[r * incy], col[r], xj);}
+        }
+    }
+
+    // P[j] += op(A[r0, r1), j)^T x[r0, r1) for the n columns, op = conj when Conj. GEMM_COLUMN_BLOCK dot products per
+    // pass share each x load and keep independent add chains
+    template <bool Conj, typename SA, typename S>
+    inline void panelDots(const SA* A, size_t lda, int n, const S* x, size_t incx, size_t r0, size_t r1, S* P) {
+        auto fma = [](S& acc, const SA& u, const S& v) {
+            if constexpr (Conj) {conjMultiplyAdd(acc, u, v);}
+            else {multiplyAdd(acc, u, v);}
+        };
+        int j = 0;
+        for (; j + GEMM_COLUMN_BLOCK <= n; j += GEMM_COLUMN_BLOCK) {
+            const SA* c0 = A + static_cast<size_t>(j) * lda;
+            const SA* c1 = c0 + lda;
+            const SA* c2 = c1 + lda;
+            const SA* c3 = c2 + lda;
+            S acc0(0), acc1(0), acc2(0), acc3(0);
+            for (size_t r = r0; r < r1; ++r) {
+                const S xr = x[r * incx];
+                fma(acc0, c0[r], xr);
+                fma(acc1, c1[r], xr);
+                fma(acc2, c2[r], xr);
+                fma(acc3, c3[r], xr);
+            }
+            P[j] += acc0;
+            P[j + 1] += acc1;
+            P[j + 2] += acc2;
+            P[j + 3] += acc3;
+        }
+        for (; j < n; ++j) {
+            const SA* col = A + static_cast<size_t>(j) * lda;
+            S acc(0);
+            for (size_t r = r0; r < r1; ++r) {fma(acc, col[r], x[r * incx]);}
+            P[j] += acc;
+        }
+    }
+
+    // Upper bound on per-thread partial sums kept on the stack by the reduction kernels
+    constexpr int MAX_PARTIALS = 256;
+
+    // Runs body(tid, nthreads) on a team of threads. A single thread calls it directly: even a one-thread OpenMP region
+    // sets up a team, which older libgomp releases heap-allocate on every entry
+    template <typename F>
+    inline void parallelRegion(int threads, F&& body) {
+        #ifdef _OPENMP
+        if (threads > 1) {
+            #pragma omp parallel num_threads(threads)
+            body(omp_get_thread_num(), omp_get_num_threads());
+            return;
+        }
+        #endif
+        body(0, 1);
+    }
+
+    // Contiguous [begin, end) share of N items for thread tid, the split schedule(static) would make
+    struct ChunkRange {
+        size_t begin, end;
+    };
+
+    inline ChunkRange chunkRange(size_t N, int tid, int nthreads) {
+        const size_t chunk = (N + nthreads - 1) / nthreads;
+        const size_t begin = std::min(N, tid * chunk);
+        return {begin, std::min(N, begin + chunk)};
+    }
+
+    // ==================== LEVEL 1 ====================
+
+    // conj(x)^T y, partial sums per thread so complex reductions stay deterministic for a fixed thread count
+    template <typename S>
+    inline S dotc(const Handle& handle, size_t N, const S* x, size_t incx, const S* y, size_t incy) {
+        const int threads = N < PARALLEL_GRAIN ? 1 : std::min(threadCount(handle), MAX_PARTIALS);
+        S partial[MAX_PARTIALS]; // Stack slots, the Gram-Schmidt inner loop calls this per column and must not allocate
+        std::fill(partial, partial + threads, S(0));
+        parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [i0, i1] = chunkRange(N, tid, nthreads);
+            S acc(0);
+            for (size_t i = i0; i < i1; ++i) {acc += conjugate(x[i * incx]) * y[i * incy];}
+            partial[tid] = acc;
+        });
+        S result(0);
+        for (int t = 0; t < threads; ++t) {result += partial[t];}
+        return result;
+    }
+
+    // y += alpha * x
+    template <typename S>
+    inline void axpy(const Handle& handle, size_t N, const S& alpha, const S* x, size_t incx, S* y, size_t incy) {
+        const int threads = N < PARALLEL_GRAIN ? 1 : threadCount(handle);
+        parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [i0, i1] = chunkRange(N, tid, nthreads);
+            for (size_t i = i0; i < i1; ++i) {y[i * incy] += alpha * x[i * incx];}
+        });
+    }
+
+    // ==================== BLAS INTERFACES ====================
+
+    // Column-major gemv with cuBLAS semantics, y = alpha * op(A) x + beta * y. TA may be the real counterpart of a
+    // complex T: a real matrix applied to a complex vector in one pass, without a promoted copy
+    template <typename T, typename TA = T>
+    inline int gemv(const Handle& handle, Operation trans, int m, int n,
+                const T* alpha, const TA* A, int lda,
+                const T* x, int incx, const T* beta,
+                T* y, int incy) {
+        using S = HostScalar<T>;
+        const S a = *host(alpha);
+        const S b = *host(beta);
+        const auto* A_ = host(A);
+        const S* x_ = host(x);
+        S* y_ = host(y);
+        const size_t work = static_cast<size_t>(m) * n;
+        const int threads = work < PARALLEL_GRAIN ? 1 : threadCount(handle);
+
+        if (trans == OP_N) {
+            // Each thread owns a contiguous row range, swept in GEMV_PANEL row panels so the y panel stays in L1 while
+            // every column segment streams past it unit-stride, GEMM_COLUMN_BLOCK columns per pass
+            parallelRegion(threads, [&](int tid, int nthreads) {
+                const auto [t0, t1] = chunkRange(m, tid, nthreads);
+                for (size_t r0 = t0; r0 < t1; r0 += GEMV_PANEL) {
+                    const size_t r1 = std::min(t1, r0 + GEMV_PANEL);
+                    for (size_t r = r0; r < r1; ++r) {
+                        y_[r * incy] = (b == S(0)) ? S(0) : b * y_[r * incy];
+                    }
+                    panelUpdate(A_, lda, n, a, x_, incx, y_, incy, r0, r1);
+                }
+            });
+        } else {
+            // Transposed: threads split the rows and sweep them in panels, so the x panel stays in L1 across all n dot
+            // products. Per-thread partial results go to grow-only scratch and are summed after
+            const bool conj = (trans == OP_C);
+            static thread_local std::vector<S> partial;
+            const size_t slots = static_cast<size_t>(threads) * n;
+            if (partial.size() < slots) {partial.resize(slots);}
+            std::fill(partial.begin(), partial.begin() + slots, S(0));
+            S* partial_ = partial.data();
+            parallelRegion(threads, [&](int tid, int nthreads) {
+                const auto [t0, t1] = chunkRange(m, tid, nthreads);
+                S* P = partial_ + static_cast<size_t>(tid) * n;
+                for (size_t r0 = t0; r0 < t1; r0 += GEMV_PANEL) {
+                    const size_t r1 = std::min(t1, r0 + GEMV_PANEL);
+                    if (conj) {panelDots<true>(A_, lda, n, x_, incx, r0, r1, P);}
+                    else {panelDots<false>(A_, lda, n, x_, incx, r0, r1, P);}
+                }
+            });
+            for (int j = 0; j < n; ++j) {
+                S acc(0);
+                for (int t = 0; t < threads; ++t) {acc += partial_[static_cast<size_t>(t) * n + j];}
+                S& out = y_[static_cast<size_t>(j) * incy];
+                out = a * acc + ((b == S(0)) ? S(0) : b * out);
+            }
+        }
+        return 0;
+    }
+
+    // Column-major gemm with cuBLAS semantics, C = alpha * op(A) op(B) + beta * C
+    template <typename T>
+    inline int gemm(const Handle& handle, Operation transA, Operation transB, int m, int n, int k,
+                const T* alpha, const T* A, int lda,
+                const T* B, int ldb, const T* beta,
+                T* C, int ldc) {
+        using S = HostScalar<T>;
+        const S a = *host(alpha);
+        const S b = *host(beta);
+        const S* A_ = host(A);
+        const S* B_ = host(B);
+        S* C_ = host(C);
+        auto opB = [B_, ldb, transB](size_t l, size_t j) -> S {
+            if (transB == OP_N) {return B_[l + j * ldb];}
+            const S v = B_[j + l * ldb];
+            return transB == OP_C ? conjugate(v) : v;
+        };
+        const size_t work = static_cast<size_t>(m) * n * k;
+        const int threads = work < PARALLEL_GRAIN ? 1 : threadCount(handle);
+
+        if (transA == OP_N) {
+            // Row ranges per thread as in gemv, cut into panels of A that stay in cache across the n columns of C, so a
+            // tall A (a Krylov basis times a small matrix) is streamed from memory once rather than n times
+            const size_t panel = std::clamp<size_t>(GEMM_PANEL_BYTES / (sizeof(S) * std::max(k, 1)), 16, 4096);
+            parallelRegion(threads, [&](int tid, int nthreads) {
+                const auto [t0, t1] = chunkRange(m, tid, nthreads);
+                for (size_t p0 = t0; p0 < t1; p0 += panel) {
+                    const size_t p1 = std::min(t1, p0 + panel);
+                    for (size_t r = p0; r < p1; ++r) {
+                        for (int j = 0; j < n; ++j) {
+                            S& c = C_[r + static_cast<size_t>(j) * ldc];
+                            c = (b == S(0)) ? S(0) : b * c;
+                        }
+                    }
+                    // Four columns of C per sweep over the panel, each A element loaded once feeds four updates
+                    for (int j0 = 0; j0 < n; j0 += GEMM_COLUMN_BLOCK) {
+                        const int jn = std::min(GEMM_COLUMN_BLOCK, n - j0);
+                        S* c[GEMM_COLUMN_BLOCK];
+                        for (int t = 0; t < jn; ++t) {c[t] = C_ + static_cast<size_t>(j0 + t) * ldc;}
+                        for (int l = 0; l < k; ++l) {
+                            const S* col = A_ + static_cast<size_t>(l) * lda;
+                            S blj[GEMM_COLUMN_BLOCK];
+                            for (int t = 0; t < jn; ++t) {blj[t] = a * opB(l, j0 + t);}
+                            if (jn == GEMM_COLUMN_BLOCK) {
+                                for (size_t r = p0; r < p1; ++r) {
+                                    const S x = col[r];
+                                    for (int t = 0; t < GEMM_COLUMN_BLOCK; ++t) {multiplyAdd(c[t][r], x, blj[t]);}
+                                }
+                            } else {
+                                for (int t = 0; t < jn; ++t) {
+                                    for (size_t r = p0; r < p1; ++r) {multiplyAdd(c[t][r], col[r], blj[t]);}
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+        } else {
+            // Tall-skinny inner products (Q^H W): split the k reduction across threads, partial m x n blocks summed after
+            const bool conj = (transA == OP_C);
+            // Per-thread scratch that only grows, repeated calls of the same shape never allocate
+            static thread_local std::vector<S> partial;
+            const size_t slots = static_cast<size_t>(threads) * m * n;
+            if (partial.size() < slots) {partial.resize(slots);}
+            std::fill(partial.begin(), partial.begin() + slots, S(0));
+            S* partial_ = partial.data();
+            parallelRegion(threads, [&](int tid, int nthreads) {
+                const auto [l0, l1] = chunkRange(k, tid, nthreads);
+                S* P = partial_ + static_cast<size_t>(tid) * m * n;
+                for (int j = 0; j < n; ++j) {
+                    for (int i = 0; i < m; ++i) {
+                        const S* col = A_ + static_cast<size_t>(i) * lda;
+                        S acc(0);
+                        if (conj) {for (size_t l = l0; l < l1; ++l) {acc += conjugate(col[l]) * opB(l, j);}}
+                        else {for (size_t l = l0; l < l1; ++l) {acc += col[l] * opB(l, j);}}
+                        P[i + static_cast<size_t>(j) * m] = acc;
+                    }
+                }
+            });
+            for (int j = 0; j < n; ++j) {
+                for (int i = 0; i < m; ++i) {
+                    S acc(0);
+                    for (int t = 0; t < threads; ++t) {acc += partial_[static_cast<size_t>(t) * m * n + i + static_cast<size_t>(j) * m];}
+                    S& out = C_[i + static_cast<size_t>(j) * ldc];
+                    out = a * acc + ((b == S(0)) ? S(0) : b * out);
+                }
+            }
+        }
+        return 0;
+    }
+
+    template <typename T>
+    inline int norm(const Handle& handle, int N, const T* d_result, int incx, HostPrecision* norms) {
+        using S = HostScalar<T>;
+        const S* x = host(d_result);
+        const int threads = static_cast<size_t>(N) < PARALLEL_GRAIN ? 1 : std::min(threadCount(handle), MAX_PARTIALS);
+        HostPrecision partial[MAX_PARTIALS] = {};
+        parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [i0, i1] = chunkRange(N, tid, nthreads);
+            HostPrecision acc = 0;
+            for (size_t i = i0; i < i1; ++i) {acc += std::norm(x[i * incx]);}
+            partial[tid] = acc;
+        });
+        HostPrecision acc = 0;
+        for (int t = 0; t < threads; ++t) {acc += partial[t];}
+        *norms = std::sqrt(acc);
+        return 0;
+    }
+
+    template <typename T>
+    inline int scale(const Handle& handle, int N, const DevicePrecision* alpha, T* x, int incx) {
+        using S = HostScalar<T>;
+        S* x_ = host(x);
+        const HostPrecision a = *alpha;
+        const int threads = static_cast<size_t>(N) < PARALLEL_GRAIN ? 1 : threadCount(handle);
+        parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [i0, i1] = chunkRange(N, tid, nthreads);
+            for (size_t i = i0; i < i1; ++i) {x_[i * incx] *= a;}
+        });
+        return 0;
+    }
+
+// ==================== LINALG ROUTINES ====================
+
+    // Modified Gram-Schmidt against columns 0..i of d_evecs, projections land in column i of d_h (ld num_iters + 1)
+    template <typename T>
+    inline void MGS(const Handle& handle,
+                        const T* d_evecs,
+                        T* d_h,
+                        T* d_result,
+                        int N,
+                        int num_iters,
+                        int i) {
+        using S = HostScalar<T>;
+        const S* Q = host(d_evecs);
+        S* h = host(d_h);
+        S* w = host(d_result);
+        for (int j = 0; j <= i; j++) {
+            const S* qj = Q + static_cast<size_t>(j) * N;
+            const S proj = dotc<S>(handle, N, qj, 1, w, 1);
+            h[static_cast<size_t>(i) * (num_iters + 1) + j] = proj;
+            axpy<S>(handle, N, -proj, qj, 1, w, 1);
+        }
+    }
+
+    // Classical Gram-Schmidt with DGKS reorthogonalization: h = Q^H w and w -= Q h as two gemv sweeps over the basis,
+    // repeated once when the update cancelled enough of w that ||w|| dropped below DGKS_ETA of its value. Returns the
+    // final ||w||, work holds i + 1 correction coefficients
+    template <typename T>
+    inline HostPrecision CGS2(const Handle& handle,
+                              const T* d_evecs,
+                              T* d_h,
+                              T* d_result,
+                              T* d_work,
+                              int N,
+                              int num_iters,
+                              int i,
+                              bool* reorthogonalized = nullptr) {
+        using S = HostScalar<T>;
+        constexpr HostPrecision DGKS_ETA = 0.7071067811865476;
+        const S one(1), neg_one(-1), zero(0);
+        S* h = host(d_h) + static_cast<size_t>(i) * (num_iters + 1);
+        S* w = host(d_result);
+        HostPrecision before = 0, after = 0;
+        norm<S>(handle, N, w, 1, &before);
+        gemv<S>(handle, OP_C, N, i + 1, &one, host(d_evecs), N, w, 1, &zero, h, 1);
+        gemv<S>(handle, OP_N, N, i + 1, &neg_one, host(d_evecs), N, h, 1, &one, w, 1);
+        norm<S>(handle, N, w, 1, &after);
+        const bool again = after < DGKS_ETA * before;
+        if (again) {
+            S* c = host(d_work);
+            gemv<S>(handle, OP_C, N, i + 1, &one, host(d_evecs), N, w, 1, &zero, c, 1);
+            gemv<S>(handle, OP_N, N, i + 1, &neg_one, host(d_evecs), N, c, 1, &one, w, 1);
+            for (int j = 0; j <= i; ++j) {h[j] += c[j];}
+            norm<S>(handle, N, w, 1, &after);
+        }
+        if (reorthogonalized) {*reorthogonalized = again;}
+        return after;
+    }
+
+    // Fused CGS2 for the Arnoldi step. w is column i + 1 of d_evecs (the matvec writes it there) and leaves as the
+    // normalized q_{i+1}, with no copy through a separate vector. Two sweeps over Q_{i+1} in the common case:
+    //   1. h = Q^H w together with ||w||^2
+    //   2. per row panel, w = (w - Q h) / ||w - Q h||, with the norm taken as sqrt(||w||^2 - ||h||^2)
+    // Unless the DGKS criterion fires, the Pythagorean norm loses at most a factor 2 of relative accuracy. When it
+    // fires, sweep 2 skips the scaling and computes c = Q^H w and ||w||^2 per panel while the Q panel is still in cache.
+    // Sweep 3 then applies w = (w - Q c) / ||w - Q c|| in the same way. An explicit norm and an extra scaling pass are
+    // needed only when the correction cancels too (near breakdown).
+    // Without project, sweep 1 is skipped and h together with ||w||^2 (in h[k]) are taken as given. With next, the last
+    // sweep also applies next = (next - Q_{k+1} g) / beta, g = H_{k+1,k} h, after storing beta in h[k] (H column-major
+    // with leading dimension ld, h its column k - 1). *advanced reports whether next was updated
+    template <typename S>
+    inline HostPrecision orthonormalizeStep(const Handle& handle, const S* Q, size_t rows, int k, S* w, S* h, S* c, bool project,
+                                            S* next, const S* H, size_t ld, bool* reorthogonalized, bool* advanced) {
+        constexpr HostPrecision DGKS_ETA2 = 0.5; // DGKS_ETA squared
+        const int threads = rows * k < PARALLEL_GRAIN ? 1 : threadCount(handle);
+        // Streaming sweeps keep the w panel in L1. The reorthogonalizing sweep reads each Q panel (k columns) twice,
+        // so it is sized to stay in L2 between the update and the projection of the updated panel
+        const size_t cached_panel = std::max<size_t>(64, GEMM_PANEL_BYTES / (static_cast<size_t>(k) * sizeof(S)));
+
+        // k projections plus one squared norm per thread, summed after the region. The next-step coefficients g follow
+        static thread_local std::vector<S> partial;
+        const size_t slots = static_cast<size_t>(threads) * (k + 1);
+        if (partial.size() < slots + k + 1) {partial.resize(slots + k + 1);}
+        S* partial_ = partial.data(); // thread_local: team threads must reach the caller's copy through the pointer
+        S* g = partial_ + slots;
+        auto reduce = [&](S* out) -> HostPrecision {
+            for (int j = 0; j < k; ++j) {
+                S acc(0);
+                for (int t = 0; t < threads; ++t) {acc += partial_[static_cast<size_t>(t) * (k + 1) + j];}
+                out[j] = acc;
+            }
+            HostPrecision nrm2 = 0;
+            for (int t = 0; t < threads; ++t) {nrm2 += std::real(partial_[static_cast<size_t>(t) * (k + 1) + k]);}
+            return nrm2;
+        };
+        auto sumSquares = [](const S* x, size_t r0, size_t r1) {
+            HostPrecision acc = 0;
+            for (size_t r = r0; r < r1; ++r) {acc += std::norm(x[r]);}
+            return acc;
+        };
+        auto coeffNorm2 = [k](const S* x) {
+            HostPrecision acc = 0;
+            for (int j = 0; j < k; ++j) {acc += std::norm(x[j]);}
+            return acc;
+        };
+        // Sweeps over thread-owned row ranges in panels. body(r0, r1, P) sees this thread's partial slots
+        auto sweep = [&](bool accumulate, size_t panel, auto&& body) {
+            if (accumulate) {std::fill(partial_, partial_ + slots, S(0));}
+            parallelRegion(threads, [&](int tid, int nthreads) {
+                const auto [t0, t1] = chunkRange(rows, tid, nthreads);
+                S* P = partial_ + static_cast<size_t>(tid) * (k + 1);
+                for (size_t r0 = t0; r0 < t1; r0 += panel) {body(r0, std::min(t1, r0 + panel), P);}
+            });
+        };
+        // w = (w - Q x) / beta, then next = (next - Q_{k+1} g) / beta on the same panel once its q_k rows are final
+        auto finish = [&](const S* x, HostPrecision beta) {
+            const HostPrecision inv = 1 / beta;
+            if (next) {
+                h[k] = beta;
+                std::fill(g, g + k + 1, S(0));
+                for (int col = 0; col < k; ++col) {
+                    for (int r = 0; r <= k; ++r) {g[r] += H[static_cast<size_t>(col) * ld + r] * h[col];}
+                }
+            }
+            sweep(false, GEMV_PANEL, [&](size_t r0, size_t r1, S*) {
+                panelUpdate(Q, rows, k, S(-1), x, 1, w, 1, r0, r1);
+                for (size_t r = r0; r < r1; ++r) {w[r] *= inv;}
+                if (next) {
+                    panelUpdate(Q, rows, k + 1, S(-1), g, 1, next, 1, r0, r1);
+                    for (size_t r = r0; r < r1; ++r) {next[r] *= inv;}
+                }
+            });
+            return beta;
+        };
+
+        HostPrecision before2 = std::real(h[k]);
+        if (project) {
+            sweep(true, GEMV_PANEL, [&](size_t r0, size_t r1, S* P) {
+                panelDots<true>(Q, rows, k, w, 1, r0, r1, P);
+                P[k] += sumSquares(w, r0, r1);
+            });
+            before2 = reduce(h);
+        }
+        const HostPrecision after2 = before2 - coeffNorm2(h);
+        const bool again = !(after2 >= DGKS_ETA2 * before2) || before2 == 0;
+        if (reorthogonalized) {*reorthogonalized = again;}
+        if (advanced) {*advanced = next != nullptr;}
+        if (!again) {return finish(h, std::sqrt(after2));}
+
+        sweep(true, cached_panel, [&](size_t r0, size_t r1, S* P) {
+            panelUpdate(Q, rows, k, S(-1), h, 1, w, 1, r0, r1);
+            panelDots<true>(Q, rows, k, w, 1, r0, r1, P);
+            P[k] += sumSquares(w, r0, r1);
+        });
+        const HostPrecision mid2 = reduce(c);
+        for (int j = 0; j < k; ++j) {h[j] += c[j];}
+        const HostPrecision final2 = mid2 - coeffNorm2(c);
+        if (final2 >= DGKS_ETA2 * mid2 && mid2 > 0) {return finish(c, std::sqrt(final2));}
+
+        // The correction cancelled as well, so w is numerically in span(Q): update, then take the norm explicitly
+        sweep(false, GEMV_PANEL, [&](size_t r0, size_t r1, S*) {panelUpdate(Q, rows, k, S(-1), c, 1, w, 1, r0, r1);});
+        HostPrecision after = 0;
+        norm<S>(handle, static_cast<int>(rows), w, 1, &after);
+        if (after > 0) {
+            const DevicePrecision inv = 1 / after;
+            scale<S>(handle, static_cast<int>(rows), &inv, w, 1);
+        }
+        if (next) {
+            h[k] = after;
+            if (advanced) {*advanced = false;}
+        }
+        return after;
+    }
+
+    // Returns h_{i+1,i}; work holds i + 1 scalars
+    template <typename T>
+    inline HostPrecision orthonormalize(const Handle& handle,
+                                        T* d_evecs,
+                                        T* d_h,
+                                        T* d_work,
+                                        int N,
+                                        int num_iters,
+                                        int i,
+                                        bool* reorthogonalized = nullptr) {
+        using S = HostScalar<T>;
+        S* w = host(d_evecs) + static_cast<size_t>(i + 1) * N;
+        S* h = host(d_h) + static_cast<size_t>(i) * (num_iters + 1);
+        return orthonormalizeStep<S>(handle, host(d_evecs), N, i + 1, w, h, host(d_work), true, nullptr, nullptr, 0,
+                                     reorthogonalized, nullptr);
+    }
+
+    // Finish of a pipelined Arnoldi step. Column i + 1 of d_evecs holds u = A q_i, and column i of d_h holds
+    // [Q_{i+1}^H u; u^H u] from one projection that ran alongside the next matvec. When advance is set, that matvec left
+    // t = A u in column i + 2. orthonormalizeStep turns u into q_{i+1} and stores beta = h_{i+1,i} in d_h. By linearity,
+    // and because A Q_{i+1} = Q_{i+2} H_{i+2,i+1}, the same sweep leaves A q_{i+1} = (t - A Q h) / beta in column i + 2
+    // for the next step. That holds unless the step hit breakdown, reported through *advanced. *projected_norm
+    // receives ||u||
+    template <typename T>
+    inline HostPrecision pipelinedOrthonormalize(const Handle& handle,
+                                                 T* d_evecs,
+                                                 T* d_h,
+                                                 T* d_work,
+                                                 int N,
+                                                 int num_iters,
+                                                 int i,
+                                                 bool advance,
+                                                 HostPrecision* projected_norm,
+                                                 bool* reorthogonalized,
+                                                 bool* advanced) {
+        using S = HostScalar<T>;
+        const size_t ld = static_cast<size_t>(num_iters) + 1;
+        S* w = host(d_evecs) + static_cast<size_t>(i + 1) * N;
+        S* h = host(d_h) + static_cast<size_t>(i) * ld;
+        *projected_norm = std::sqrt(std::max<HostPrecision>(std::real(h[i + 1]), 0));
+        return orthonormalizeStep<S>(handle, host(d_evecs), N, i + 1, w, h, host(d_work), false, advance ? w + N : nullptr,
+                                     host(d_h), ld, reorthogonalized, advanced);
+    }
+
+} // namespace cpublas
+
+
+#endif // CPU_MANAGER_HPP
@@ -4,8 +4,14 @@
     #include <cuda_runtime.h>
     #include <cublas_v2.h>
     #include <cusolverDn.h>
+    #include <cassert>
 
+// cuComplex/cuDoubleComplex share the layout of the matching ComplexType
+#ifdef PRECISION_FLOAT
+using DeviceComplexType = cuComplex;
+#else
 using DeviceComplexType = cuDoubleComplex;
+#endif
 
     template <typename T>
 constexpr T getOne() {
@@ -23,7 +29,7 @@ constexpr T getZero() {
     if constexpr (std::is_same_v<T, cuDoubleComplex>) {
         return cuDoubleComplex(0.0, 0.0);
     } else if constexpr (std::is_same_v<T, cuComplex>) {
-        return cuDoubleComplex(0.0f, 0.0f);
+        return make_cuComplex(0.0f, 0.0f);
     } else {
         return T(0.0);
     }
@@ -40,12 +46,7 @@ constexpr T getNegOne() {
     }
 }
 
-    
-    enum class CuRetType {
-        HOST,
-        DEVICE
-    };
-        
+
     class CudaError : public std::runtime_error {
     public:
         explicit CudaError(const std::string& message) : std::runtime_error(message) {}
@@ -66,6 +67,38 @@ constexpr T getNegOne() {
         }
     }
 
+    inline void cudaMemcpyAsyncChecked(void* dst, const void* src, size_t count, cudaMemcpyKind kind, cudaStream_t stream) {
+        cudaError_t error = cudaMemcpyAsync(dst, src, count, kind, stream);
+        if (error != cudaSuccess) {
+            throw CudaError("cudaMemcpyAsync failed: " + std::string(cudaGetErrorString(error)));
+        }
+    }
+
+    // Grow-only page-locked host buffer, so small device <-> host transfers can be queued on a stream
+    template <typename T>
+    class PinnedBuffer {
+    public:
+        PinnedBuffer() = default;
+        PinnedBuffer(const PinnedBuffer&) = delete;
+        PinnedBuffer& operator=(const PinnedBuffer&) = delete;
+        ~PinnedBuffer() {if (ptr_) {cudaFreeHost(ptr_);}}
+
+        inline T* reserve(size_t count) {
+            if (count > size_) {
+                if (ptr_) {cudaFreeHost(ptr_);}
+                ptr_ = nullptr;
+                cudaError_t error = cudaMallocHost(reinterpret_cast<void**>(&ptr_), count * sizeof(T));
+                if (error != cudaSuccess) {throw CudaError("cudaMallocHost failed: " + std::string(cudaGetErrorString(error)));}
+                size_ = count;
+            }
+            return ptr_;
+        }
+
+    private:
+        T* ptr_ = nullptr;
+        size_t size_ = 0;
+    };
+
     inline void cudaFreeChecked(void* d_ptr) {
         if (d_ptr != nullptr) { // Check if the pointer is not null
             cudaError_t error = cudaFree(d_ptr);
@@ -153,6 +186,9 @@ namespace cublas {
     template <typename T>
     struct ScaleTraits;
 
+    template <typename T>
+    struct AxpyTraits;
+
     // ==================== TRAIT SPECIALIZATIONS ====================
 
     template <>
@@ -273,6 +309,28 @@ namespace cublas {
         #endif
     };
 
+    template <>
+    struct AxpyTraits<DeviceComplexType> {
+        #ifdef PRECISION_FLOAT
+            static constexpr auto axpyFunc = &cublasCaxpy;
+        #elif PRECISION_DOUBLE
+            static constexpr auto axpyFunc = &cublasZaxpy;
+        #else
+            static_assert(false, "Unsupported type for cublasMGS.");
+        #endif
+    };
+
+    template<>
+    struct AxpyTraits<DevicePrecision> {
+        #ifdef PRECISION_FLOAT
+            static constexpr auto axpyFunc = &cublasSaxpy;
+        #elif PRECISION_DOUBLE
+            static constexpr auto axpyFunc = &cublasDaxpy;
+        #else
+            static_assert(false, "Unsupported type for cublasMGS.");
+        #endif
+    };
+
     // ==================== TRAIT INTERFACES ====================
 
     template <typename T>
@@ -284,6 +342,22 @@ namespace cublas {
         return cublasGemv(handle, trans, m, n, alpha, A, lda, x, incx, beta, y, incy);
     }
 
+    // Real A under complex x, y. An interleaved complex vector is a 2 x len real matrix, so y = op(A) x is the real gemm
+    // Y = X op(A)^T and A is read once, unpromoted. Unit strides, and alpha, beta must be real
+    template <typename T>
+    inline cublasStatus_t gemvReal(cublasHandle_t handle, cublasOperation_t trans, int m, int n,
+                const T* alpha, const DevicePrecision* A, int lda,
+                const T* x, int incx, const T* beta,
+                T* y, int incy) {
+        assert(incx == 1 && incy == 1 && "gemvReal needs unit strides");
+        const DevicePrecision a = alpha->x, b = beta->x;
+        const DevicePrecision* X = reinterpret_cast<const DevicePrecision*>(x);
+        DevicePrecision* Y = reinterpret_cast<DevicePrecision*>(y);
+        auto cublasGemm = GemmTraits<DevicePrecision>::gemmFunc;
+        if (trans == CUBLAS_OP_N) {return cublasGemm(handle, CUBLAS_OP_N, CUBLAS_OP_T, 2, m, n, &a, X, 2, A, lda, &b, Y, 2);}
+        return cublasGemm(handle, CUBLAS_OP_N, CUBLAS_OP_N, 2, n, m, &a, X, 2, A, lda, &b, Y, 2);
+    }
+
     template <typename T>
     inline cublasStatus_t gemm(cublasHandle_t handle, cublasOperation_t transA, cublasOperation_t transB, 
                             int m, int n, int k, 
@@ -312,6 +386,12 @@ namespace cublas {
         return cublasScale(handle, N, alpha, x, incx);
     }
 
+    template <typename T>
+    inline cublasStatus_t axpy(cublasHandle_t handle, int N, const T* alpha, const T* x, int incx, T* y, int incy) {
+        auto cublasAxpy = AxpyTraits<T>::axpyFunc;
+        return cublasAxpy(handle, N, alpha, x, incx, y, incy);
+    }
+
 
 
 // ==================== LINALG ROUTINES ====================
@@ -339,6 +419,122 @@ namespace cublas {
         }
     }
 
+    // Classical Gram-Schmidt with DGKS reorthogonalization (cpublas::CGS2): two gemv kernels per pass instead of
+    // 2 (i + 1) length-N calls, the second pass only when ||w|| dropped below 1/sqrt(2) of its value
+    template <typename T>
+    inline HostPrecision CGS2(cublasHandle_t handle,
+                              const T* d_evecs,
+                              T* d_h,
+                              T* d_result,
+                              T* d_work,
+                              int N,
+                              int num_iters,
+                              int i,
+                              bool* reorthogonalized = nullptr) {
+        constexpr HostPrecision DGKS_ETA = 0.7071067811865476;
+        constexpr T NEG_ONE = getNegOne<T>();
+        constexpr T ONE = getOne<T>();
+        constexpr T ZERO = getZero<T>();
+        constexpr bool isComplex = cuda::is_device_complex_v<T>;
+        T* h = &d_h[i * (num_iters + 1)];
+        HostPrecision before = 0, after = 0;
+        cublas::norm<T>(handle, N, d_result, 1, &before);
+        cublas::gemv<T>(handle, isComplex ? CUBLAS_OP_C : CUBLAS_OP_T, N, i + 1, &ONE, d_evecs, N, d_result, 1, &ZERO, h, 1);
+        cublas::gemv<T>(handle, CUBLAS_OP_N, N, i + 1, &NEG_ONE, d_evecs, N, h, 1, &ONE, d_result, 1);
+        cublas::norm<T>(handle, N, d_result, 1, &after);
+        const bool again = after < DGKS_ETA * before;
+        if (again) {
+            cublas::gemv<T>(handle, isComplex ? CUBLAS_OP_C : CUBLAS_OP_T, N, i + 1, &ONE, d_evecs, N, d_result, 1, &ZERO, d_work, 1);
+            cublas::gemv<T>(handle, CUBLAS_OP_N, N, i + 1, &NEG_ONE, d_evecs, N, d_work, 1, &ONE, d_result, 1);
+            cublas::axpy<T>(handle, i + 1, &ONE, d_work, 1, h, 1);
+            cublas::norm<T>(handle, N, d_result, 1, &after);
+        }
+        if (reorthogonalized) {*reorthogonalized = again;}
+        return after;
+    }
+
+    // In-place Arnoldi step (cpublas::orthonormalize): CGS2 on column i + 1 of d_evecs, then scaled into q_{i+1}
+    template <typename T>
+    inline HostPrecision orthonormalize(cublasHandle_t handle,
+                                        T* d_evecs,
+                                        T* d_h,
+                                        T* d_work,
+                                        int N,
+                                        int num_iters,
+                                        int i,
+                                        bool* reorthogonalized = nullptr) {
+        T* w = d_evecs + static_cast<size_t>(i + 1) * N;
+        const HostPrecision after = CGS2<T>(handle, d_evecs, d_h, w, d_work, N, num_iters, i, reorthogonalized);
+        if (after > 0) {
+            const DevicePrecision inv = 1.0 / after;
+            cublas::scale<T>(handle, N, &inv, w, 1);
+        }
+        return after;
+    }
+
+    // Pipelined Arnoldi finish (cpublas::pipelinedOrthonormalize). Without custom kernels the i + 2 projection scalars
+    // are read on the host once per step, after the overlapped matvec rather than between the matvec and the projection;
+    // that read is the step's only synchronization. They land in a grow-only page-locked buffer, and beta goes back into
+    // d_h as an asynchronous copy ordered on the cuBLAS stream, so the host never waits for it
+    template <typename T>
+    inline HostPrecision pipelinedOrthonormalize(cublasHandle_t handle,
+                                                 T* d_evecs,
+                                                 T* d_h,
+                                                 T* d_work,
+                                                 int N,
+                                                 int num_iters,
+                                                 int i,
+                                                 bool advance,
+                                                 HostPrecision* projected_norm,
+                                                 bool* reorthogonalized,
+                                                 bool* advanced) {
+        using S = std::conditional_t<cuda::is_device_complex_v<T>, ComplexType, HostPrecision>;
+        constexpr HostPrecision DGKS_ETA2 = 0.5;
+        constexpr T NEG_ONE = getNegOne<T>();
+        constexpr T ONE = getOne<T>();
+        constexpr T ZERO = getZero<T>();
+        constexpr bool isComplex = cuda::is_device_complex_v<T>;
+        const int k = i + 1;
+        T* h = &d_h[i * (num_iters + 1)];
+        T* w = d_evecs + static_cast<size_t>(k) * N;
+
+        static thread_local PinnedBuffer<S> pinned;
+        S* coeffs = pinned.reserve(num_iters + 1); // Sized for the whole factorization, allocated once per thread
+        cudaStream_t stream = nullptr;
+        cublasGetStream(handle, &stream);
+        cudaMemcpyAsyncChecked(coeffs, h, (k + 1) * sizeof(T), cudaMemcpyDeviceToHost, stream);
+        cudaStreamSynchronize(stream);
+        const HostPrecision before2 = std::real(coeffs[k]);
+        HostPrecision coeff2 = 0;
+        for (int j = 0; j < k; ++j) {coeff2 += std::norm(coeffs[j]);}
+        const HostPrecision after2 = before2 - coeff2;
+        *projected_norm = std::sqrt(std::max<HostPrecision>(before2, 0));
+        const bool again = !(after2 >= DGKS_ETA2 * before2) || before2 == 0;
+        HostPrecision beta = std::sqrt(std::max<HostPrecision>(after2, 0));
+        cublas::gemv<T>(handle, CUBLAS_OP_N, N, k, &NEG_ONE, d_evecs, N, h, 1, &ONE, w, 1);
+        if (again) {
+            cublas::gemv<T>(handle, isComplex ? CUBLAS_OP_C : CUBLAS_OP_T, N, k, &ONE, d_evecs, N, w, 1, &ZERO, d_work, 1);
+            cublas::gemv<T>(handle, CUBLAS_OP_N, N, k, &NEG_ONE, d_evecs, N, d_work, 1, &ONE, w, 1);
+            cublas::axpy<T>(handle, k, &ONE, d_work, 1, h, 1);
+            cublas::norm<T>(handle, N, w, 1, &beta);
+        }
+        if (reorthogonalized) {*reorthogonalized = again;}
+        *advanced = advance && beta > 0;
+        // Read by the copy engine later in stream order; the next step's readback cannot overwrite it earlier
+        coeffs[k] = beta;
+        cudaMemcpyAsyncChecked(h + k, &coeffs[k], sizeof(T), cudaMemcpyHostToDevice, stream);
+        if (beta == 0) {return 0;}
+
+        const DevicePrecision inv = 1.0 / beta;
+        cublas::scale<T>(handle, N, &inv, w, 1);
+        if (*advanced) {
+            cublas::gemv<T>(handle, CUBLAS_OP_N, k + 1, k, &ONE, d_h, num_iters + 1, h, 1, &ZERO, d_work, 1);
+            cublas::gemv<T>(handle, CUBLAS_OP_N, N, k + 1, &NEG_ONE, d_evecs, N, d_work, 1, &ONE, w + N, 1);
+            cublas::scale<T>(handle, N, &inv, w + N, 1);
+        }
+        return beta;
+    }
+
 } // namespace cublas
 
 
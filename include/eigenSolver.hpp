@@ -1,11 +1,16 @@
 #ifndef EIGENSOLVER_HPP
 #define EIGENSOLVER_HPP
 
+    // EIGEN_EIGSOLVER is set by the build when LAPACK++ is not available
+    #if !defined(EIGEN_EIGSOLVER) && !defined(CUDA_EIGSOLVER)
     #define LAPACK_EIGSOLVER
+    #endif
     //#define EIGEN_EIGSOLVER    
     //#define CUDA_EIGSOLVER
 
+#ifdef LAPACK_EIGSOLVER
 #include <lapack.hh>   // LAPACK++ 
+#endif
 #include "vector.hpp"
 #include <complex>
 #include <numeric>
@@ -38,7 +43,7 @@ struct EigTraits<M, T, std::enable_if_t<T != matrix_type::SELFADJOINT, void>> {
 };
 
 
-RealEigenPairs purgeComplex(const ComplexEigenPairs& pair, const double& tol = 1e-10) {
+RealEigenPairs purgeComplex(const ComplexEigenPairs& pair, const HostPrecision& tol = default_tol) {
     const ComplexVector& eigenvals = pair.values;
     const ComplexMatrix& eigenvecs = pair.vectors;
     const size_t& N = pair.num_pairs;
@@ -143,28 +148,80 @@ inline void sortEigenPairs(EigPair<ValT, VecT>& pair) {
 }
 
 
-template <typename MatrixType>
-inline int HessenbergLapackEigenDecomp(const MatrixType& eigenMatrix, ComplexEigenPairs& resultHolder, const size_t& n) {
-    Eigen::MatrixXcd H = eigenMatrix;
-    Eigen::VectorXcd w(n);
-    Eigen::MatrixXcd Z(n, n);
-
-    // TREVC Variables
-    bool select[n]; // Use a plain array
-    std::fill(select, select + n, true);
-
-    Eigen::MatrixXcd VR(n, n);
-    int64_t m = 0;
-
-    // Call LAPACK functions
-    LAPACKPP_CHECK(lapack::hseqr(lapack::JobSchur::Schur, lapack::Job::Vec, n, 1, n, H.data(), n, w.data(), Z.data(), n));
-    LAPACKPP_CHECK(lapack::trevc3(lapack::Sides::Right, lapack::HowMany::All, select, n, H.data(), n, nullptr, n, VR.data(), n, n, &m));
-
-    ComplexMatrix evecs = Z * VR; // Ensure ComplexMatrix is defined correctly
+// Real storage of complex eigenvectors (LAPACK's dtrevc layout): a complex v_j takes two real columns, Re v_j and
+// Im v_j, and a following v_{j+1} = conj(v_j) of w_{j+1} = conj(w_j) takes none. Real v_j take one column
+inline Eigen::Index packConjugatePairs(const Eigen::Ref<const ComplexVector>& w, const Eigen::Ref<const ComplexMatrix>& V, Eigen::Ref<Matrix> Y) {
+    Eigen::Index c = 0;
+    for (Eigen::Index j = 0; j < w.size(); ++j, ++c) {
+        Y.col(c) = V.col(j).real();
+        if (w[j].imag() == 0) {continue;}
+        Y.col(++c) = V.col(j).imag();
+        if (j + 1 < w.size() && w[j + 1] == std::conj(w[j])) {++j;}
+    }
+    return c;
+}
 
-    resultHolder = {w, evecs, n};
+inline ComplexMatrix expandConjugatePairs(const Eigen::Ref<const ComplexVector>& w, const Eigen::Ref<const Matrix>& X) {
+    ComplexMatrix V(X.rows(), w.size());
+    Eigen::Index c = 0;
+    for (Eigen::Index j = 0; j < w.size(); ++j, ++c) {
+        if (w[j].imag() == 0) {V.col(j) = X.col(c).cast<ComplexType>(); continue;}
+        V.col(j).real() = X.col(c);
+        V.col(j).imag() = X.col(++c);
+        if (j + 1 < w.size() && w[j + 1] == std::conj(w[j])) {V.col(j + 1) = V.col(j).conjugate(); ++j;}
+    }
+    return V;
+}
 
+template <typename MatrixType>
+inline int HessenbergLapackEigenDecomp(const MatrixType& eigenMatrix, ComplexEigenPairs& resultHolder, const size_t& n) {
+    #ifndef LAPACK_EIGSOLVER
+    if constexpr (is_complex_v<typename MatrixType::Scalar>) {
+        Eigen::ComplexEigenSolver<ComplexMatrix> solver(eigenMatrix.template cast<ComplexType>());
+        resultHolder = {solver.eigenvalues(), solver.eigenvectors(), n};
+    } else {
+        // Real Schur form in real arithmetic, only the eigenvectors of conjugate pairs come out complex
+        Eigen::EigenSolver<Matrix> solver(eigenMatrix);
+        resultHolder = {solver.eigenvalues(), solver.eigenvectors(), n};
+    }
+    return 0;
+    #else
+    if constexpr (!is_complex_v<typename MatrixType::Scalar>) {
+        Matrix H = eigenMatrix;
+        ComplexVector w(n);
+        Matrix Z(n, n);
+        Matrix VR(n, n);
+        bool select[n];
+        std::fill(select, select + n, true);
+        int64_t m = 0;
+        LAPACKPP_CHECK(lapack::hseqr(lapack::JobSchur::Schur, lapack::Job::Vec, n, 1, n, H.data(), n, w.data(), Z.data(), n));
+        LAPACKPP_CHECK(lapack::trevc3(lapack::Sides::Right, lapack::HowMany::All, select, n, H.data(), n, nullptr, n, VR.data(), n, n, &m));
+        const Matrix X = Z * VR;
+        ComplexMatrix evecs = expandConjugatePairs(w, X);
+        evecs.colwise().normalize();
+        resultHolder = {w, evecs, n};
+    } else {
+        ComplexMatrix H = eigenMatrix;
+        ComplexVector w(n);
+        ComplexMatrix Z(n, n);
+
+        // TREVC Variables
+        bool select[n]; // Use a plain array
+        std::fill(select, select + n, true);
+
+        ComplexMatrix VR(n, n);
+        int64_t m = 0;
+
+        // Call LAPACK functions
+        LAPACKPP_CHECK(lapack::hseqr(lapack::JobSchur::Schur, lapack::Job::Vec, n, 1, n, H.data(), n, w.data(), Z.data(), n));
+        LAPACKPP_CHECK(lapack::trevc3(lapack::Sides::Right, lapack::HowMany::All, select, n, H.data(), n, nullptr, n, VR.data(), n, n, &m));
+
+        ComplexMatrix evecs = Z * VR; // Ensure ComplexMatrix is defined correctly
+
+        resultHolder = {w, evecs, n};
+    }
     return 0; // Return success
+    #endif
 }
 
 // ========================= BACKEND SOLVERS =========================
@@ -185,10 +242,15 @@ inline int RealSymmetricEigenDecomp(const MatType& A, RealEigenPairs& resultHold
     static_assert(std::is_same<typename MatType::Scalar, ComplexType>::value == false, 
                   "Only use RealSymmetricEigenDecomp for Real MatrixType");
     constexpr bool isRowMajor = MatType::IsRowMajor;
+    #ifndef LAPACK_EIGSOLVER
+    Eigen::SelfAdjointEigenSolver<Matrix> solver(A.template selfadjointView<Eigen::Upper>());
+    resultHolder = {solver.eigenvalues(), solver.eigenvectors(), N};
+    #else
     MatType H = A;
     Vector w(N);
     LAPACKPP_CHECK(lapack::syev(lapack::Job::Vec, lapack::Uplo::Upper, N, H.data(), N, w.data()));
     resultHolder = {w, H, N};
+    #endif
     return 0;
 }
 
@@ -197,10 +259,15 @@ inline int HermitianEigenDecomp(const MatType& A, MixedEigenPairs& resultHolder,
     static_assert(std::is_same<typename MatType::Scalar, ComplexType>::value == true, 
                   "Only use HermitianEigenDecomp for Complex MatrixType");
     constexpr bool isRowMajor = MatType::IsRowMajor;
+    #ifndef LAPACK_EIGSOLVER
+    Eigen::SelfAdjointEigenSolver<ComplexMatrix> solver(A.template selfadjointView<Eigen::Upper>());
+    resultHolder = {solver.eigenvalues(), solver.eigenvectors(), N};
+    #else
     MatType H = A;
     Vector w(N);
     LAPACKPP_CHECK(lapack::heev(lapack::Job::Vec, lapack::Uplo::Upper, N, H.data(), N, w.data()));
     resultHolder = {w, H, N};
+    #endif
     return 0;
 }
 
@@ -57,13 +57,6 @@ private:
         d_result = cudaMallocChecked<D>(N_ * PREC_SIZE);
         d_h = cudaMallocChecked<D>((N + 1) * N * PREC_SIZE);
 
-        #ifdef CUBLAS_RESTART
-        d_Q = cudaMallocChecked<DeviceComplexType>((batch_count + 1) * N_squared * sizeof(DeviceComplexType));
-        std::vector<DeviceComplexType*> h_Tauarray(batch_count);
-        d_tau = cudaMallocChecked<DeviceComplexType>(batch_count * N * sizeof(DeviceComplexType));
-        for (size_t i = 0; i < N - S; ++i) { h_Tauarray[i] = d_tau + i * N; }
-        #endif    
-
         q_h_.Q = ComplexMatrix::Zero(M_.rows(), S);
         q_h_.H = ComplexMatrix::Zero(S, S);
     }
@@ -76,11 +69,6 @@ private:
         cudaFreeChecked(d_result);
         cudaFreeChecked(d_h);
 
-        #ifdef CUBLAS_RESTART
-        cudaFreeChecked(d_Q);
-        cudaFreeChecked(d_tau);
-        #endif
-
         cublasDestroy(handle_);
         cusolverDnDestroy(solver_handle_);
     }
@@ -157,11 +145,6 @@ private:
     D* d_M;
     D* d_result;
     D* d_h;
-    
-    #ifdef CUBLAS_RESTART
-    DeviceComplexType* d_Q;
-    DeviceComplexType* d_tau;
-    #endif
 };
 
 // Type Specialization for Hermitian Matrices (Real Evals, Complex Evecs)
@@ -203,12 +186,6 @@ public:
 template <typename M, size_t T, size_t N, size_t S>
 using IRAM = IRAMEigen<M, DeviceComplexType, ComplexVector, ComplexMatrix, T, N, S, matrix_type::REGULAR>;
 
-// USE IRAMHermitian for Hermitian matrices
-template <typename M, size_t T, size_t N, size_t S>
-using IRAMHermitian = IRAMEigen<M, DeviceComplexType, Vector, ComplexMatrix, T, N, S, matrix_type::SELFADJOINT>;
-
-//USE IRAMSymmetric for Real Symmetric matrices
-template <typename M, size_t T, size_t N, size_t S>
-using IRAMSymmetric = IRAMEigen<M, DeviceComplexType, Vector, Matrix, T, N, S, matrix_type::SELFADJOINT>;
+// IRAMHermitian / IRAMSymmetric moved to lanczos.hpp, they run thick-restart Lanczos instead of full Arnoldi
 
 #endif // ARNOLDI_EIGEN_HPP
\ No newline at end of file
@@ -0,0 +1,264 @@
+// Thick-restart Lanczos (Wu & Simon) for Hermitian and real symmetric operators. The projected matrix is real symmetric:
+// tridiagonal, plus one arrow row coupling the kept Ritz vectors to the first new Lanczos vector after a restart. Each
+// step orthogonalizes against the previous two basis vectors only, so a step costs two inner products and two updates
+// instead of Arnoldi's j, and the projected eigenproblem is a real symmetric one with real Ritz values.
+// Plain three-term Lanczos loses orthogonality as soon as a Ritz pair converges (ghost copies of it appear), so the
+// level of orthogonality is tracked with Simon's omega recurrence and the basis is re-orthogonalized only when it
+// drops below sqrt(eps) (partial reorthogonalization). full_reorth forces it every step.
+#ifndef LANCZOS_HPP
+#define LANCZOS_HPP
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "IRAM.hpp"
+#include "arena.hpp"
+#include "selfadjoint.hpp"
+
+template <typename S = ComplexType, typename BK = DefaultBackend>
+class LanczosSolver {
+public:
+    using OM = std::conditional_t<is_complex_v<S>, ComplexMatrix, Matrix>;
+    using DS = typename BasisTraits<OM>::DS;
+    using PairType = std::conditional_t<is_complex_v<S>, MixedEigenPairs, RealEigenPairs>;
+    static constexpr size_t ALLOC_SIZE = sizeof(DS);
+
+    explicit LanczosSolver(const SolverConfig& config = {}) : config_(config), arena_(0, config.huge_pages) {
+        if (config_.rows) {reserve(config_.rows, config_.basis_size);}
+    }
+    LanczosSolver(const LanczosSolver&) = delete;
+    LanczosSolver& operator=(const LanczosSolver&) = delete;
+    ~LanczosSolver() { release(); }
+
+    inline const SolverConfig& config() const { return config_; }
+    inline void configure(const SolverConfig& config) { config_ = config; }
+    inline size_t workspaceAllocations() const { return allocations_ + arena_.blockAllocations(); }
+
+    void reserve(size_t N, size_t B) {
+        const size_t C = std::min(config_.restart_size, B);
+        ensure(d_V_, N * (B + 1));
+        ensure(d_coef_, B + 1);
+        ensure(d_Y_, B * C);
+        ensure(d_tmp_, N * C);
+        arena_.reset();
+        arena_.reserve(hostFootprint(N, B, C));
+        if (eig_size_ != B) {
+            eig_ = Eigen::SelfAdjointEigenSolver<Matrix>(B);
+            eig_size_ = B;
+        }
+    }
+
+    inline size_t reorthogonalizations() const { return reorths_; } // Full Gram-Schmidt sweeps in the last solve
+
+    // Host arena bytes: start vector, projected matrix, coefficients, Ritz selection, kept Ritz vectors, omega rows
+    static size_t hostFootprint(size_t N, size_t B, size_t C) {
+        return WorkspaceArena::footprint<S>(N) + WorkspaceArena::footprint<HostPrecision>(B * B)
+             + WorkspaceArena::footprint<S>(B + 1) + WorkspaceArena::footprint<size_t>(B)
+             + WorkspaceArena::footprint<S>(B * C) + 3 * WorkspaceArena::footprint<HostPrecision>(B + 1);
+    }
+
+    // Hermitian/symmetric M only, nothing checks it. Returns the num_pairs Ritz pairs of largest magnitude
+    template <typename M>
+    PairType solve(const M& M_, typename BK::BlasHandle& handle, KrylovStats* stats = nullptr) {
+        static_assert(std::is_same_v<typename BasisTraits<M>::S, S>, "LanczosSolver scalar must match the operator scalar.");
+        const size_t N = M_.rows();
+        const size_t B = config_.basis_size;
+        const size_t C = config_.restart_size;
+        if (C == 0 || C >= B || B >= N) {
+            throw std::invalid_argument("LanczosSolver needs 0 < restart_size < basis_size < rows, got " + std::to_string(C)
+                                        + ", " + std::to_string(B) + ", " + std::to_string(N));
+        }
+        const size_t nev = std::min(config_.num_pairs, C);
+        const HostPrecision matnorm = operatorNorm(M_);
+        const HostPrecision tol = config_.tol * matnorm;
+        KrylovStats local_stats;
+        KrylovStats& st = stats ? *stats : local_stats;
+        st = KrylovStats{};
+
+        reserve(N, B);
+        const size_t ROWS = is_linear_operator_v<M> ? 0 : BK::rowAlloc(N);
+        ensure(d_M_, ROWS * N);
+        DS* d_V = d_V_.ptr;
+        DS* d_coef = d_coef_.ptr;
+
+        Eigen::Map<Eigen::Matrix<S, Eigen::Dynamic, 1>> v0(arena_.allocate<S>(N), N);
+        Eigen::Map<Matrix> T(arena_.allocate<HostPrecision>(B * B), B, B);
+        S* coef = arena_.allocate<S>(B + 1);
+        size_t* order = arena_.allocate<size_t>(B);
+        Eigen::Map<OM> Y_kept(arena_.allocate<S>(B * C), B, C);
+        // omega_prev/cur/next(i) estimate v_i^H v_{j-1}, v_i^H v_j, v_i^H v_{j+1} for the step j in flight
+        HostPrecision* omega_prev = arena_.allocate<HostPrecision>(B + 1);
+        HostPrecision* omega_cur = arena_.allocate<HostPrecision>(B + 1);
+        HostPrecision* omega_next = arena_.allocate<HostPrecision>(B + 1);
+        reorths_ = 0;
+
+        v0.setRandom();
+        v0.normalize();
+        BK::memcpy(d_V, v0.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
+        T.setZero();
+
+        const DS ONE = getOne<DS>();
+        const DS ZERO = getZero<DS>();
+        const DS NEG_ONE = getNegOne<DS>();
+        const HostPrecision eps = std::numeric_limits<HostPrecision>::epsilon();
+        const HostPrecision omega_max = std::sqrt(eps);
+        const HostPrecision omega_noise = eps * std::sqrt(static_cast<HostPrecision>(N)) * matnorm; // Rounding per step
+
+        // w -= V_{lo..j} (V_{lo..j}^H w), returns the real part of the v_j coefficient
+        auto project = [&](DS* w, size_t lo, size_t j) -> HostPrecision {
+            const size_t cnt = j - lo + 1;
+            BK::template gemv<DS>(handle, BlasOp::C, N, cnt, &ONE, d_V + lo * N, N, w, 1, &ZERO, d_coef, 1);
+            BK::template gemv<DS>(handle, BlasOp::N, N, cnt, &NEG_ONE, d_V + lo * N, N, d_coef, 1, &ONE, w, 1);
+            BK::memcpy(coef, d_coef, cnt * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+            return std::real(coef[j - lo]);
+        };
+        size_t k = 0;            // Kept Ritz vectors, columns 0..k-1 of the basis
+        size_t m = 0;            // Complete basis columns of the current cycle
+        HostPrecision beta = 0;  // Residual norm, the coupling of column m to the projected matrix
+        bool done = false;
+        bool reorth_next = false; // A partial reorthogonalization always covers two consecutive vectors
+        while (!done) {
+            for (m = k; m < B; ++m) {
+                DS* v = d_V + m * N;
+                DS* w = v + N;
+                applyOperator<M, DS, BK>(M_, d_M_.ptr, v, w, ROWS, N, N, handle);
+                st.matvecs++;
+
+                // Three-term recurrence, except right after a restart where w couples to every kept Ritz vector
+                const bool full = config_.full_reorth || m == k;
+                HostPrecision alpha = project(w, full ? 0 : m - 1, m);
+                if (full) {alpha += project(w, 0, m);}
+                T(m, m) = alpha;
+                BK::template norm<DS>(handle, N, w, 1, &beta);
+
+                // Omega recurrence: beta_j w_{j+1,i} = (T e_i)^H omega_j - alpha_j omega_{j,i} - beta_{j-1} omega_{j-1,i}
+                bool reorth = reorth_next;
+                if (!full && !reorth) {
+                    const HostPrecision beta_prev = T(m, m - 1);
+                    for (size_t i = 0; i + 1 < m; ++i) {
+                        HostPrecision t = (i < k) ? T(i, i) * omega_cur[i] + T(k, i) * omega_cur[k] : 0;
+                        if (i >= k) {
+                            for (size_t l = (i == k ? 0 : i - 1); l <= std::min(i + 1, m); ++l) {t += T(l, i) * omega_cur[l];}
+                        }
+                        t += -alpha * omega_cur[i] - beta_prev * (i + 1 < m ? omega_prev[i] : 0);
+                        t += (t >= 0 ? omega_noise : -omega_noise);
+                        omega_next[i] = t / beta;
+                        reorth |= std::abs(omega_next[i]) > omega_max;
+                    }
+                }
+                reorth_next = reorth && !reorth_next;
+                if (reorth && !full) {
+                    project(w, 0, m);
+                    project(w, 0, m);
+                    BK::template norm<DS>(handle, N, w, 1, &beta);
+                    reorths_++;
+                }
+                if (full || reorth) {std::fill(omega_next, omega_next + m + 1, eps);}
+                else {omega_next[m - 1] = omega_next[m] = eps;} // Locally orthogonalized against v_{j-1}, v_j
+                omega_next[m + 1] = 1;
+                std::swap(omega_prev, omega_cur);
+                std::swap(omega_cur, omega_next);
+
+                if (m + 1 < B) {T(m + 1, m) = T(m, m + 1) = beta;}
+                if (beta < tol) {m++; done = true; break;} // Invariant subspace, the Ritz pairs are exact
+                const DevicePrecision inv_beta = 1.0 / beta;
+                BK::template scale<DS>(handle, N, &inv_beta, w, 1);
+            }
+            st.matrix_passes = st.matvecs;
+
+            // Projected problem, Ritz values ordered by magnitude as in IRAM
+            eig_.compute(T.topLeftCorner(m, m));
+            const Vector& theta = eig_.eigenvalues();
+            const Matrix& Y = eig_.eigenvectors();
+            std::iota(order, order + m, size_t(0));
+            std::sort(order, order + m, [&theta](size_t a, size_t b) {return std::abs(theta[a]) > std::abs(theta[b]);});
+
+            // Lanczos residual ||A x_i - theta_i x_i|| = beta |e_m^T y_i|
+            size_t converged = 0;
+            for (size_t i = 0; i < nev; ++i) {converged += (beta * std::abs(Y(m - 1, order[i])) < tol);}
+            st.converged = converged;
+            if (done || converged == nev || st.matvecs + (B - C) > config_.max_iters) {break;}
+
+            // Thick restart: V_C = V_m Y_C, the residual vector becomes column C and T collapses to an arrowhead
+            for (size_t i = 0; i < C; ++i) {
+                for (size_t r = 0; r < m; ++r) {Y_kept(r, i) = Y(r, order[i]);}
+            }
+            BK::memcpy(d_Y_.ptr, Y_kept.data(), B * C * ALLOC_SIZE, MemcpyKind::HostToDevice);
+            BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, C, m, &ONE, d_V, N, d_Y_.ptr, B, &ZERO, d_tmp_.ptr, N);
+            BK::memcpy(d_V, d_tmp_.ptr, N * C * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+            BK::memcpy(d_V + C * N, d_V + m * N, N * ALLOC_SIZE, MemcpyKind::DeviceToDevice);
+            T.setZero();
+            for (size_t i = 0; i < C; ++i) {
+                T(i, i) = theta[order[i]];
+                T(i, C) = T(C, i) = beta * Y(m - 1, order[i]);
+            }
+            k = C;
+            st.restarts++;
+        }
+
+        // Ritz vectors of the wanted pairs, one gemm against the basis
+        const size_t count = std::min(nev, m);
+        PairType result{Vector(count), OM(N, count), count};
+        st.residuals.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            result.values[i] = eig_.eigenvalues()[order[i]];
+            st.residuals[i] = beta * std::abs(eig_.eigenvectors()(m - 1, order[i]));
+            for (size_t r = 0; r < m; ++r) {Y_kept(r, i) = eig_.eigenvectors()(r, order[i]);}
+        }
+        BK::memcpy(d_Y_.ptr, Y_kept.data(), B * C * ALLOC_SIZE, MemcpyKind::HostToDevice);
+        BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, count, m, &ONE, d_V, N, d_Y_.ptr, B, &ZERO, d_tmp_.ptr, N);
+        BK::memcpy(result.vectors.data(), d_tmp_.ptr, N * count * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+        restoreOrder(M_, result.vectors);
+        return result;
+    }
+
+private:
+    template <typename T>
+    struct Buffer {
+        T* ptr = nullptr;
+        size_t size = 0;
+    };
+
+    template <typename T>
+    void ensure(Buffer<T>& buf, size_t elems) {
+        if (elems <= buf.size) {return;}
+        BK::free(buf.ptr);
+        buf.ptr = BK::template malloc<T>(elems * sizeof(T));
+        buf.size = elems;
+        allocations_++;
+    }
+
+    void release() {
+        for (Buffer<DS>* b : {&d_V_, &d_coef_, &d_Y_, &d_tmp_, &d_M_}) {BK::free(b->ptr); *b = {};}
+    }
+
+    SolverConfig config_;
+    size_t allocations_ = 0;
+    size_t reorths_ = 0;
+
+    // Backend workspaces: basis, projection coefficients, kept Ritz coefficients and the restart product
+    Buffer<DS> d_V_, d_coef_, d_Y_, d_tmp_, d_M_;
+    // Host workspaces
+    WorkspaceArena arena_;
+    Eigen::SelfAdjointEigenSolver<Matrix> eig_;
+    size_t eig_size_ = 0;
+};
+
+// Fixed-size front ends in the style of IRAM: A is max iters, B is basis size, C is restart size. M is a dense matrix
+// or an operator, SymmetricMatrix / HermitianMatrix (selfadjoint.hpp) halve the memory and the bytes per matvec
+template <typename M, size_t N, size_t A, size_t B, size_t C, typename BK = DefaultBackend>
+MixedEigenPairs IRAMHermitian(const M& M_, typename BK::BlasHandle& handle, const HostPrecision& tol = default_tol) {
+    static_assert(is_complex_v<typename M::Scalar>, "IRAMHermitian takes complex Hermitian operators, use IRAMSymmetric for real ones.");
+    LanczosSolver<ComplexType, BK> solver({.rows = N, .max_iters = A, .basis_size = B, .restart_size = C, .num_pairs = C, .tol = tol});
+    return solver.solve(M_, handle);
+}
+
+template <typename M, size_t N, size_t A, size_t B, size_t C, typename BK = DefaultBackend>
+RealEigenPairs IRAMSymmetric(const M& M_, typename BK::BlasHandle& handle, const HostPrecision& tol = default_tol) {
+    static_assert(!is_complex_v<typename M::Scalar>, "IRAMSymmetric takes real symmetric operators, use IRAMHermitian for complex ones.");
+    LanczosSolver<HostPrecision, BK> solver({.rows = N, .max_iters = A, .basis_size = B, .restart_size = C, .num_pairs = C, .tol = tol});
+    return solver.solve(M_, handle);
+}
+
+#endif // LANCZOS_HPP
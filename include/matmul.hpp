@@ -7,7 +7,7 @@
 #include <cmath>
 #include <iostream>
 #include <variant>
-#include "cuda_manager.hpp"
+#include "backend.hpp"
 
 // Uncomment for debugging
 //#define DEBUG_MATMUL
@@ -64,25 +64,40 @@ struct AmbigType<ComplexVector> {
 // Convenience alias
 template <typename V>
 using AmbigType_t = typename AmbigType<V>::Type;
-template <typename M, typename S>
-inline void matmul_internal(const M& M_, S* d_M, const S* d_y, S* d_result, size_t NUM_ARRAYS, size_t L, size_t N, cublasHandle_t& handle) {
-    static_assert(std::is_same_v<typename M::Scalar, S> || 
+template <typename M, typename S, typename BK = DefaultBackend>
+inline void matmul_internal(const M& M_, S* d_M, const S* d_y, S* d_result, size_t NUM_ARRAYS, size_t L, size_t N, typename BK::BlasHandle& handle) {
+    // A real matrix under a complex basis stays real: gemvReal reads it once for both parts of the vector
+    constexpr bool realUnderComplex = std::is_same_v<typename M::Scalar, HostPrecision> && std::is_same_v<S, DeviceComplexType>;
+    static_assert(std::is_same_v<typename M::Scalar, S> || realUnderComplex ||
               (std::is_same_v<typename M::Scalar, ComplexType> && std::is_same_v<S, DeviceComplexType>), 
               "Matrix and Vector types must match.");
+    using SM = std::conditional_t<realUnderComplex, DevicePrecision, S>; // Matrix scalar as the backend sees it
     size_t idx = 0;
     constexpr bool isRowMajor = M::IsRowMajor;
     constexpr S ONE = getOne<S>();
     constexpr S ZERO = getZero<S>();
-    constexpr size_t ALLOC_SIZE = sizeof(S);
+    constexpr size_t ALLOC_SIZE = sizeof(SM);
     // std::cout << L << " " << N << std::endl;
     size_t& iterIndSize = (isRowMajor) ? L : N;
     size_t& axisArraySize = (isRowMajor) ? N : L;
+    auto gemv = [&](int m, int n, const SM* A, int lda, const S* x, S* y) {
+        if constexpr (realUnderComplex) {BK::template gemvReal<S>(handle, isRowMajor ? BlasOp::T : BlasOp::N, m, n, &ONE, A, lda, x, 1, &ZERO, y, 1);}
+        else {BK::template gemv<S>(handle, isRowMajor ? BlasOp::T : BlasOp::N, m, n, &ONE, A, lda, x, 1, &ZERO, y, 1);}
+    };
     
+    // Host-resident backends read the operator in place, a single gemv over the whole matrix
+    if constexpr (BK::HOST_RESIDENT) {
+        const SM* h_M = reinterpret_cast<const SM*>(M_.data());
+        gemv(isRowMajor ? N : L, isRowMajor ? L : N, h_M, isRowMajor ? N : L, d_y, d_result);
+        return;
+    }
 
+    // The staging buffer is sized in S, a real block fits with room to spare
+    SM* d_Ms = reinterpret_cast<SM*>(d_M);
 while (idx < (isRowMajor ? L : N)) {
     size_t selectedElements = std::min(NUM_ARRAYS, (isRowMajor ? L : N) - idx);
-    cudaMemcpyChecked(d_M, M_.data() + idx * (isRowMajor ? N : L), selectedElements * (isRowMajor ? N : L) * ALLOC_SIZE, cudaMemcpyKind::cudaMemcpyHostToDevice);
-    cublas::gemv<S>(handle, isRowMajor ? CUBLAS_OP_T : CUBLAS_OP_N, isRowMajor ? N : L, selectedElements, &ONE, d_M, isRowMajor ? N : L, isRowMajor ? d_y : d_y + idx, 1, &ZERO, isRowMajor ? d_result + idx : d_result, 1);
+    BK::memcpy(d_Ms, M_.data() + idx * (isRowMajor ? N : L), selectedElements * (isRowMajor ? N : L) * ALLOC_SIZE, MemcpyKind::HostToDevice);
+    gemv(isRowMajor ? N : L, selectedElements, d_Ms, isRowMajor ? N : L, isRowMajor ? d_y : d_y + idx, isRowMajor ? d_result + idx : d_result);
     #ifdef DEBUG_MATMUL
     dbg_check<S>(d_M, d_y, d_result, selectedElements, idx, N, L, isRowMajor);
     #endif
@@ -91,13 +106,14 @@ while (idx < (isRowMajor ? L : N)) {
 
     }
 
-template <typename M, typename V>
+template <typename M, typename V, typename BK = DefaultBackend>
 typename AmbigType<V>::Type matmul(const M& M_, const V& y, 
                  const CuRetType retType) {
-    using S = typename M::Scalar;
+    using S = typename V::Scalar;
     using DS = std::conditional_t<std::is_same_v<S, DevicePrecision>, DevicePrecision, DeviceComplexType>;
     constexpr size_t ALLOC_SIZE = sizeof(DS);
-    static_assert(std::is_same<typename M::Scalar, typename V::Scalar>::value && "Matrix and Vector types must match."); //Temp until I add some casting logic
+    static_assert(std::is_same_v<typename M::Scalar, S> || (std::is_same_v<typename M::Scalar, HostPrecision> && std::is_same_v<S, ComplexType>),
+                  "Matrix and Vector types must match, or a real matrix times a complex vector.");
     // CHECK_DIMS(M_, y);
     size_t N = 0, L = 0;
     
@@ -110,26 +126,26 @@ typename AmbigType<V>::Type matmul(const M& M_, const V& y,
     #endif
 
     size_t iterIndSize = (M::IsRowMajor) ? N : L;
-    size_t MAX_ALLOC = DYNAMIC_ROW_ALLOC(iterIndSize);
+    size_t MAX_ALLOC = BK::rowAlloc(iterIndSize);
 
-    DS* d_M = cudaMallocChecked<DS>(MAX_ALLOC * iterIndSize * ALLOC_SIZE);
-    DS* d_y = cudaMallocChecked<DS>(N * ALLOC_SIZE);
-    DS* d_result = cudaMallocChecked<DS>(L * ALLOC_SIZE);
+    DS* d_M = BK::template malloc<DS>(MAX_ALLOC * iterIndSize * ALLOC_SIZE);
+    DS* d_y = BK::template malloc<DS>(N * ALLOC_SIZE);
+    DS* d_result = BK::template malloc<DS>(L * ALLOC_SIZE);
 
-    cublasHandle_t handle;
-    cublasCreate(&handle);
+    typename BK::BlasHandle handle;
+    BK::createHandle(handle);
 
-    cudaMemcpyChecked(d_y, y.data(), N * ALLOC_SIZE, cudaMemcpyKind::cudaMemcpyHostToDevice);
-    matmul_internal<M, DS>(M_, d_M, d_y, d_result, MAX_ALLOC, L, N, handle);
+    BK::memcpy(d_y, y.data(), N * ALLOC_SIZE, MemcpyKind::HostToDevice);
+    matmul_internal<M, DS, BK>(M_, d_M, d_y, d_result, MAX_ALLOC, L, N, handle);
     
-    cudaFree(d_M);
-    cudaFree(d_y);
-    cublasDestroy(handle);
+    BK::free(d_M);
+    BK::free(d_y);
+    BK::destroyHandle(handle);
 
     if (retType == CuRetType::HOST) {
         V h_result(L);
-        cudaMemcpyChecked(h_result.data(), d_result, L * ALLOC_SIZE, cudaMemcpyDeviceToHost);
-        cudaFree(d_result);
+        BK::memcpy(h_result.data(), d_result, L * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+        BK::free(d_result);
         return h_result;
     } else {
         return d_result;
@@ -146,7 +162,7 @@ inline auto matmulDevice(const M& M_, const V& y) {
     } else if constexpr (std::is_same_v<typename M::Scalar, DeviceComplexType>) {
         return std::get<DeviceComplexType*>(matmul<M, V>(M_, y, CuRetType::DEVICE));
     } else {
-        static_assert(false, "Matrix type must have DevicePrecision or DeviceComplexType scalar");
+        static_assert(!std::is_same_v<M, M>, "Matrix type must have DevicePrecision or DeviceComplexType scalar");
     }
 }
 #endif // MATMUL_HPP
\ No newline at end of file
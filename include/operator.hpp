@@ -0,0 +1,152 @@
+// Matrix-free operator interface for the Arnoldi matvec. Anything exposing Scalar, rows(), cols() and
+// apply(x, y) can stand in for the dense matrix in KrylovIterInternal, KrylovIter, NaiveArnoldi and IRAM.
+#ifndef OPERATOR_HPP
+#define OPERATOR_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "vector.hpp"
+#include "backend.hpp"
+#include "matmul.hpp"
+
+// apply(x, y) computes y = A x on backend memory (host memory for CpuBackend, device memory for CudaBackend)
+template <typename Op>
+concept LinearOperator = requires(const Op& op, const typename Op::Scalar* x, typename Op::Scalar* y) {
+    typename Op::Scalar;
+    { op.rows() } -> std::convertible_to<size_t>;
+    { op.cols() } -> std::convertible_to<size_t>;
+    { op.apply(x, y) };
+};
+
+template <typename Op>
+concept NormedOperator = LinearOperator<Op> && requires(const Op& op) {
+    { op.norm() } -> std::convertible_to<HostPrecision>;
+};
+
+template <typename M>
+constexpr bool is_linear_operator_v = LinearOperator<M>;
+
+// Operators that run their own thread team (0 := OpenMP default). The count is an execution setting, so it can be
+// changed on a const operator, e.g. by a solver that runs the matvec next to other work
+template <typename Op>
+concept ThreadedOperator = LinearOperator<Op> && requires(const Op& op, int num_threads) {
+    { op.numThreads() } -> std::convertible_to<int>;
+    { op.setNumThreads(num_threads) };
+};
+
+// Breakdown tolerance is relative to ||A||. Dense matrices report Frobenius norm, operators only if they provide norm()
+template <typename M>
+inline HostPrecision operatorNorm(const M& M_) {
+    if constexpr (!is_linear_operator_v<M> || NormedOperator<M>) {return static_cast<HostPrecision>(M_.norm());}
+    else {return HostPrecision(1);}
+}
+
+// Operators solved in a permuted basis (reorder.hpp) map Ritz vectors back to the caller's ordering before returning
+template <typename Op>
+concept ReorderedOperator = LinearOperator<Op> && requires(const Op& op, ComplexMatrix& V) {
+    { op.restoreOrder(V) };
+};
+
+template <typename M, typename MatrixType>
+inline void restoreOrder(const M& M_, MatrixType& vectors) {
+    if constexpr (ReorderedOperator<M>) {M_.restoreOrder(vectors);}
+}
+
+// Single dispatch point for the Krylov step: dense Eigen matrices go through matmul_internal, operators through apply
+template <typename M, typename DS, typename BK = DefaultBackend>
+inline void applyOperator(const M& M_, DS* d_M, const DS* d_y, DS* d_result, size_t ROWS, size_t N, size_t L, typename BK::BlasHandle& handle) {
+    if constexpr (is_linear_operator_v<M>) {
+        using S = typename M::Scalar;
+        static_assert(sizeof(S) == sizeof(DS), "Operator scalar must match the basis scalar layout.");
+        M_.apply(reinterpret_cast<const S*>(d_y), reinterpret_cast<S*>(d_result));
+    } else {
+        matmul_internal<M, DS, BK>(M_, d_M, d_y, d_result, ROWS, N, L, handle);
+    }
+}
+
+// Multi-vector application, Y = A X for p column-major vectors. Lets block methods stream the operator once per block
+template <typename Op>
+concept BlockOperator = LinearOperator<Op> && requires(const Op& op, const typename Op::Scalar* X, typename Op::Scalar* Y, size_t p) {
+    { op.applyBlock(X, Y, p) };
+};
+
+// Block counterpart of applyOperator: one gemm for resident dense matrices, applyBlock for block operators, otherwise p
+// single matvecs (device-staged dense matrices, and real matrices under a complex basis, go through matmul_internal
+// column by column)
+template <typename M, typename DS, typename BK = DefaultBackend>
+inline void applyOperatorBlock(const M& M_, DS* d_M, const DS* d_X, DS* d_Y, size_t ROWS, size_t N, size_t L, size_t p, typename BK::BlasHandle& handle) {
+    if constexpr (BlockOperator<M>) {
+        using S = typename M::Scalar;
+        static_assert(sizeof(S) == sizeof(DS), "Operator scalar must match the basis scalar layout.");
+        M_.applyBlock(reinterpret_cast<const S*>(d_X), reinterpret_cast<S*>(d_Y), p);
+    } else if constexpr (!is_linear_operator_v<M> && BK::HOST_RESIDENT &&
+                         !(std::is_same_v<typename M::Scalar, HostPrecision> && std::is_same_v<DS, DeviceComplexType>)) {
+        constexpr bool isRowMajor = M::IsRowMajor;
+        const DS ONE = getOne<DS>();
+        const DS ZERO = getZero<DS>();
+        const DS* h_M = reinterpret_cast<const DS*>(M_.data());
+        BK::template gemm<DS>(handle, isRowMajor ? BlasOp::T : BlasOp::N, BlasOp::N, N, p, L, &ONE, h_M, isRowMajor ? L : N,
+                              d_X, L, &ZERO, d_Y, N);
+    } else {
+        for (size_t c = 0; c < p; ++c) {applyOperator<M, DS, BK>(M_, d_M, d_X + c * L, d_Y + c * N, ROWS, N, L, handle);}
+    }
+}
+
+// ==================== ADAPTORS ====================
+
+// Wraps any callable f(const S* x, S* y) (stencils, Jacobian-vector products, ...)
+template <typename S, typename F>
+class FunctionOperator {
+public:
+    using Scalar = S;
+
+    FunctionOperator(size_t rows, size_t cols, F f, HostPrecision norm_estimate = 1)
+        : rows_(rows), cols_(cols), f_(std::move(f)), norm_(norm_estimate) {}
+
+    inline size_t rows() const { return rows_; }
+    inline size_t cols() const { return cols_; }
+    inline HostPrecision norm() const { return norm_; }
+    inline void apply(const S* x, S* y) const { f_(x, y); }
+
+private:
+    size_t rows_, cols_;
+    F f_;
+    HostPrecision norm_;
+};
+
+template <typename S, typename F>
+inline FunctionOperator<S, F> makeOperator(size_t rows, size_t cols, F f, HostPrecision norm_estimate = 1) {
+    return FunctionOperator<S, F>(rows, cols, std::move(f), norm_estimate);
+}
+
+// A * B applied right to left through a backend scratch vector, nothing is ever formed densely
+template <LinearOperator A, LinearOperator B, typename BK = DefaultBackend>
+class ProductOperator {
+public:
+    using Scalar = typename A::Scalar;
+    static_assert(std::is_same_v<typename A::Scalar, typename B::Scalar>, "Composed operators must share a scalar type.");
+
+    ProductOperator(const A& a, const B& b) : a_(a), b_(b) {
+        if (a_.cols() != b_.rows()) {throw std::invalid_argument(invalid_dims_msg(a_.cols(), a_.rows(), b_.cols(), b_.rows()));}
+        scratch_ = BK::template malloc<Scalar>(b_.rows() * sizeof(Scalar));
+    }
+    ProductOperator(const ProductOperator&) = delete;
+    ProductOperator& operator=(const ProductOperator&) = delete;
+    ~ProductOperator() { BK::free(scratch_); }
+
+    inline size_t rows() const { return a_.rows(); }
+    inline size_t cols() const { return b_.cols(); }
+    inline void apply(const Scalar* x, Scalar* y) const {
+        b_.apply(x, scratch_);
+        a_.apply(scratch_, y);
+    }
+
+private:
+    const A& a_;
+    const B& b_;
+    Scalar* scratch_ = nullptr;
+};
+
+#endif // OPERATOR_HPP
@@ -0,0 +1,199 @@
+// Pipelined Arnoldi. A standard step is a chain: matvec, projection (a global reduction), norm, scale, and only then the
+// next matvec. Here the step works on u = A q_j, which is already available, and the next matvec t = A u starts on a
+// worker lane at the same time as the projection
+//     [h; u^H u] = Q_{j+2}^H u      (one reduction, the norm comes from the same sweep)
+// Then beta = sqrt(u^H u - ||h||^2), q_{j+1} = (u - Q h) / beta, and the next step's input follows by linearity:
+//     A q_{j+1} = (t - A Q h) / beta = (t - Q_{j+2} H_{j+2,j+1} h) / beta,
+// with no new matvec. Both updates share one sweep (BK::pipelinedOrthonormalize), and the normalization scalar stays in
+// d_h. The recurrence amplifies the error already in u by roughly ||A|| / beta per step. The driver tracks that growth and
+// recomputes A q_{j+1} directly once it exceeds PIPELINE_MAX_DRIFT rounding units. When the Pythagorean norm cancels,
+// the step reorthogonalizes as fused CGS2 does and the recurrence runs with the corrected coefficients.
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "arnoldi.hpp"
+
+// Rounding-error growth (in units of eps ||A||) tolerated in the recurrence for A q before a direct matvec resets it
+constexpr HostPrecision PIPELINE_MAX_DRIFT = 1e4;
+
+// Persistent worker threads, one per lane, the host counterpart of CUDA streams. Each lane runs its tasks in launch
+// order, with at most one in flight. A task that throws is rethrown by synchronize
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t lanes = 1) {
+        lanes_.reserve(lanes);
+        for (size_t l = 0; l < lanes; ++l) {
+            lanes_.push_back(std::make_unique<Lane>());
+            lanes_.back()->thread = std::thread(&WorkerPool::workerLoop, lanes_.back().get());
+        }
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        for (auto& lane : lanes_) {
+            synchronizeNoThrow(*lane);
+            lane->stop.store(true);
+            lane->launched.fetch_add(1);
+            lane->launched.notify_one();
+            lane->thread.join();
+        }
+    }
+
+    inline size_t size() const { return lanes_.size(); }
+
+    // Queues task on lane and returns at once, after waiting for the lane's previous task. Tasks capturing no more than
+    // two pointers fit std::function's inline buffer, so launching them does not allocate
+    void launch(size_t lane, std::function<void()> task) {
+        Lane& l = *lanes_[lane];
+        synchronize(lane);
+        l.task = std::move(task);
+        l.launched.fetch_add(1);
+        l.launched.notify_one();
+    }
+
+    // Blocks until the lane is idle
+    void synchronize(size_t lane) {
+        Lane& l = *lanes_[lane];
+        synchronizeNoThrow(l);
+        if (l.error) {std::rethrow_exception(std::exchange(l.error, nullptr));}
+    }
+
+private:
+    struct Lane {
+        std::function<void()> task;
+        std::exception_ptr error;
+        std::atomic<size_t> launched{0};
+        std::atomic<size_t> finished{0};
+        std::atomic<bool> stop{false};
+        std::thread thread;
+    };
+
+    static void synchronizeNoThrow(Lane& l) {
+        const size_t target = l.launched.load();
+        for (size_t f; (f = l.finished.load()) != target;) {l.finished.wait(f);}
+    }
+
+    static void workerLoop(Lane* l) {
+        size_t seen = 0;
+        while (true) {
+            for (size_t p; (p = l->launched.load()) == seen;) {l->launched.wait(p);}
+            seen = l->launched.load();
+            if (l->stop.load()) {return;}
+            try {l->task();} catch (...) {l->error = std::current_exception();}
+            l->finished.store(seen);
+            l->finished.notify_all();
+        }
+    }
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+};
+
+// Sets a ThreadedOperator's thread count for one scope and restores the caller's setting, a no-op when !ENABLED
+template <typename M, bool ENABLED = ThreadedOperator<M>>
+class ScopedOperatorThreads {
+public:
+    ScopedOperatorThreads(const M& op, int num_threads) : op_(op) {
+        if constexpr (ENABLED) {
+            saved_ = op_.numThreads();
+            op_.setNumThreads(num_threads);
+        }
+    }
+    ~ScopedOperatorThreads() {if constexpr (ENABLED) {op_.setNumThreads(saved_);}}
+    ScopedOperatorThreads(const ScopedOperatorThreads&) = delete;
+    ScopedOperatorThreads& operator=(const ScopedOperatorThreads&) = delete;
+
+private:
+    const M& op_;
+    int saved_ = 0;
+};
+
+// Drop-in for KrylovIterDynamic on square operators (same buffers and results): one reduction per step, overlapped
+// with the next step's matvec on lane 0 of pool. d_h must carry the subdiagonal of restarted columns, as IRAMSolver
+// leaves it. On the CPU backend the projection runs on a quarter of the handle's threads and the matvec on the rest,
+// including operators with their own thread count (ThreadedOperator), which get the rest for the duration of the call.
+// Device backends launch the matvec inline, since one cuBLAS handle must not be driven from two host threads. They still
+// save the norm reduction and the scalar read that sits between every projection and matvec
+template <typename M, typename DS, typename BK = DefaultBackend>
+int PipelinedKrylovIterDynamic(const M& M_, DS* d_M, DS* d_evecs, DS* d_h, HostPrecision* norms, const size_t& ROWS, size_t N,
+                               size_t num_iters, size_t first_ind, WorkerPool& pool, typename BK::BlasHandle& handle,
+                               const HostPrecision& matnorm = 1, const HostPrecision& tol = 1e-5, DS* d_work = nullptr,
+                               KrylovStats* stats = nullptr) {
+    using S = BasisScalar<DS>;
+    constexpr BlasOp ADJ = is_complex_v<S> ? BlasOp::C : BlasOp::T;
+    const DS ONE = getOne<DS>();
+    const DS ZERO = getZero<DS>();
+    const size_t ld = num_iters + 1;
+    assert(d_work && "Pipelined Arnoldi needs num_iters + 1 scalars of backend scratch");
+
+    typename BK::BlasHandle reduce_handle = handle, apply_handle = handle;
+    int apply_threads = 0;
+    if constexpr (BK::HOST_RESIDENT) {
+        const int threads = cpublas::threadCount(handle);
+        reduce_handle.num_threads = std::max(1, threads / 4);
+        apply_handle.num_threads = apply_threads = std::max(1, threads - reduce_handle.num_threads);
+    }
+    ScopedOperatorThreads<M, BK::HOST_RESIDENT && ThreadedOperator<M>> op_threads(M_, apply_threads);
+    auto column = [&](size_t c) { return d_evecs + c * N; };
+
+    // u_j = A q_j goes to column j + 1, where the step turns it into q_{j+1}
+    applyOperator<M, DS, BK>(M_, d_M, column(first_ind), column(first_ind + 1), ROWS, N, N, handle);
+    HostPrecision drift = 1, growth = 0; // Error level of u in rounding units, largest ||A q|| seen so far
+
+    struct Pending {
+        const M* op;
+        DS* d_M;
+        DS* x;
+        size_t ROWS, N;
+        typename BK::BlasHandle* handle;
+    } pending{&M_, d_M, nullptr, ROWS, N, &apply_handle};
+    auto advance = [p = &pending] { applyOperator<M, DS, BK>(*p->op, p->d_M, p->x, p->x + p->N, p->ROWS, p->N, p->N, *p->handle); };
+
+    for (size_t j = first_ind; j < num_iters; ++j) {
+        const bool next = j + 1 < num_iters;
+        if (next) {
+            pending.x = column(j + 1);
+            if constexpr (BK::HOST_RESIDENT) {pool.launch(0, advance);}
+            else {advance();}
+        }
+        BK::template gemv<DS>(reduce_handle, ADJ, N, j + 2, &ONE, d_evecs, N, column(j + 1), 1, &ZERO, d_h + j * ld, 1);
+        if (stats) {stats->reductions++;}
+        if (next && BK::HOST_RESIDENT) {pool.synchronize(0);}
+
+        bool again = false, advanced = false;
+        HostPrecision projected = 0;
+        const HostPrecision beta = BK::template pipelinedOrthonormalize<DS>(handle, d_evecs, d_h, d_work, N, num_iters, j, next,
+                                                                            &projected, &again, &advanced);
+        norms[j] = beta;
+        if (stats) {
+            stats->reductions += again;
+            stats->reorthogonalizations += again;
+        }
+        if (beta < tol * matnorm) {
+            if (stats && next) {stats->matvecs++; stats->matrix_passes++;} // The overlapped product is never used
+            return static_cast<int>(j + 1);
+        }
+        growth = std::max(growth, projected);
+        drift = drift * growth / beta + 1;
+        if (next && (!advanced || drift > PIPELINE_MAX_DRIFT)) {
+            // The overlapped product is discarded and A q_{j+1} taken directly
+            applyOperator<M, DS, BK>(M_, d_M, column(j + 1), column(j + 2), ROWS, N, N, handle);
+            drift = 1;
+            if (stats) {
+                stats->pipeline_refreshes++;
+                stats->matvecs++;
+                stats->matrix_passes++;
+            }
+        }
+    }
+    return static_cast<int>(num_iters);
+}
+
+#endif // PIPELINE_HPP
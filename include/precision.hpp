@@ -0,0 +1,284 @@
+// Reduced-precision operator storage. A dense matvec streams every matrix element once and is bound by memory bandwidth,
+// so storing A in float (4 bytes), bfloat16 or IEEE half (2 bytes) instead of double cuts the bytes per matvec by 2-4x
+// (4-8x for complex). ReducedMatrix keeps A row-major in the storage type, widens each element in registers and
+// accumulates in double, so the only error is the one made once when A is rounded. storageError() reports it: Ritz pairs
+// converge for the stored matrix, and their residuals against the original A level off at about storageError() ||A||.
+#ifndef PRECISION_HPP
+#define PRECISION_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include "vector.hpp"
+#include "backend.hpp"
+
+// Storage-only 16-bit formats, converted through float. The PRECISION_FLOAT16 build of vector.hpp needs <stdfloat> and
+// cuda_fp16.h for a half-precision HostPrecision, these are plain bit containers and work with any compiler
+struct bfloat16 { uint16_t bits; }; // 8 exponent, 7 mantissa bits: float's range, about 3 significant digits
+struct float16 { uint16_t bits; };  // IEEE binary16, 5 exponent, 10 mantissa bits: range 6e-8 .. 65504
+
+inline float widen(float v) { return v; }
+inline float widen(bfloat16 v) { return std::bit_cast<float>(uint32_t(v.bits) << 16); }
+// Branch-free so the matvec loop vectorizes: the exponent is rebiased by one multiply, which also handles subnormals
+inline float widen(float16 v) {
+    const uint32_t magnitude = uint32_t(v.bits & 0x7fff) << 13;
+    float f = std::bit_cast<float>(magnitude) * 0x1p112f;
+    if (magnitude >= 0x0f800000) {f = std::bit_cast<float>(magnitude | 0x7f800000);} // Inf, NaN
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(f) | (uint32_t(v.bits & 0x8000) << 16));
+}
+
+// Single-precision counterpart of a basis scalar
+template <typename S>
+using SingleScalar = std::conditional_t<is_complex_v<S>, std::complex<float>, float>;
+
+// Round to nearest, ties to even
+template <typename T>
+inline T narrow(double v) {
+    const float f = static_cast<float>(v);
+    if constexpr (std::is_same_v<T, float>) {
+        return f;
+    } else if constexpr (std::is_same_v<T, bfloat16>) {
+        const uint32_t bits = std::bit_cast<uint32_t>(f);
+        if (std::isnan(f)) {return {uint16_t((bits >> 16) | 0x40)};}
+        return {uint16_t((bits + 0x7fff + ((bits >> 16) & 1)) >> 16)};
+    } else {
+        static_assert(std::is_same_v<T, float16>, "Storage type must be float, bfloat16 or float16.");
+        // Adding a power of two aligned to the half-precision ulp lets the float adder do the rounding (FP16 library)
+        const uint32_t w = std::bit_cast<uint32_t>(f);
+        const uint32_t shl1_w = w + w;
+        const uint32_t sign = w & 0x80000000u;
+        const uint32_t bias = std::max<uint32_t>(shl1_w & 0xff000000u, 0x71000000u);
+        float base = (std::fabs(f) * 0x1p112f) * 0x1p-110f;
+        base = std::bit_cast<float>((bias >> 1) + 0x07800000u) + base;
+        const uint32_t bits = std::bit_cast<uint32_t>(base);
+        const uint32_t nonsign = ((bits >> 13) & 0x7c00u) + (bits & 0x0fffu);
+        return {uint16_t((sign >> 16) | (shl1_w > 0xff000000u ? 0x7e00u : nonsign))};
+    }
+}
+
+// T := storage type (float, bfloat16, float16), S := vector scalar. Complex matrices are stored as separate real and
+// imaginary planes, and apply() splits x the same way once per call, so every inner loop is a unit-stride real FMA sweep
+template <typename T, typename S = HostPrecision>
+class ReducedMatrix {
+public:
+    using Scalar = S;
+    using StorageType = T;
+    static constexpr bool COMPLEX = is_complex_v<S>;
+
+    ReducedMatrix() = default;
+
+    template <typename MatrixType>
+    explicit ReducedMatrix(const MatrixType& A) {assign(A);}
+
+    // Rounds A into the existing storage, which only grows, so a kept copy can follow a matrix across solves
+    template <typename MatrixType>
+    void assign(const MatrixType& A) {
+        static_assert(COMPLEX || !is_complex_v<typename MatrixType::Scalar>, "A complex matrix needs a complex vector scalar.");
+        rows_ = A.rows();
+        cols_ = A.cols();
+        re_.resize(rows_ * cols_);
+        if constexpr (COMPLEX) {
+            im_.resize(rows_ * cols_);
+            x_split_.resize(2 * cols_);
+        }
+        double norm = 0, error = 0;
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {
+                const S a = static_cast<S>(A(i, j));
+                re_[i * cols_ + j] = narrow<T>(std::real(a));
+                if constexpr (COMPLEX) {im_[i * cols_ + j] = narrow<T>(std::imag(a));}
+                norm += std::norm(a);
+                error += std::norm(a - at(i, j));
+            }
+        }
+        norm_ = std::sqrt(norm);
+        error_ = norm > 0 ? std::sqrt(error / norm) : 0;
+    }
+
+    inline size_t rows() const { return rows_; }
+    inline size_t cols() const { return cols_; }
+    inline HostPrecision norm() const { return static_cast<HostPrecision>(norm_); } // Of the original matrix
+    // ||A - stored A||_F / ||A||_F, the relative residual floor of pairs computed from the stored matrix
+    inline HostPrecision storageError() const { return static_cast<HostPrecision>(error_); }
+    inline size_t bytes() const { return (re_.size() + im_.size()) * sizeof(T); }
+    // 0 := OpenMP default
+    inline void setNumThreads(int num_threads) const { handle_.num_threads = num_threads; }
+    inline int numThreads() const { return handle_.num_threads; }
+
+    // Stored element, widened
+    inline S at(size_t i, size_t j) const {
+        if constexpr (COMPLEX) {return S(widen(re_[i * cols_ + j]), widen(im_[i * cols_ + j]));}
+        else {return static_cast<S>(widen(re_[i * cols_ + j]));}
+    }
+
+    template <typename MatrixType = std::conditional_t<COMPLEX, ComplexMatrix, Matrix>>
+    MatrixType toDense() const {
+        MatrixType D(rows_, cols_);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {D(i, j) = at(i, j);}
+        }
+        return D;
+    }
+
+    // Bytes per matvec next to a full-precision copy, and the residual floor that comes with them
+    void report(std::ostream& os = std::cout) const {
+        os << "Stored " << rows_ << " x " << cols_ << " in " << sizeof(T) << "-byte elements: " << bytes() / 1e6 << " MB per matvec ("
+           << HostPrecision(rows_ * cols_ * sizeof(S)) / std::max<size_t>(bytes(), 1) << "x less), relative storage error "
+           << error_ << std::endl;
+    }
+
+    // y = A x, on an S basis or on its SingleScalar counterpart (adaptive precision, adaptive.hpp). A real matrix also
+    // takes complex vectors, both parts in the same sweep. Threads own contiguous row ranges, each swept ROW_BLOCK rows
+    // at a time so one pass over x serves them all
+    template <typename X>
+    void apply(const X* x, X* y) const {
+        using XR = decltype(std::real(std::declval<X>()));
+        static_assert(std::is_same_v<X, S> || std::is_same_v<X, SingleScalar<S>> || (!COMPLEX && is_complex_v<X>),
+                      "Vectors must be S, its single-precision counterpart, or complex under a real matrix.");
+        constexpr bool SPLIT = is_complex_v<X>;
+        if constexpr (SPLIT) {
+            if (x_split_.size() < 2 * cols_) {x_split_.resize(2 * cols_);} // Once, for a real matrix in a complex basis
+            double* split = x_split_.data();
+            for (size_t j = 0; j < cols_; ++j) {
+                split[j] = x[j].real();
+                split[cols_ + j] = x[j].imag();
+            }
+        }
+        const size_t blocks = (rows_ + ROW_BLOCK - 1) / ROW_BLOCK;
+        const int threads = rows_ * cols_ < cpublas::PARALLEL_GRAIN ? 1 : std::min<int>(cpublas::threadCount(handle_), blocks);
+        cpublas::parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [b0, b1] = cpublas::chunkRange(blocks, tid, nthreads);
+            for (size_t b = b0; b < b1; ++b) {
+                const size_t r0 = b * ROW_BLOCK;
+                const size_t nr = std::min(ROW_BLOCK, rows_ - r0);
+                if constexpr (COMPLEX) {complexRows(r0, nr, x_split_.data(), reinterpret_cast<XR*>(y));}
+                else if constexpr (SPLIT) {mixedRows(r0, nr, x_split_.data(), reinterpret_cast<XR*>(y));}
+                else {realRows(r0, nr, x, y);}
+            }
+        });
+    }
+
+private:
+    static constexpr size_t ROW_BLOCK = 4;
+
+    template <typename XR>
+    void realRows(size_t r0, size_t nr, const XR* x, XR* y) const {
+        const size_t n = cols_;
+        const T* a0 = re_.data() + r0 * n;
+        if (nr == ROW_BLOCK) {
+            const T* a1 = a0 + n;
+            const T* a2 = a1 + n;
+            const T* a3 = a2 + n;
+            double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            #pragma omp simd reduction(+:s0, s1, s2, s3)
+            for (size_t j = 0; j < n; ++j) {
+                const double xj = x[j];
+                s0 += double(widen(a0[j])) * xj;
+                s1 += double(widen(a1[j])) * xj;
+                s2 += double(widen(a2[j])) * xj;
+                s3 += double(widen(a3[j])) * xj;
+            }
+            y[r0] = XR(s0); y[r0 + 1] = XR(s1); y[r0 + 2] = XR(s2); y[r0 + 3] = XR(s3);
+            return;
+        }
+        for (size_t r = 0; r < nr; ++r, a0 += n) {
+            double s = 0;
+            #pragma omp simd reduction(+:s)
+            for (size_t j = 0; j < n; ++j) {s += double(widen(a0[j])) * x[j];}
+            y[r0 + r] = XR(s);
+        }
+    }
+
+    // y interleaved (re, im), x split into n real parts followed by n imaginary parts
+    template <typename XR>
+    void complexRows(size_t r0, size_t nr, const double* x, XR* y) const {
+        const size_t n = cols_;
+        const double* xi = x + n;
+        size_t r = 0;
+        for (; r + 2 <= nr; r += 2) {
+            const T* ar0 = re_.data() + (r0 + r) * n;
+            const T* ai0 = im_.data() + (r0 + r) * n;
+            const T* ar1 = ar0 + n;
+            const T* ai1 = ai0 + n;
+            double re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+            #pragma omp simd reduction(+:re0, im0, re1, im1)
+            for (size_t j = 0; j < n; ++j) {
+                const double p = double(widen(ar0[j])), q = double(widen(ai0[j]));
+                const double u = double(widen(ar1[j])), v = double(widen(ai1[j]));
+                const double xr = x[j], xim = xi[j];
+                re0 += p * xr - q * xim;
+                im0 += p * xim + q * xr;
+                re1 += u * xr - v * xim;
+                im1 += u * xim + v * xr;
+            }
+            y[2 * (r0 + r)] = XR(re0); y[2 * (r0 + r) + 1] = XR(im0);
+            y[2 * (r0 + r + 1)] = XR(re1); y[2 * (r0 + r + 1) + 1] = XR(im1);
+        }
+        for (; r < nr; ++r) {
+            const T* ar = re_.data() + (r0 + r) * n;
+            const T* ai = im_.data() + (r0 + r) * n;
+            double re = 0, im = 0;
+            #pragma omp simd reduction(+:re, im)
+            for (size_t j = 0; j < n; ++j) {
+                const double p = double(widen(ar[j])), q = double(widen(ai[j]));
+                const double xr = x[j], xim = xi[j];
+                re += p * xr - q * xim;
+                im += p * xim + q * xr;
+            }
+            y[2 * (r0 + r)] = XR(re); y[2 * (r0 + r) + 1] = XR(im);
+        }
+    }
+
+    // Real matrix, complex x split as in complexRows: one matrix stream feeds the real and the imaginary sums
+    template <typename XR>
+    void mixedRows(size_t r0, size_t nr, const double* x, XR* y) const {
+        const size_t n = cols_;
+        const double* xi = x + n;
+        size_t r = 0;
+        for (; r + 2 <= nr; r += 2) {
+            const T* a0 = re_.data() + (r0 + r) * n;
+            const T* a1 = a0 + n;
+            double re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+            #pragma omp simd reduction(+:re0, im0, re1, im1)
+            for (size_t j = 0; j < n; ++j) {
+                const double p = double(widen(a0[j])), u = double(widen(a1[j]));
+                re0 += p * x[j];
+                im0 += p * xi[j];
+                re1 += u * x[j];
+                im1 += u * xi[j];
+            }
+            y[2 * (r0 + r)] = XR(re0); y[2 * (r0 + r) + 1] = XR(im0);
+            y[2 * (r0 + r + 1)] = XR(re1); y[2 * (r0 + r + 1) + 1] = XR(im1);
+        }
+        for (; r < nr; ++r) {
+            const T* a = re_.data() + (r0 + r) * n;
+            double re = 0, im = 0;
+            #pragma omp simd reduction(+:re, im)
+            for (size_t j = 0; j < n; ++j) {
+                re += double(widen(a[j])) * x[j];
+                im += double(widen(a[j])) * xi[j];
+            }
+            y[2 * (r0 + r)] = XR(re); y[2 * (r0 + r) + 1] = XR(im);
+        }
+    }
+
+    size_t rows_ = 0, cols_ = 0;
+    std::vector<T> re_, im_;
+    mutable std::vector<double> x_split_; // Complex x as separate real and imaginary planes, sized on first use for a real matrix
+    double norm_ = 0, error_ = 0;
+    mutable cpublas::Handle handle_;
+};
+
+using FloatStorageMatrix = ReducedMatrix<float>;
+using BFloat16Matrix = ReducedMatrix<bfloat16>;
+using Float16Matrix = ReducedMatrix<float16>;
+using ComplexFloatStorageMatrix = ReducedMatrix<float, ComplexType>;
+using ComplexBFloat16Matrix = ReducedMatrix<bfloat16, ComplexType>;
+using ComplexFloat16Matrix = ReducedMatrix<float16, ComplexType>;
+
+#endif // PRECISION_HPP
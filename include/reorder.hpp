@@ -0,0 +1,227 @@
+// Bandwidth-reducing reordering for sparse operators. reorderRCM permutes a CSR matrix once with reverse Cuthill-McKee,
+// the solve runs in the permuted space and NaiveArnoldi/IRAM map Ritz vectors back through restoreOrder().
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <queue>
+#include <vector>
+#include "sparse.hpp"
+#include "operator.hpp"
+
+struct ReorderingReport {
+    size_t bandwidth_before;
+    size_t bandwidth_after;
+    size_t profile_before;
+    size_t profile_after;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ReorderingReport& r) {
+    return os << "bandwidth " << r.bandwidth_before << " -> " << r.bandwidth_after
+              << ", profile " << r.profile_before << " -> " << r.profile_after;
+}
+
+namespace sparse {
+    // max |i - j| over stored entries
+    template <typename T, typename S, typename I>
+    size_t bandwidth(const CSRMatrix<T, S, I>& A) {
+        size_t bw = 0;
+        for (size_t i = 0; i < A.rows(); ++i) {
+            for (I k = A.rowPtr()[i]; k < A.rowPtr()[i + 1]; ++k) {
+                const size_t j = A.colInd()[k];
+                bw = std::max(bw, i > j ? i - j : j - i);
+            }
+        }
+        return bw;
+    }
+
+    // Envelope size, sum over rows of the distance from the first stored column to the diagonal
+    template <typename T, typename S, typename I>
+    size_t profile(const CSRMatrix<T, S, I>& A) {
+        size_t p = 0;
+        for (size_t i = 0; i < A.rows(); ++i) {
+            size_t first = i;
+            for (I k = A.rowPtr()[i]; k < A.rowPtr()[i + 1]; ++k) {first = std::min<size_t>(first, A.colInd()[k]);}
+            p += i - first;
+        }
+        return p;
+    }
+
+    // Adjacency of the symmetrized pattern A + A^T without the diagonal, nonsymmetric operators reorder on their graph closure
+    template <typename T, typename S, typename I>
+    void symmetricPattern(const CSRMatrix<T, S, I>& A, std::vector<I>& adj_ptr, std::vector<I>& adj) {
+        const size_t n = A.rows();
+        std::vector<std::vector<I>> lists(n);
+        for (size_t i = 0; i < n; ++i) {
+            for (I k = A.rowPtr()[i]; k < A.rowPtr()[i + 1]; ++k) {
+                const I j = A.colInd()[k];
+                if (static_cast<size_t>(j) == i) {continue;}
+                lists[i].push_back(j);
+                lists[j].push_back(static_cast<I>(i));
+            }
+        }
+        adj_ptr.assign(n + 1, 0);
+        adj.clear();
+        for (size_t i = 0; i < n; ++i) {
+            std::sort(lists[i].begin(), lists[i].end());
+            lists[i].erase(std::unique(lists[i].begin(), lists[i].end()), lists[i].end());
+            adj.insert(adj.end(), lists[i].begin(), lists[i].end());
+            adj_ptr[i + 1] = static_cast<I>(adj.size());
+        }
+    }
+
+    // BFS level structure from root, returns the last level and writes the eccentricity
+    template <typename I>
+    std::vector<I> lastLevel(I root, const std::vector<I>& adj_ptr, const std::vector<I>& adj, std::vector<I>& level, size_t& depth) {
+        std::fill(level.begin(), level.end(), I(-1));
+        std::vector<I> frontier{root};
+        level[root] = 0;
+        depth = 0;
+        while (true) {
+            std::vector<I> next;
+            for (I u : frontier) {
+                for (I k = adj_ptr[u]; k < adj_ptr[u + 1]; ++k) {
+                    if (level[adj[k]] < 0) {level[adj[k]] = static_cast<I>(depth + 1); next.push_back(adj[k]);}
+                }
+            }
+            if (next.empty()) {return frontier;}
+            frontier = std::move(next);
+            ++depth;
+        }
+    }
+
+    // Reverse Cuthill-McKee order, perm[new] = old. Each component starts from a George-Liu pseudo-peripheral node
+    template <typename T, typename S, typename I>
+    std::vector<I> reverseCuthillMcKee(const CSRMatrix<T, S, I>& A) {
+        const size_t n = A.rows();
+        if (A.rows() != A.cols()) {throw std::invalid_argument(invalid_dims_msg(A.rows(), A.cols(), A.cols(), A.rows()));}
+        std::vector<I> adj_ptr, adj;
+        symmetricPattern(A, adj_ptr, adj);
+        auto degree = [&adj_ptr](I u) { return adj_ptr[u + 1] - adj_ptr[u]; };
+
+        std::vector<I> order;
+        order.reserve(n);
+        std::vector<char> visited(n, 0);
+        std::vector<I> level(n);
+        std::vector<I> neighbours;
+        for (size_t seed = 0; seed < n; ++seed) {
+            if (visited[seed]) {continue;}
+
+            I root = static_cast<I>(seed);
+            size_t depth = 0;
+            std::vector<I> last = lastLevel(root, adj_ptr, adj, level, depth);
+            while (true) {
+                const I candidate = *std::min_element(last.begin(), last.end(), [&degree](I a, I b) { return degree(a) < degree(b); });
+                size_t candidate_depth = 0;
+                std::vector<I> candidate_last = lastLevel(candidate, adj_ptr, adj, level, candidate_depth);
+                if (candidate_depth <= depth) {break;}
+                root = candidate;
+                depth = candidate_depth;
+                last = std::move(candidate_last);
+            }
+
+            std::queue<I> queue;
+            queue.push(root);
+            visited[root] = 1;
+            while (!queue.empty()) {
+                const I u = queue.front();
+                queue.pop();
+                order.push_back(u);
+                neighbours.clear();
+                for (I k = adj_ptr[u]; k < adj_ptr[u + 1]; ++k) {
+                    if (!visited[adj[k]]) {visited[adj[k]] = 1; neighbours.push_back(adj[k]);}
+                }
+                std::stable_sort(neighbours.begin(), neighbours.end(), [&degree](I a, I b) { return degree(a) < degree(b); });
+                for (I v : neighbours) {queue.push(v);}
+            }
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // B = P A P^T with B(k, l) = A(perm[k], perm[l])
+    template <typename T, typename S, typename I>
+    CSRMatrix<T, S, I> permute(const CSRMatrix<T, S, I>& A, const std::vector<I>& perm) {
+        const size_t n = A.rows();
+        std::vector<I> inv(n);
+        for (size_t k = 0; k < n; ++k) {inv[perm[k]] = static_cast<I>(k);}
+
+        std::vector<I> row_ptr(n + 1, 0);
+        std::vector<I> col_ind(A.nnz());
+        std::vector<T> values(A.nnz());
+        std::vector<std::pair<I, T>> row;
+        for (size_t k = 0; k < n; ++k) {
+            const I old = perm[k];
+            row.clear();
+            for (I e = A.rowPtr()[old]; e < A.rowPtr()[old + 1]; ++e) {row.emplace_back(inv[A.colInd()[e]], A.values()[e]);}
+            std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            row_ptr[k + 1] = row_ptr[k] + static_cast<I>(row.size());
+            for (size_t e = 0; e < row.size(); ++e) {
+                col_ind[row_ptr[k] + e] = row[e].first;
+                values[row_ptr[k] + e] = row[e].second;
+            }
+        }
+        return CSRMatrix<T, S, I>(n, n, std::move(row_ptr), std::move(col_ind), std::move(values));
+    }
+} // namespace sparse
+
+// Operator held in a permuted basis. apply() works on permuted vectors, restoreOrder() maps results back (ReorderedOperator)
+template <LinearOperator Op, typename I = int>
+class ReorderedMatrix {
+public:
+    using Scalar = typename Op::Scalar;
+
+    ReorderedMatrix(Op op, std::vector<I> perm, ReorderingReport report)
+        : op_(std::move(op)), perm_(std::move(perm)), report_(report) {}
+
+    inline size_t rows() const { return op_.rows(); }
+    inline size_t cols() const { return op_.cols(); }
+    inline HostPrecision norm() const { return operatorNorm(op_); }
+    inline void apply(const Scalar* x, Scalar* y) const { op_.apply(x, y); }
+
+    inline const Op& op() const { return op_; }
+    inline const std::vector<I>& permutation() const { return perm_; }
+    inline const ReorderingReport& report() const { return report_; }
+
+    // Rows of V are in permuted order on entry, original order on exit
+    template <typename MatrixType>
+    void restoreOrder(MatrixType& V) const {
+        MatrixType W(V.rows(), V.cols());
+        for (size_t k = 0; k < perm_.size(); ++k) {W.row(perm_[k]) = V.row(k);}
+        V = std::move(W);
+    }
+
+    // Original-order vector -> permuted order, for callers supplying their own start vectors
+    template <typename MatrixType>
+    void applyOrder(MatrixType& V) const {
+        MatrixType W(V.rows(), V.cols());
+        for (size_t k = 0; k < perm_.size(); ++k) {W.row(k) = V.row(perm_[k]);}
+        V = std::move(W);
+    }
+
+private:
+    Op op_;
+    std::vector<I> perm_;
+    ReorderingReport report_;
+};
+
+// Permutes A once with RCM. The report is printed when verbose so the caller can judge whether the reorder paid off
+template <typename T, typename S, typename I>
+ReorderedMatrix<CSRMatrix<T, S, I>, I> reorderRCM(const CSRMatrix<T, S, I>& A, bool verbose = true) {
+    std::vector<I> perm = sparse::reverseCuthillMcKee(A);
+    CSRMatrix<T, S, I> B = sparse::permute(A, perm);
+    const ReorderingReport report{sparse::bandwidth(A), sparse::bandwidth(B), sparse::profile(A), sparse::profile(B)};
+    if (verbose) {std::cout << "RCM reordering: " << report << std::endl;}
+    return ReorderedMatrix<CSRMatrix<T, S, I>, I>(std::move(B), std::move(perm), report);
+}
+
+// Same permutation, SELL-C-sigma storage for the permuted operator
+template <typename T, typename S, typename I>
+ReorderedMatrix<SELLMatrix<T, S, I>, I> toSELL(const ReorderedMatrix<CSRMatrix<T, S, I>, I>& R, size_t sigma = SELL_SIGMA) {
+    return ReorderedMatrix<SELLMatrix<T, S, I>, I>(SELLMatrix<T, S, I>::fromCSR(R.op(), sigma), R.permutation(), R.report());
+}
+
+#endif // REORDER_HPP
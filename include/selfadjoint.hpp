@@ -0,0 +1,204 @@
+// Blocked-triangular storage for symmetric and Hermitian operators. Only the lower triangle is kept, cut into square
+// tiles of SELFADJOINT_TILE rows stored one after another, so a self-adjoint matrix costs about half the memory of its
+// dense form. apply() reads each off-diagonal tile once and uses it twice, y_I += T x_J and y_J += T^H x_I, which halves
+// the bytes a matvec streams; a dense matvec is bandwidth bound, so that is close to half the time. Diagonal tiles are
+// kept whole (their upper half is the only redundancy, N x TILE / 2 elements). Nothing checks that the input is
+// self-adjoint: the lower triangle defines the operator, with the imaginary part of the diagonal dropped.
+#ifndef SELFADJOINT_HPP
+#define SELFADJOINT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "vector.hpp"
+#include "backend.hpp"
+
+// Tile edge. Each tile is streamed once, so only the x and y segments it touches (a few KiB) need to stay in cache;
+// long columns amortize the four dot-product reductions per sweep. 256 measured best against 64 and 128
+constexpr size_t SELFADJOINT_TILE = 256;
+static_assert(SELFADJOINT_TILE % 4 == 0, "Off-diagonal tiles are swept four columns at a time.");
+
+// S := HostPrecision (symmetric) or ComplexType (Hermitian)
+template <typename S = HostPrecision>
+class SelfAdjointMatrix {
+public:
+    using Scalar = S;
+    static constexpr size_t TILE = SELFADJOINT_TILE;
+
+    SelfAdjointMatrix() = default;
+
+    // Lower triangle of a dense matrix, the strict upper triangle is never read
+    template <typename MatrixType>
+    explicit SelfAdjointMatrix(const MatrixType& A)
+        : SelfAdjointMatrix(A.rows(), [&A](size_t i, size_t j) { return static_cast<S>(A(i, j)); }) {
+        if (static_cast<size_t>(A.cols()) != n_) {throw std::invalid_argument("SelfAdjointMatrix needs a square matrix");}
+    }
+
+    // entry(i, j) for i >= j, so a covariance matrix can be built straight into the packed form
+    template <typename F>
+        requires std::is_invocable_r_v<S, F, size_t, size_t>
+    SelfAdjointMatrix(size_t n, F entry) : n_(n), tiles_((n + TILE - 1) / TILE) {
+        offsets_.resize(tiles_ * (tiles_ + 1) / 2 + 1);
+        size_t offset = 0;
+        for (size_t I = 0; I < tiles_; ++I) {
+            for (size_t J = 0; J <= I; ++J) {
+                offsets_[tileIndex(I, J)] = offset;
+                offset += tileRows(I) * tileRows(J);
+            }
+        }
+        offsets_.back() = offset;
+        data_.resize(offset);
+        HostPrecision norm = 0;
+        for (size_t I = 0; I < tiles_; ++I) {
+            for (size_t J = 0; J <= I; ++J) {
+                S* T = data_.data() + offsets_[tileIndex(I, J)];
+                const size_t rows = tileRows(I), cols = tileRows(J);
+                for (size_t c = 0; c < cols; ++c) {
+                    for (size_t r = 0; r < rows; ++r) {
+                        const size_t i = I * TILE + r, j = J * TILE + c;
+                        // The diagonal tile's upper half mirrors its lower half. A Hermitian diagonal is real, any
+                        // imaginary part of the input would leave the operator non-Hermitian
+                        if (i == j) {T[c * rows + r] = S(std::real(entry(i, i)));}
+                        else {T[c * rows + r] = i > j ? entry(i, j) : cpublas::conjugate(entry(j, i));}
+                        norm += (I == J ? 1 : 2) * std::norm(T[c * rows + r]);
+                    }
+                }
+            }
+        }
+        norm_ = std::sqrt(norm);
+    }
+
+    inline size_t rows() const { return n_; }
+    inline size_t cols() const { return n_; }
+    inline HostPrecision norm() const { return norm_; } // Frobenius, of the full operator
+    inline size_t bytes() const { return data_.size() * sizeof(S); }
+    // 0 := OpenMP default
+    inline void setNumThreads(int num_threads) const { handle_.num_threads = num_threads; }
+    inline int numThreads() const { return handle_.num_threads; }
+
+    inline S at(size_t i, size_t j) const {
+        if (i < j) {return cpublas::conjugate(at(j, i));}
+        const size_t I = i / TILE, J = j / TILE;
+        return data_[offsets_[tileIndex(I, J)] + (j - J * TILE) * tileRows(I) + (i - I * TILE)];
+    }
+
+    template <typename MatrixType = std::conditional_t<is_complex_v<S>, ComplexMatrix, Matrix>>
+    MatrixType toDense() const {
+        MatrixType D(n_, n_);
+        for (size_t j = 0; j < n_; ++j) {
+            for (size_t i = 0; i < n_; ++i) {D(i, j) = at(i, j);}
+        }
+        return D;
+    }
+
+    // y = A x. Threads own contiguous ranges of tile rows, balanced by tile count. The transposed half of a tile row
+    // lands in other threads' rows, so each thread accumulates into its own length-N slice and the slices are summed
+    // after; that is threads x N extra traffic against N^2 / 2 for the matrix
+    void apply(const S* x, S* y) const {
+        const size_t work = n_ * n_ / 2;
+        const int threads = work < cpublas::PARALLEL_GRAIN ? 1 : std::min<int>(cpublas::threadCount(handle_), tiles_);
+        if (threads == 1) {
+            std::fill(y, y + n_, S(0));
+            tileRowRange(0, tiles_, x, y);
+            return;
+        }
+        if (partial_.size() < threads * n_) {partial_.resize(threads * n_);} // Grow-only
+        S* partial = partial_.data();
+        cpublas::parallelRegion(threads, [&](int tid, int nthreads) {
+            S* acc = partial + tid * n_;
+            std::fill(acc, acc + n_, S(0));
+            tileRowRange(balancedRow(tid, nthreads), balancedRow(tid + 1, nthreads), x, acc);
+        });
+        cpublas::parallelRegion(threads, [&](int tid, int nthreads) {
+            const auto [i0, i1] = cpublas::chunkRange(n_, tid, nthreads);
+            for (size_t i = i0; i < i1; ++i) {
+                S sum = partial[i];
+                for (int t = 1; t < threads; ++t) {sum += partial[t * n_ + i];}
+                y[i] = sum;
+            }
+        });
+    }
+
+private:
+    inline size_t tileRows(size_t I) const { return std::min(TILE, n_ - I * TILE); }
+    static inline size_t tileIndex(size_t I, size_t J) { return I * (I + 1) / 2 + J; }
+
+    // First tile row of thread tid: tile row I holds I + 1 tiles, so cut the cumulative count I (I + 1) / 2 evenly
+    inline size_t balancedRow(int tid, int nthreads) const {
+        const double target = double(tiles_) * (tiles_ + 1) / 2 * tid / nthreads;
+        size_t I = 0;
+        while (I < tiles_ && double(I) * (I + 1) / 2 < target) {++I;}
+        return I;
+    }
+
+    // y += A x over tile rows [I0, I1), both halves of each off-diagonal tile
+    void tileRowRange(size_t I0, size_t I1, const S* x, S* y) const {
+        for (size_t I = I0; I < I1; ++I) {
+            const size_t rows = tileRows(I);
+            const S* xI = x + I * TILE;
+            S* yI = y + I * TILE;
+            for (size_t J = 0; J < I; ++J) {
+                offDiagonalTile(data_.data() + offsets_[tileIndex(I, J)], rows, x + J * TILE, xI, y + J * TILE, yI);
+            }
+            cpublas::panelUpdate(data_.data() + offsets_[tileIndex(I, I)], rows, static_cast<int>(rows), S(1), xI, 1, yI, 1, 0, rows);
+        }
+    }
+
+    // yI += T xJ and yJ += T^H xI for a full TILE-column tile with rows rows, four columns per sweep over its rows so
+    // each xI and yI load feeds four columns. Real accumulators throughout, so the T^H xI dot products vectorize as
+    // simd reductions (complex data is read as interleaved re, im pairs)
+    static void offDiagonalTile(const S* T, size_t rows, const S* xJ, const S* xI, S* yJ, S* yI) {
+        using R = decltype(std::real(std::declval<S>()));
+        for (size_t c = 0; c < TILE; c += 4) {
+            const R* t0 = reinterpret_cast<const R*>(T + c * rows);
+            const R* t1 = t0 + (sizeof(S) / sizeof(R)) * rows;
+            const R* t2 = t1 + (sizeof(S) / sizeof(R)) * rows;
+            const R* t3 = t2 + (sizeof(S) / sizeof(R)) * rows;
+            const R* x = reinterpret_cast<const R*>(xI);
+            R* y = reinterpret_cast<R*>(yI);
+            if constexpr (is_complex_v<S>) {
+                const R p0 = xJ[c].real(), q0 = xJ[c].imag(), p1 = xJ[c + 1].real(), q1 = xJ[c + 1].imag();
+                const R p2 = xJ[c + 2].real(), q2 = xJ[c + 2].imag(), p3 = xJ[c + 3].real(), q3 = xJ[c + 3].imag();
+                R re0 = 0, im0 = 0, re1 = 0, im1 = 0, re2 = 0, im2 = 0, re3 = 0, im3 = 0;
+                #pragma omp simd reduction(+:re0, im0, re1, im1, re2, im2, re3, im3)
+                for (size_t r = 0; r < rows; ++r) {
+                    const R xr = x[2 * r], xi = x[2 * r + 1];
+                    const R a0 = t0[2 * r], b0 = t0[2 * r + 1], a1 = t1[2 * r], b1 = t1[2 * r + 1];
+                    const R a2 = t2[2 * r], b2 = t2[2 * r + 1], a3 = t3[2 * r], b3 = t3[2 * r + 1];
+                    y[2 * r] += a0 * p0 - b0 * q0 + a1 * p1 - b1 * q1 + a2 * p2 - b2 * q2 + a3 * p3 - b3 * q3;
+                    y[2 * r + 1] += a0 * q0 + b0 * p0 + a1 * q1 + b1 * p1 + a2 * q2 + b2 * p2 + a3 * q3 + b3 * p3;
+                    re0 += a0 * xr + b0 * xi; im0 += a0 * xi - b0 * xr;
+                    re1 += a1 * xr + b1 * xi; im1 += a1 * xi - b1 * xr;
+                    re2 += a2 * xr + b2 * xi; im2 += a2 * xi - b2 * xr;
+                    re3 += a3 * xr + b3 * xi; im3 += a3 * xi - b3 * xr;
+                }
+                yJ[c] += S(re0, im0); yJ[c + 1] += S(re1, im1); yJ[c + 2] += S(re2, im2); yJ[c + 3] += S(re3, im3);
+            } else {
+                const R x0 = xJ[c], x1 = xJ[c + 1], x2 = xJ[c + 2], x3 = xJ[c + 3];
+                R a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+                #pragma omp simd reduction(+:a0, a1, a2, a3)
+                for (size_t r = 0; r < rows; ++r) {
+                    y[r] += t0[r] * x0 + t1[r] * x1 + t2[r] * x2 + t3[r] * x3;
+                    a0 += t0[r] * x[r];
+                    a1 += t1[r] * x[r];
+                    a2 += t2[r] * x[r];
+                    a3 += t3[r] * x[r];
+                }
+                yJ[c] += a0; yJ[c + 1] += a1; yJ[c + 2] += a2; yJ[c + 3] += a3;
+            }
+        }
+    }
+
+    size_t n_ = 0, tiles_ = 0;
+    std::vector<S> data_;          // Lower tiles, tile row by tile row, each column-major with leading dimension its rows
+    std::vector<size_t> offsets_;  // Start of tile (I, J) at tileIndex(I, J), then the total
+    mutable std::vector<S> partial_; // Per-thread y slices
+    HostPrecision norm_ = 0;
+    mutable cpublas::Handle handle_;
+};
+
+using SymmetricMatrix = SelfAdjointMatrix<HostPrecision>;
+using HermitianMatrix = SelfAdjointMatrix<ComplexType>;
+
+#endif // SELFADJOINT_HPP
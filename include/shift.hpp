@@ -1,6 +1,7 @@
 #ifndef SHIFT_HPP
 #define SHIFT_HPP
 
+#include <algorithm>
 #include <vector>
 #include <complex>
 #include <cstddef>
@@ -10,277 +11,683 @@
 
 #include "eigenSolver.hpp"
 #include "arnoldi.hpp"
-#include "cuda_manager.hpp"
+#include "backend.hpp"
+#include "arena.hpp"
 
 enum resize_type : int16_t {
     ZEROS = 0,
     SHRINK = 1
 };
 
-// #define CUBLAS_RESTART
-#define EIGEN_RESTART
-
-#ifdef CUBLAS_RESTART
-inline int cublasComputeQ(DeviceComplexType* d_Q, std::vector<DeviceComplexType*> h_Tauarray, ComplexKrylovPair& q_h, const ComplexVector& eigenvalues, const size_t& basis_size, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle) {
-    const size_t N = q_h.m;
-    const size_t N_squared = N * N;
-    const size_t batch_count = N - basis_size;
-
-    int info;
-    int* d_info = cudaMallocChecked<int>(sizeof(int));
-    
-    const ComplexMatrix& H = q_h.H;
-    const ComplexMatrix& V = q_h.Q;
-    size_t V_Rows = V.rows();
+// Givens rotation (zlartg/dlartg): [c s; -conj(s) c] [a; b] = [r; 0] with c real. False for the identity, a = b = 0
+template <typename T>
+inline bool givensRotation(const T& a, const T& b, HostPrecision& c, T& s) {
+    const HostPrecision r = std::hypot(std::abs(a), std::abs(b));
+    if (r == 0) {c = 1; s = 0; return false;}
+    const T phase = std::abs(a) == 0 ? T(1) : a / std::abs(a);
+    c = std::abs(a) / r;
+    s = phase * cpublas::conjugate(b) / r;
+    return true;
+}
 
+// Rows r0..r1 of Q are where every restart step lands its basis update. Q is split into 256-row panels, and each
+// panel takes all of a step's transformations while it sits in cache
+constexpr Eigen::Index RESTART_PANEL = 256;
 
+// The restart works on host memory whatever the backend. Host-resident backends lend it the caller's handle, so it
+// honours that handle's thread count; a device backend's handle cannot reach host memory and the default one is used
+template <typename BK>
+inline cpublas::Handle hostHandle(const typename BK::BlasHandle& handle) {
+    if constexpr (BK::HOST_RESIDENT) {return handle;}
+    else {return cpublas::Handle{};}
+}
 
-    // Allocate device memory
-    DeviceComplexType* d_matrices = cudaMallocChecked<DeviceComplexType>((batch_count + 1) * N_squared * sizeof(DeviceComplexType));
-    DeviceComplexType* d_tau = cudaMallocChecked<DeviceComplexType>(batch_count * N * sizeof(DeviceComplexType));
-    DeviceComplexType** d_Tauarray = cudaMallocChecked<DeviceComplexType*>(batch_count * sizeof(DeviceComplexType*));
+// C = A B on host memory for the basis updates of the restarts
+template <typename S, typename BK>
+inline void restartGemm(typename BK::BlasHandle& handle, size_t m, size_t n, size_t k, const S* A, size_t lda, const S* B, size_t ldb,
+                        S* C, size_t ldc) {
+    const S one = getOne<S>();
+    const S zero = getZero<S>();
+    if constexpr (BK::HOST_RESIDENT) {BK::template gemm<S>(handle, BlasOp::N, BlasOp::N, m, n, k, &one, A, lda, B, ldb, &zero, C, ldc);}
+    else {cpublas::gemm<S>(hostHandle<BK>(handle), cpublas::OP_N, cpublas::OP_N, m, n, k, &one, A, lda, B, ldb, &zero, C, ldc);}
+}
 
-    DeviceComplexType** d_Aarray = cudaMallocChecked<DeviceComplexType*>(batch_count * sizeof(DeviceComplexType*));
+template <typename Body>
+inline void forEachBasisPanel(const cpublas::Handle& handle, Eigen::Index rows, Eigen::Index m, Body&& body) {
+    const size_t panels = (rows + RESTART_PANEL - 1) / RESTART_PANEL;
+    const int threads = static_cast<size_t>(rows * m) < cpublas::PARALLEL_GRAIN ? 1 : cpublas::threadCount(handle);
+    cpublas::parallelRegion(threads, [&](int tid, int nthreads) {
+        const auto [p0, p1] = cpublas::chunkRange(panels, tid, nthreads);
+        for (size_t p = p0; p < p1; ++p) {
+            const Eigen::Index r0 = p * RESTART_PANEL;
+            body(r0, std::min<Eigen::Index>(rows, r0 + RESTART_PANEL));
+        }
+    });
+}
 
-    
-    // Host arrays for device pointers
-    std::vector<DeviceComplexType*> h_Aarray(batch_count);
-
-    // Sort eigenvalues by magnitude
-    std::vector<size_t> indices(batch_count);
-    std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(),
-            [&eigenvalues](size_t i1, size_t i2) { 
-                return std::norm(eigenvalues(i1)) < std::norm(eigenvalues(i2)); 
-            });
-
-    // Prepare matrices on host (+ true copy of d_H to modify)
-    std::vector<DeviceComplexType> h_matrices((batch_count + 1) * N_squared);
-    for (int k = 0; k < batch_count + 1; k++) {
-        for (int j = 0; j < N; j++) {
-            for (int i = 0; i < N; i++) {
-                size_t idx = k * N_squared + j * N + i;
-                if ((i != j) or (k == batch_count)) {
-                    h_matrices[idx] = toDeviceComplex(H(i,j));
-                } else {
-                    h_matrices[idx] = toDeviceComplex(H(j,i) - eigenvalues(indices[k]));
-                }
+// Q <- Q G_0 ... G_{m-2}, G_k rotating columns k, k + 1 (rotations left as identity are cheap no-ops)
+template <typename T>
+inline void rotateBasis(const cpublas::Handle& handle, Eigen::Ref<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> Q, Eigen::Index m,
+                        const HostPrecision* c, const T* s) {
+    forEachBasisPanel(handle, Q.rows(), m, [&](Eigen::Index r0, Eigen::Index r1) {
+        for (Eigen::Index k = 0; k + 1 < m; ++k) {
+            T* qk = Q.col(k).data();
+            T* qk1 = Q.col(k + 1).data();
+            const T sk = s[k], sk_conj = cpublas::conjugate(s[k]);
+            const HostPrecision ck = c[k];
+            #pragma omp simd
+            for (Eigen::Index r = r0; r < r1; ++r) {
+                const T x = qk[r];
+                const T y = qk1[r];
+                qk[r] = ck * x + sk_conj * y;
+                qk1[r] = -sk * x + ck * y;
             }
         }
-    }
-
-    // Copy matrices to device
-    cudaMemcpyChecked(d_matrices, h_matrices.data(), (batch_count + 1) * N_squared * sizeof(DeviceComplexType), cudaMemcpyHostToDevice);
+    });
+}
 
-    // Set up device pointer arrays
-    for (int i = 0; i < batch_count; i++) {
-        h_Aarray[i] = d_matrices + i * N_squared;
-        h_Tauarray[i] = d_tau + i * N;
+// One implicit single-shift QR step on upper Hessenberg H (bulge chasing). The first rotation comes from the first
+// column of H - mu I, every later one chases the bulge at (k + 1, k - 1) down and off the matrix. Same step as a QR
+// factorization of H - mu I by the implicit Q theorem, but H - mu I is never formed and the Hessenberg form is kept by
+// construction: O(m) per rotation on H, O(m^2) per shift. c/s hold the rotations, Q is rotated along
+template <typename T>
+inline void implicitShiftStep(const cpublas::Handle& handle, Eigen::Ref<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> H,
+                              Eigen::Ref<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> Q, const T& mu, HostPrecision* c, T* s) {
+    const Eigen::Index m = H.rows();
+    for (Eigen::Index k = 0; k + 1 < m; ++k) {
+        const T a = (k == 0) ? H(0, 0) - mu : H(k, k - 1);
+        const T b = (k == 0) ? H(1, 0) : H(k + 1, k - 1);
+        if (!givensRotation(a, b, c[k], s[k])) {continue;}
+        const T sk = s[k], sk_conj = cpublas::conjugate(s[k]);
+        const HostPrecision ck = c[k];
+        for (Eigen::Index j = std::max<Eigen::Index>(k - 1, 0); j < m; ++j) {
+            const T x = H(k, j);
+            const T y = H(k + 1, j);
+            H(k, j) = ck * x + sk * y;
+            H(k + 1, j) = -sk_conj * x + ck * y;
+        }
+        if (k > 0) {H(k + 1, k - 1) = 0;}
+        for (Eigen::Index i = 0; i <= std::min(k + 2, m - 1); ++i) {
+            const T x = H(i, k);
+            const T y = H(i, k + 1);
+            H(i, k) = ck * x + sk_conj * y;
+            H(i, k + 1) = -sk * x + ck * y;
+        }
     }
+    rotateBasis<T>(handle, Q, m, c, s);
+}
 
-    // Copy pointer arrays to device
-    cudaMemcpyChecked(d_Aarray, h_Aarray.data(), batch_count * sizeof(DeviceComplexType*), cudaMemcpyHostToDevice);
-    cudaMemcpyChecked(d_Tauarray, h_Tauarray.data(), batch_count * sizeof(DeviceComplexType*), cudaMemcpyHostToDevice);
+// Householder reflector (I - tau v v^T) with v = (1, v1, v2) mapping x = (x0, x1, x2) onto a multiple of e_1
+struct Reflector3 {
+    HostPrecision v1 = 0, v2 = 0, tau = 0;
 
-    // Perform batch QR factorization
-    CHECK_CUBLAS(cublasZgeqrfBatched(handle, N, N, d_Aarray, N, d_Tauarray, &info, batch_count));
+    static inline Reflector3 from(HostPrecision x0, HostPrecision x1, HostPrecision x2) {
+        const HostPrecision tail = std::hypot(x1, x2);
+        if (tail == 0) {return {};}
+        const HostPrecision alpha = -std::copysign(std::hypot(x0, tail), x0);
+        const HostPrecision v0 = x0 - alpha;
+        return {x1 / v0, x2 / v0, (alpha - x0) / alpha};
+    }
 
-    CHECK_CUDA(cudaMemcpy2D(
-        d_Q,                          // dst
-        N * sizeof(DeviceComplexType), // dst pitch (width of each row in bytes)
-        d_matrices,                    // src
-        N * sizeof(DeviceComplexType), // src pitch
-        N * sizeof(DeviceComplexType), // width in bytes to copy per row
-        N * batch_count,               // number of rows
-        cudaMemcpyDeviceToDevice));
+    inline void apply(HostPrecision& a, HostPrecision& b, HostPrecision& c) const {
+        const HostPrecision w = tau * (a + v1 * b + v2 * c);
+        a -= w;
+        b -= w * v1;
+        c -= w * v2;
+    }
+};
 
-    
-    // Cleanup device memory
-    cudaFreeChecked(d_matrices);
-    cudaFreeChecked(d_tau);
-    cudaFreeChecked(d_Aarray);
-    cudaFreeChecked(d_Tauarray);
-    cudaFreeChecked(d_info);
+// One implicit Francis double-shift step on real upper Hessenberg H for the shift pair mu, conj(mu) (or two real
+// shifts with sum s and product t). The pair enters through the first column of H^2 - s H + t I, so H and Q stay real.
+// 3 x 3 reflectors chase the bulge, a final rotation clears it. Needs m >= 3; reflectors hold the m - 2 reflectors
+// and c/s the closing rotation, which sits at index m - 2
+inline void francisDoubleStep(const cpublas::Handle& handle, Eigen::Ref<Matrix> H, Eigen::Ref<Matrix> Q, HostPrecision s, HostPrecision t,
+                              Reflector3* reflectors, HostPrecision* c, HostPrecision* sn) {
+    const Eigen::Index m = H.rows();
+    assert(m >= 3);
+    HostPrecision x = H(0, 0) * H(0, 0) + H(0, 1) * H(1, 0) - s * H(0, 0) + t;
+    HostPrecision y = H(1, 0) * (H(0, 0) + H(1, 1) - s);
+    HostPrecision z = H(1, 0) * H(2, 1);
+    for (Eigen::Index k = 0; k + 2 < m; ++k) {
+        const Reflector3 P = Reflector3::from(x, y, z);
+        reflectors[k] = P;
+        for (Eigen::Index j = std::max<Eigen::Index>(k - 1, 0); j < m; ++j) {P.apply(H(k, j), H(k + 1, j), H(k + 2, j));}
+        if (k > 0) {H(k + 1, k - 1) = 0; H(k + 2, k - 1) = 0;}
+        for (Eigen::Index i = 0; i <= std::min(k + 3, m - 1); ++i) {P.apply(H(i, k), H(i, k + 1), H(i, k + 2));}
+        x = H(k + 1, k);
+        y = H(k + 2, k);
+        if (k + 3 < m) {z = H(k + 3, k);}
+    }
+    const Eigen::Index k = m - 2;
+    for (Eigen::Index i = 0; i < k; ++i) {c[i] = 1; sn[i] = 0;}
+    if (givensRotation(x, y, c[k], sn[k])) {
+        for (Eigen::Index j = k - 1; j < m; ++j) {
+            const HostPrecision a = H(k, j);
+            const HostPrecision b = H(k + 1, j);
+            H(k, j) = c[k] * a + sn[k] * b;
+            H(k + 1, j) = -sn[k] * a + c[k] * b;
+        }
+        H(k + 1, k - 1) = 0;
+        for (Eigen::Index i = 0; i < m; ++i) {
+            const HostPrecision a = H(i, k);
+            const HostPrecision b = H(i, k + 1);
+            H(i, k) = c[k] * a + sn[k] * b;
+            H(i, k + 1) = -sn[k] * a + c[k] * b;
+        }
+    }
 
-    return 0;
+    forEachBasisPanel(handle, Q.rows(), m, [&](Eigen::Index r0, Eigen::Index r1) {
+        for (Eigen::Index j = 0; j + 2 < m; ++j) {
+            const Reflector3 P = reflectors[j];
+            if (P.tau == 0) {continue;}
+            HostPrecision* q0 = Q.col(j).data();
+            HostPrecision* q1 = Q.col(j + 1).data();
+            HostPrecision* q2 = Q.col(j + 2).data();
+            #pragma omp simd
+            for (Eigen::Index r = r0; r < r1; ++r) {
+                const HostPrecision w = P.tau * (q0[r] + P.v1 * q1[r] + P.v2 * q2[r]);
+                q0[r] -= w;
+                q1[r] -= w * P.v1;
+                q2[r] -= w * P.v2;
+            }
+        }
+        HostPrecision* qk = Q.col(k).data();
+        HostPrecision* qk1 = Q.col(k + 1).data();
+        #pragma omp simd
+        for (Eigen::Index r = r0; r < r1; ++r) {
+            const HostPrecision a = qk[r];
+            const HostPrecision b = qk1[r];
+            qk[r] = c[k] * a + sn[k] * b;
+            qk1[r] = -sn[k] * a + c[k] * b;
+        }
+    });
 }
 
-int cublasQProduct(DeviceComplexType* d_Q, std::vector<DeviceComplexType*> h_Tauarray, ComplexKrylovPair& q_h, const size_t& basis_size, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle) {
-    const size_t N = q_h.m;
-    const size_t N_squared = N * N;
-    const size_t batch_count = N - basis_size;
-    const ComplexMatrix& V = q_h.Q;
-    size_t V_Rows = V.rows();
+// How a shifted QR restart carries its transformations over to the N x m basis
+enum class BasisUpdate {
+    ROTATE,     // Every shift's rotations swept over the whole basis in row panels, m - k passes
+    ACCUMULATE  // Rotations collected in an m x m matrix V, then one blocked N x m x k gemm Q V_k for the kept columns
+};
 
-    constexpr DeviceComplexType one = cuDoubleComplex(1.0, 0.0);
-    constexpr DeviceComplexType zero = cuDoubleComplex(0.0, 0.0);
+// Restart scratch: shifts, rotations and reflectors carved from an arena, plus Schur solvers sized once per basis size so
+// their factorization storage is reused. bind() again after every arena reset
+struct RestartWorkspace {
+    Eigen::ComplexSchur<ComplexMatrix> schur;
+    Eigen::RealSchur<Matrix> real_schur;
+    ComplexType* shifts = nullptr;
+    ComplexType* sines = nullptr;
+    HostPrecision* cosines = nullptr;
+    ComplexType* schur_vectors = nullptr; // m x m, Krylov-Schur Schur vectors or the accumulated complex rotations
+    HostPrecision* real_sines = nullptr;  // Real restarts: Francis step reflectors and closing rotation
+    Reflector3* reflectors = nullptr;
+    HostPrecision* real_accumulated = nullptr; // m x m, accumulated real transformations
+    BasisUpdate update = BasisUpdate::ACCUMULATE;
+    size_t m = 0;
+
+    static inline size_t footprint(size_t m) {
+        return 2 * WorkspaceArena::footprint<ComplexType>(m) + WorkspaceArena::footprint<HostPrecision>(m)
+             + WorkspaceArena::footprint<ComplexType>(m * m) + WorkspaceArena::footprint<HostPrecision>(m)
+             + WorkspaceArena::footprint<Reflector3>(m) + WorkspaceArena::footprint<HostPrecision>(m * m);
+    }
 
-    int info;
-    int* d_info = cudaMallocChecked<int>(sizeof(int));
+    void bind(WorkspaceArena& arena, size_t basis) {
+        if (basis != m) {
+            schur = Eigen::ComplexSchur<ComplexMatrix>(basis);
+            real_schur = Eigen::RealSchur<Matrix>(basis);
+            m = basis;
+        }
+        shifts = arena.allocate<ComplexType>(basis);
+        sines = arena.allocate<ComplexType>(basis);
+        cosines = arena.allocate<HostPrecision>(basis);
+        schur_vectors = arena.allocate<ComplexType>(basis * basis);
+        real_sines = arena.allocate<HostPrecision>(basis);
+        reflectors = arena.allocate<Reflector3>(basis);
+        real_accumulated = arena.allocate<HostPrecision>(basis * basis);
+    }
+};
 
-    int lwork;
-    ComplexMatrix V_copy = q_h.Q;
+// Householder reduction A := U^T A U to upper Hessenberg form, in place and unblocked. Eigen's blocked back-accumulation
+// of U (bases over 48 columns) allocates, this runs on caller scratch only: U is n x n, work holds n scalars
+inline void hessenbergReduce(Eigen::Ref<Matrix> A, Eigen::Ref<Matrix> U, HostPrecision* work) {
+    const Eigen::Index n = A.rows();
+    U.setIdentity();
+    for (Eigen::Index i = 0; i + 2 < n; ++i) {
+        const Eigen::Index r = n - i - 1;
+        auto x = A.col(i).tail(r);
+        HostPrecision tau, beta;
+        x.makeHouseholderInPlace(tau, beta);
+        const auto essential = x.tail(r - 1);
+        A.bottomRightCorner(r, r).applyHouseholderOnTheLeft(essential, tau, work);
+        A.rightCols(r).applyHouseholderOnTheRight(essential, tau, work);
+        U.rightCols(r).applyHouseholderOnTheRight(essential, tau, work);
+        x(0) = beta;
+        x.tail(r - 1).setZero();
+    }
+}
 
-    DeviceComplexType* d_H = cudaMallocChecked<DeviceComplexType>(N * N * sizeof(DeviceComplexType));
-    DeviceComplexType* d_V = cudaMallocChecked<DeviceComplexType>(V_Rows * N * sizeof(DeviceComplexType));
+// Eigenvalues of the quasi-triangular real Schur form T: 1 x 1 blocks are real, 2 x 2 blocks a conjugate pair written
+// with the positive imaginary part first
+inline void quasiTriangularEigenvalues(const Matrix& T, ComplexType* values) {
+    const Eigen::Index m = T.rows();
+    for (Eigen::Index i = 0; i < m; ++i) {
+        if (i + 1 == m || T(i + 1, i) == 0) {values[i] = T(i, i); continue;}
+        const HostPrecision p = 0.5 * (T(i, i) - T(i + 1, i + 1));
+        const HostPrecision q = p * p + T(i + 1, i) * T(i, i + 1);
+        const HostPrecision z = std::sqrt(std::abs(q));
+        const HostPrecision mean = T(i + 1, i + 1) + p;
+        if (q >= 0) {values[i] = mean + std::copysign(z, p); values[i + 1] = mean - std::copysign(z, p);}
+        else {values[i] = ComplexType(mean, z); values[i + 1] = ComplexType(mean, -z);}
+        ++i;
+    }
+}
 
-    cudaMemcpyChecked(d_V, V_copy.data(), V_Rows * N * sizeof(DeviceComplexType), cudaMemcpyHostToDevice);
+// Real restart, in place on Q and H: complex conjugate shift pairs go through one Francis double step each, real shifts
+// through a single implicit step, so a real basis never leaves real arithmetic. A conjugate pair straddling the
+// basis_size boundary is kept whole (one shift fewer, as ARPACK's dnaup2 does), then Q/H are truncated to basis_size
+template <typename BK = DefaultBackend>
+int reduceRealArnoldiPair(Eigen::Ref<Matrix> Q, Eigen::Ref<Matrix> H, size_t N, size_t m, size_t basis_size, typename BK::BlasHandle& handle,
+                          Eigen::Ref<Matrix> Q_block, RestartWorkspace& ws, bool verbose = true) {
+    assert(m >= basis_size && ws.m == m);
+    auto start = std::chrono::high_resolution_clock::now();
+    ws.real_schur.computeFromHessenberg(H.topLeftCorner(m, m), H.topLeftCorner(m, m), false);
+    ComplexType* shifts = ws.shifts;
+    quasiTriangularEigenvalues(ws.real_schur.matrixT(), shifts);
+    // Equal magnitudes fall back to the imaginary part so each conjugate pair stays adjacent, + first
+    std::sort(shifts, shifts + m, [](const ComplexType& a, const ComplexType& b) {
+        return magnitude(a) != magnitude(b) ? magnitude(a) > magnitude(b) : a.imag() > b.imag();
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    if (verbose) {
+    std::cout << "Time for eigsolver: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms" << std::endl;
+    }
 
+    start = std::chrono::high_resolution_clock::now();
+    const bool accumulate = ws.update == BasisUpdate::ACCUMULATE;
+    Eigen::Map<Matrix> V(ws.real_accumulated, m, m);
+    if (accumulate) {V.setIdentity();}
+    Eigen::Ref<Matrix> H_m = H.topLeftCorner(m, m);
+    Eigen::Ref<Matrix> Q_m = accumulate ? Eigen::Ref<Matrix>(V) : Eigen::Ref<Matrix>(Q.leftCols(m));
+    const bool split = basis_size > 0 && basis_size < m && shifts[basis_size].imag() < 0 && shifts[basis_size - 1] == std::conj(shifts[basis_size]);
+    const cpublas::Handle host = hostHandle<BK>(handle);
+    for (size_t i = basis_size + (split ? 1 : 0); i < m;) {
+        const ComplexType mu = shifts[i];
+        if (mu.imag() != 0 && i + 1 < m && m >= 3) {
+            francisDoubleStep(host, H_m, Q_m, 2 * mu.real(), std::norm(mu), ws.reflectors, ws.cosines, ws.real_sines);
+            i += 2;
+        } else {
+            implicitShiftStep<HostPrecision>(host, H_m, Q_m, mu.real(), ws.cosines, ws.real_sines);
+            i += 1;
+        }
+    }
+    if (accumulate) {
+        // Q_k = Q V_k, a real N x m x k gemm
+        assert(Q_block.cols() >= static_cast<Eigen::Index>(basis_size));
+        restartGemm<HostPrecision, BK>(handle, N, basis_size, m, Q.data(), Q.outerStride(), V.data(), m, Q_block.data(),
+                                       Q_block.outerStride());
+        Q.leftCols(basis_size) = Q_block.leftCols(basis_size);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    if (verbose) {
+    std::cout << "Time for incremental shifts: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms" << std::endl;
+    }
 
-    CHECK_CUSOLVER(cusolverDnZungqr_bufferSize(solver_handle, N, N, N, d_Q, N, h_Tauarray[0], &lwork));
-    DeviceComplexType* d_work = cudaMallocChecked<DeviceComplexType>(lwork * sizeof(DeviceComplexType));
+    assert(isHessenberg<Matrix>(H_m));
+    H.rightCols(H.cols() - basis_size).setZero();
+    H.bottomRows(H.rows() - basis_size).setZero();
+    Q.rightCols(Q.cols() - basis_size).setZero();
+    return 0;
+}
 
-    // Copy all QR factorization matrices to device in one go
+// Pair must be passed as Complex Matrix. Modified in Place (H will most likely have complexx evecs)
+// Runtime-sized restart: m - basis_size shifted QR steps on H (m x m), Q (N x m) rotated along. Q/H may be maps over
+// solver workspaces, Q_block (N x m) and H_square (m x m) are caller-provided scratch of exactly those sizes, in the
+// scalar of the basis. Nothing here touches the heap once ws has been bound for this m
+template <typename M, typename BK = DefaultBackend>
+int reduceArnoldiPairDynamic(Eigen::Ref<M> Q, Eigen::Ref<M> H, size_t N, size_t m, const size_t& basis_size, typename BK::BlasHandle& handle, typename BK::SolverHandle&, Eigen::Ref<M> Q_block, Eigen::Ref<M> H_square, RestartWorkspace& ws, bool verbose = true) {
+    assert(m >= basis_size && ws.m == m);
+    if constexpr (!is_complex_v<typename M::Scalar>) {
+        return reduceRealArnoldiPair<BK>(Q, H, N, m, basis_size, handle, Q_block, ws, verbose);
+    } else {
+        const bool accumulate = ws.update == BasisUpdate::ACCUMULATE;
+        Eigen::Map<ComplexMatrix> V(ws.schur_vectors, m, m);
+        H_square = H.block(0, 0, m, m);
+        if (accumulate) {V.setIdentity();}
+        else {Q_block = Q.block(0, 0, N, m);}
+
+        // Shifts are the unwanted Ritz values, the m - basis_size smallest in magnitude. H is already Hessenberg and no
+        // eigenvectors are needed, so the Ritz values are just the diagonal of its Schur form
+        auto start = std::chrono::high_resolution_clock::now();
+        ws.schur.computeFromHessenberg(H_square, H_square, false);
+        ComplexType* shifts = ws.shifts;
+        for (size_t k = 0; k < m; ++k) {shifts[k] = ws.schur.matrixT()(k, k);}
+        std::sort(shifts, shifts + m, [](const ComplexType& a, const ComplexType& b) {return magnitude(a) > magnitude(b);});
+        auto end = std::chrono::high_resolution_clock::now();
+        if (verbose) {
+        std::cout << "Time for eigsolver: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms" << std::endl;
+        }
 
-    // Process each QR factorization. Use Zgemm to compute d_H = d_S + d_Q^H * d_H * d_Q, d_V = d_V * d_Q
-    for (int batch_idx = 0; batch_idx < batch_count; batch_idx++) {
-        // Each d_Q[batch_idx] is a pointer to the batch_idx-th matrix
-        DeviceComplexType* d_Q_current = d_Q + batch_idx * N * N; // Pointer to the current matrix
-        CHECK_CUSOLVER(cusolverDnZungqr(solver_handle, N, N, N, d_Q_current, N, h_Tauarray[batch_idx], d_work, lwork, d_info));
-        CHECK_CUBLAS(cublasZgemm(handle, CUBLAS_OP_C, CUBLAS_OP_N, N, N, N, &one, d_Q_current, N, d_H, N, &zero, d_H, N));
-        CHECK_CUBLAS(cublasZgemm(handle, CUBLAS_OP_N, CUBLAS_OP_N, N, N, N, &one, d_H, N, d_Q_current, N, &zero, d_H, N));
-        CHECK_CUBLAS(cublasZgemm(handle, CUBLAS_OP_N, CUBLAS_OP_N, V_Rows, N, N, &one, d_V, V_Rows, d_Q_current, N, &zero, d_V, V_Rows));
-    }
+        const HostPrecision tol = default_tol * H.norm();
 
+        start = std::chrono::high_resolution_clock::now();
+        const cpublas::Handle host = hostHandle<BK>(handle);
+        for (size_t i = 0; i < m - basis_size; i++) {
+            if (accumulate) {
+                implicitShiftStep<ComplexType>(host, H_square, V, shifts[basis_size + i], ws.cosines, ws.sines);
+            } else {
+                implicitShiftStep<ComplexType>(host, H_square, Q_block, shifts[basis_size + i], ws.cosines, ws.sines);
+                mollify(Q_block, tol);
+            }
+            mollify(H_square, tol);
+        }
+        if (accumulate) {
+            restartGemm<ComplexType, BK>(handle, N, basis_size, m, Q.data(), Q.outerStride(), V.data(), m, Q_block.data(),
+                                         Q_block.outerStride());
+        }
+        end = std::chrono::high_resolution_clock::now();
+        if (verbose) {
+        std::cout << "Time for incremental shifts: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms" << std::endl;
+        }
 
-    // #define DEBUG
-    #ifdef DEBUG
-    ComplexMatrix S = ComplexMatrix::Identity(N,N);
-    ComplexMatrix h_Q(N, N * batch_count);    
-    ComplexMatrix h_h = q_h.H;
-    std::cout << h_h << std::endl;
-    std::vector<DeviceComplexType> buffer(N * N * batch_count);
-    cudaMemcpyChecked(buffer.data(), d_Q, N * N * batch_count * sizeof(DeviceComplexType), cudaMemcpyDeviceToHost);
-    h_Q = Eigen::Map<ComplexMatrix>(reinterpret_cast<std::complex<double>*>(buffer.data()), N, N * batch_count);
-    for (int i = 0; i < batch_count; i++) {
-        // Extract the current batch
-        ComplexMatrix h_Q_current = h_Q.block(0, i * N, N, N);
-        S *= h_Q_current;
-        mollify(h_Q_current);
-        h_h = h_Q_current.adjoint() * h_h * h_Q_current;
-        mollify(h_h);
-        std::cout << h_h << std::endl;
-        // assert(isHessenberg<ComplexMatrix>(h_h));
-        assert(isHessenberg<ComplexMatrix>(h_Q_current));
-        // assert(isHessenberg<ComplexMatrix>(S));
-    }
-    #endif
+        assert(isHessenberg<ComplexMatrix>(H_square));
 
+        start = std::chrono::high_resolution_clock::now();
 
+        H.setZero();
+        H.topLeftCorner(basis_size, basis_size) = H_square.topLeftCorner(basis_size, basis_size);
+        Q.leftCols(basis_size) = Q_block.leftCols(basis_size);
+        Q.rightCols(Q.cols() - basis_size).setZero();
+        if (!accumulate) {mollify(Q);}
+        mollify(H);
 
-    // Copy result back to host
-    cudaMemcpyChecked(q_h.H.data(), d_H, N * N * sizeof(DeviceComplexType), cudaMemcpyDeviceToHost);
-    cudaMemcpyChecked(q_h.Q.data(), d_V, V_Rows * N * sizeof(DeviceComplexType), cudaMemcpyDeviceToHost);
+        end = std::chrono::high_resolution_clock::now();
+        if (verbose) {
+        std::cout << "Time for resizing: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms" << std::endl;
+        }
 
-        // Cleanup device memory
-    cudaFreeChecked(d_V);
-    cudaFreeChecked(d_H);
-    cudaFreeChecked(d_info);
-    cudaFreeChecked(d_work);
+        return 0;
+    }
+}
 
-    return 0;
+// One-off restart, binds a throwaway workspace
+template <typename M, typename BK = DefaultBackend>
+int reduceArnoldiPairDynamic(Eigen::Ref<M> Q, Eigen::Ref<M> H, size_t N, size_t m, const size_t& basis_size, typename BK::BlasHandle& handle, typename BK::SolverHandle& solver_handle, Eigen::Ref<M> Q_block, Eigen::Ref<M> H_square, bool verbose = true) {
+    WorkspaceArena arena(RestartWorkspace::footprint(m));
+    RestartWorkspace ws;
+    ws.bind(arena, m);
+    return reduceArnoldiPairDynamic<M, BK>(Q, H, N, m, basis_size, handle, solver_handle, Q_block, H_square, ws, verbose);
+}
+
+// Swaps the adjacent diagonal entries j, j + 1 of upper triangular T with one rotation (ztrexc), Z accumulates it
+inline void swapSchurPair(Eigen::Ref<ComplexMatrix> T, Eigen::Ref<ComplexMatrix> Z, Eigen::Index j) {
+    const Eigen::Index m = T.rows();
+    const ComplexType t11 = T(j, j);
+    const ComplexType t22 = T(j + 1, j + 1);
+    HostPrecision c;
+    ComplexType s;
+    if (!givensRotation(T(j, j + 1), t22 - t11, c, s)) {return;}
+    for (Eigen::Index k = j + 2; k < m; ++k) {
+        const ComplexType x = T(j, k);
+        const ComplexType y = T(j + 1, k);
+        T(j, k) = c * x + s * y;
+        T(j + 1, k) = c * y - std::conj(s) * x;
     }
+    for (Eigen::Index i = 0; i < j; ++i) {
+        const ComplexType x = T(i, j);
+        const ComplexType y = T(i, j + 1);
+        T(i, j) = c * x + std::conj(s) * y;
+        T(i, j + 1) = c * y - s * x;
+    }
+    T(j, j) = t22;
+    T(j + 1, j + 1) = t11;
+    for (Eigen::Index i = 0; i < Z.rows(); ++i) {
+        const ComplexType x = Z(i, j);
+        const ComplexType y = Z(i, j + 1);
+        Z(i, j) = c * x + std::conj(s) * y;
+        Z(i, j + 1) = c * y - s * x;
+    }
+}
 
-inline int cublasQRShift(ComplexKrylovPair& q_h, const ComplexVector& eigenvalues, const size_t& basis_size, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle) {
-    const size_t N = q_h.m;
-    const size_t N_squared = N * N;
-    const size_t batch_count = N - basis_size;
+// Swaps the adjacent diagonal blocks of quasi-triangular T starting at j, p x p then q x q (p, q in {1, 2}), by one
+// orthogonal transformation (dlaexc): X solves A11 X - X A22 = A12, and the QR factor G of [X; -I] moves the invariant
+// subspace of A22 to the front. Z accumulates G. Returns false and leaves T alone when the blocks share an eigenvalue
+inline bool swapRealSchurBlocks(Eigen::Ref<Matrix> T, Eigen::Ref<Matrix> Z, Eigen::Index j, Eigen::Index p, Eigen::Index q) {
+    using Small = Eigen::Matrix<HostPrecision, Eigen::Dynamic, Eigen::Dynamic, 0, 4, 4>;
+    using SmallVector = Eigen::Matrix<HostPrecision, Eigen::Dynamic, 1, 0, 4, 1>;
+    const Eigen::Index m = T.rows();
+    const Eigen::Index n = p + q;
+    // Kronecker form (I_q x A11 - A22^T x I_p) vec X = vec A12, at most 4 x 4
+    Small K = Small::Zero(p * q, p * q);
+    SmallVector rhs(p * q);
+    for (Eigen::Index c = 0; c < q; ++c) {
+        for (Eigen::Index r = 0; r < p; ++r) {
+            for (Eigen::Index l = 0; l < p; ++l) {K(c * p + r, c * p + l) += T(j + r, j + l);}
+            for (Eigen::Index l = 0; l < q; ++l) {K(c * p + r, l * p + r) -= T(j + p + l, j + p + c);}
+            rhs(c * p + r) = T(j + r, j + p + c);
+        }
+    }
+    const Eigen::FullPivLU<Small> lu(K);
+    if (!lu.isInvertible()) {return false;}
+    const SmallVector x = lu.solve(rhs);
+    Small W = Small::Zero(n, q);
+    for (Eigen::Index c = 0; c < q; ++c) {
+        W.col(c).head(p) = x.segment(c * p, p);
+        W(p + c, c) = -1;
+    }
+    const Small G = Eigen::HouseholderQR<Small>(W).householderQ();
 
-    // Allocs for cross-function arrays
-    DeviceComplexType* d_Q = cudaMallocChecked<DeviceComplexType>((batch_count + 1) * N_squared * sizeof(DeviceComplexType));
-    std::vector<DeviceComplexType*> h_Tauarray(batch_count);
-    DeviceComplexType* d_tau = cudaMallocChecked<DeviceComplexType>(batch_count * N * sizeof(DeviceComplexType));    
-    for (size_t i = 0; i < batch_count; ++i) {h_Tauarray[i] = d_tau + i * N;}
+    SmallVector v(n);
+    for (Eigen::Index c = j; c < m; ++c) {
+        v.noalias() = G.transpose() * T.col(c).segment(j, n);
+        T.col(c).segment(j, n) = v;
+    }
+    for (Eigen::Index r = 0; r < std::min(m, j + n); ++r) {
+        v.noalias() = G.transpose() * T.row(r).segment(j, n).transpose();
+        T.row(r).segment(j, n) = v.transpose();
+    }
+    for (Eigen::Index r = 0; r < Z.rows(); ++r) {
+        v.noalias() = G.transpose() * Z.row(r).segment(j, n).transpose();
+        Z.row(r).segment(j, n) = v.transpose();
+    }
+    T.block(j + q, j, p, q).setZero();
+    return true;
+}
 
-    cublasComputeQ(d_Q, h_Tauarray, q_h, eigenvalues, basis_size, handle, solver_handle);
-    cublasQProduct(d_Q, h_Tauarray, q_h, basis_size, handle, solver_handle);
+// Size of the diagonal block of quasi-triangular T starting at row j
+inline Eigen::Index schurBlockSize(const Eigen::Ref<const Matrix>& T, Eigen::Index j) {
+    return j + 1 < T.rows() && T(j + 1, j) != 0 ? 2 : 1;
+}
 
-    cudaFreeChecked(d_Q);
-    cudaFreeChecked(d_tau);
-    return 0;
+// Magnitude key of a Schur block, as magnitude() ranks its eigenvalues: |t| for 1 x 1, |lambda|^2 = det for a pair
+inline HostPrecision schurBlockMagnitude(const Eigen::Ref<const Matrix>& T, Eigen::Index j) {
+    if (schurBlockSize(T, j) == 1) {return std::abs(T(j, j));}
+    return std::sqrt(std::abs(T(j, j) * T(j + 1, j + 1) - T(j, j + 1) * T(j + 1, j)));
 }
 
-#endif //GPU_RESTART
+// Real Krylov-Schur restart, the real Schur form H_m = Z T Z^T taking the place of the complex one. Blocks are moved
+// whole, so T_k stays quasi-triangular and real and a conjugate pair is never split. When the pair straddles the
+// basis_size boundary it is kept (basis_size + 1 columns) if the basis has room, dropped otherwise. Locking works on
+// whole blocks as well. Returns the number of kept columns
+template <typename BK = DefaultBackend>
+size_t realKrylovSchurRestart(Eigen::Ref<Matrix> Q, Eigen::Ref<Matrix> H, size_t N, size_t m, size_t basis_size, typename BK::BlasHandle& handle,
+                              Eigen::Ref<Matrix> Q_block, Eigen::Ref<Matrix> H_square, RestartWorkspace& ws, size_t& locked, HostPrecision lock_tol,
+                              bool verbose) {
+    assert(m > basis_size && basis_size > locked && ws.m == m);
+    const size_t L = locked;
+    const Eigen::Index active = m - L;
+    Eigen::Map<Matrix> Z(ws.real_accumulated, active, active);
+    Eigen::Ref<Matrix> T = H_square.topLeftCorner(active, active);
 
-// Pair must be passed as Complex Matrix. Modified in Place (H will most likely have complexx evecs)
-template <typename M, size_t N, size_t m>
-int reduceArnoldiPairInternal(M& Q, M& H, const size_t& basis_size, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle, ComplexMatrix& Q_block, ComplexMatrix& H_square) {
-    // Compute eigenvalues and eigenvectors
-    assert(m >= basis_size);
-    constexpr bool isComplex = is_complex_v<typename M::Scalar>;
-    H_square = H.block(0, 0, m, m);
-    Q_block = Q.block(0, 0, N, m);
-    ComplexEigenPairs H_pairs{};
-
-    // Start timing for eigsolver
     auto start = std::chrono::high_resolution_clock::now();
-    hessEigSolver<ComplexMatrix>(H_square, H_pairs, m);
+    T = H.block(L, L, active, active);
+    hessenbergReduce(T, Z, ws.cosines);
+    ws.real_schur.computeFromHessenberg(T, Z, true);
+    T = ws.real_schur.matrixT();
+    Z = ws.real_schur.matrixU();
+    if (active > 2) {T.bottomLeftCorner(active - 2, active - 2).triangularView<Eigen::Lower>().setZero();}
+    // Selection sort on blocks: the largest remaining block is bubbled forward to p by adjacent block swaps
+    const Eigen::Index target = basis_size - L;
+    Eigen::Index p = 0, last = 1;
+    while (p < target) {
+        Eigen::Index q = p;
+        for (Eigen::Index j = p; j < active; j += schurBlockSize(T, j)) {
+            if (schurBlockMagnitude(T, j) > schurBlockMagnitude(T, q)) {q = j;}
+        }
+        const Eigen::Index size = schurBlockSize(T, q);
+        while (q > p) {
+            const Eigen::Index prev = q - 2 >= p && T(q - 1, q - 2) != 0 ? q - 2 : q - 1;
+            if (!swapRealSchurBlocks(T, Z, prev, q - prev, size)) {break;}
+            q = prev;
+        }
+        last = schurBlockSize(T, p);
+        p += last;
+    }
+    // A pair straddling basis_size needs one more column, there must still be room for the residual vector
+    const size_t kept = L + p < m || p <= last ? p : p - last;
+    const size_t k = L + kept;
     auto end = std::chrono::high_resolution_clock::now();
-    std::cout << "Time for eigsolver: "
+    if (verbose) {
+    std::cout << "Time for ordered real Schur form: "
               << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
               << " ms" << std::endl;
+    }
 
-    double tol = 1e-10 * H.norm();
-
-    // Start timing for incremental shifts
     start = std::chrono::high_resolution_clock::now();
-    #ifdef EIGEN_RESTART
-    Eigen::MatrixXcd Qi(m, m);
-    for (int i = 0; i < m - basis_size; i++) {
-        Eigen::HouseholderQR<Eigen::MatrixXcd> qr(H_square - H_pairs.values(i) * Eigen::MatrixXcd::Identity(m, m));
-        Qi = qr.householderQ();
-        H_square = Qi.adjoint() * H_square * Qi;
-        Q_block *= Qi;
-        // std::cout << "Iteration " << i << std::endl;
-        mollify(H_square, tol);
-        mollify(Q_block, tol);
+    const HostPrecision beta = H(m, m - 1);
+    restartGemm<HostPrecision, BK>(handle, N, kept, active, Q.col(L).data(), Q.outerStride(), Z.data(), active, Q_block.data(),
+                                   Q_block.outerStride());
+    Q.col(k) = Q.col(m);
+    Q.middleCols(L, kept) = Q_block.leftCols(kept);
+    Q.rightCols(Q.cols() - k - 1).setZero();
+
+    Eigen::Map<Matrix> coupling(Q_block.data(), L, kept);
+    coupling.noalias() = H.block(0, L, L, active) * Z.leftCols(kept);
+    H.rightCols(H.cols() - L).setZero();
+    H.bottomRows(H.rows() - L).setZero();
+    H.block(0, L, L, kept) = coupling;
+    H.block(L, L, kept, kept) = T.topLeftCorner(kept, kept);
+    H.row(k).segment(L, kept) = beta * Z.row(active - 1).head(kept);
+    while (locked < k) {
+        const size_t size = locked + 1 < k && H(locked + 1, locked) != 0 ? 2 : 1;
+        if (locked + size >= k || H.row(k).segment(locked, size).cwiseAbs().maxCoeff() >= lock_tol) {break;}
+        H.row(k).segment(locked, size).setZero();
+        locked += size;
     }
-    #endif
-    #ifdef CUBLAS_RESTART
-    cublasQRShift(q_h, H_pairs.values, basis_size, handle, solver_handle);
-    #endif
-    // std::cout << q_h.H <<std::endl;
     end = std::chrono::high_resolution_clock::now();
-    std::cout << "Time for incremental shifts: "
+    if (verbose) {
+    std::cout << "Time for basis truncation: "
               << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
-              << " ms" << std::endl;
-
-    assert(isHessenberg<ComplexMatrix>(H_square));
+              << " ms, " << locked << " locked" << std::endl;
+    }
+    return k;
+}
 
-    // Start timing for resizing
-    start = std::chrono::high_resolution_clock::now();
+// Krylov-Schur restart (Stewart). One Schur decomposition H_m = Z T Z^H, the basis_size largest Ritz values moved to
+// the front of T by adjacent swaps, then a single N x m x basis_size product Q Z_k replaces the m - basis_size QR steps.
+// Leaves A Q_k = Q_k T_k + q_{m+1} b^T with b^T = h_{m+1,m} e_m^T Z_k: on return Q holds Q_k and q_{m+1} as column
+// basis_size, H holds T_k with b^T as row basis_size. H is no longer Hessenberg, so later restarts of the same run must
+// also come through here. Scratch as for reduceArnoldiPairDynamic, heap-free once ws is bound.
+//
+// Locking: the first `locked` columns are converged Schur vectors with b_i = 0, so A Q_L = Q_L T_L exactly and H is
+// block upper triangular. Only the trailing active block is decomposed, reordered and multiplied into the basis; the
+// locked columns stay put and only act as an orthogonalization constraint for the next cycle. Afterwards every leading
+// active pair with |b_i| < lock_tol is deflated (b_i := 0) and joins them, locked grows but stays below basis_size.
+// Returns the number of kept columns, basis_size except when a real basis keeps a straddling conjugate pair
+template <typename M, typename BK = DefaultBackend>
+size_t krylovSchurRestart(Eigen::Ref<M> Q, Eigen::Ref<M> H, size_t N, size_t m, const size_t& basis_size, typename BK::BlasHandle& handle,
+                          Eigen::Ref<M> Q_block, Eigen::Ref<M> H_square, RestartWorkspace& ws, size_t& locked, HostPrecision lock_tol, bool verbose = true) {
+    if constexpr (!is_complex_v<typename M::Scalar>) {
+        return realKrylovSchurRestart<BK>(Q, H, N, m, basis_size, handle, Q_block, H_square, ws, locked, lock_tol, verbose);
+    } else {
+        assert(m > basis_size && basis_size > locked && ws.m == m);
+        const size_t L = locked;
+        const size_t k = basis_size;
+        const size_t active = m - L;
+        const size_t kept = k - L;
+        Eigen::Map<ComplexMatrix> Z(ws.schur_vectors, active, active);
+        Eigen::Ref<ComplexMatrix> T = H_square.topLeftCorner(active, active);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ws.schur.compute(H.block(L, L, active, active), true);
+        T = ws.schur.matrixT();
+        Z = ws.schur.matrixU();
+        // Selection sort by adjacent swaps, the leading kept diagonal entries end up in descending magnitude
+        for (size_t p = 0; p < kept; ++p) {
+            size_t q = p;
+            for (size_t j = p + 1; j < active; ++j) {
+                if (magnitude(T(j, j)) > magnitude(T(q, q))) {q = j;}
+            }
+            for (size_t j = q; j > p; --j) {swapSchurPair(T, Z, j - 1);}
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        if (verbose) {
+        std::cout << "Time for ordered Schur form: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms" << std::endl;
+        }
 
-    H.setZero();
-    Q.setZero();
+        start = std::chrono::high_resolution_clock::now();
+        const ComplexType beta = H(m, m - 1);
+        restartGemm<ComplexType, BK>(handle, N, kept, active, Q.col(L).data(), Q.outerStride(), Z.data(), active, Q_block.data(),
+                                     Q_block.outerStride());
+        Q.col(k) = Q.col(m);
+        Q.middleCols(L, kept) = Q_block.leftCols(kept);
+        Q.rightCols(Q.cols() - k - 1).setZero();
+
+        // Coupling of the locked block to the new active columns, H_LA Z_kept, staged in the now free basis scratch
+        Eigen::Map<ComplexMatrix> coupling(Q_block.data(), L, kept);
+        coupling.noalias() = H.block(0, L, L, active) * Z.leftCols(kept);
+        H.rightCols(H.cols() - L).setZero();
+        H.bottomRows(H.rows() - L).setZero();
+        H.block(0, L, L, kept) = coupling;
+        H.block(L, L, kept, kept) = T.topLeftCorner(kept, kept).template triangularView<Eigen::Upper>();
+        H.row(k).segment(L, kept) = beta * Z.row(active - 1).head(kept);
+        while (locked + 1 < k && std::abs(H(k, locked)) < lock_tol) {H(k, locked++) = 0;}
+        end = std::chrono::high_resolution_clock::now();
+        if (verbose) {
+        std::cout << "Time for basis truncation: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms, " << locked << " locked" << std::endl;
+        }
 
-    if constexpr (isComplex) {
-        H.topLeftCorner(basis_size, basis_size) = H_square.topLeftCorner(basis_size, basis_size);
-        Q.leftCols(basis_size) = Q_block.leftCols(basis_size);
-        mollify(Q);
-        mollify(H);
-    } else {
-        H.topLeftCorner(basis_size, basis_size) = H_square.topLeftCorner(basis_size, basis_size).real();
-        Q.leftCols(basis_size) = Q_block.leftCols(basis_size).real();
+        return k;
     }
+}
 
-    end = std::chrono::high_resolution_clock::now();
-    std::cout << "Time for resizing: "
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
-              << " ms" << std::endl;
+template <typename M, typename BK = DefaultBackend>
+size_t krylovSchurRestart(Eigen::Ref<M> Q, Eigen::Ref<M> H, size_t N, size_t m, const size_t& basis_size, typename BK::BlasHandle& handle,
+                          Eigen::Ref<M> Q_block, Eigen::Ref<M> H_square, RestartWorkspace& ws, bool verbose = true) {
+    size_t locked = 0;
+    return krylovSchurRestart<M, BK>(Q, H, N, m, basis_size, handle, Q_block, H_square, ws, locked, 0, verbose);
+}
 
-    return 0;
+template <typename M, size_t N, size_t m, typename BK = DefaultBackend>
+int reduceArnoldiPairInternal(M& Q, M& H, const size_t& basis_size, typename BK::BlasHandle& handle, typename BK::SolverHandle& solver_handle, M& Q_block, M& H_square) {
+    Q_block.resize(N, m);
+    H_square.resize(m, m);
+    return reduceArnoldiPairDynamic<M, BK>(Q, H, N, m, basis_size, handle, solver_handle, Q_block, H_square);
 }
 
-template <typename M, size_t N, size_t m>
-inline int reduceArnoldiPair(M& Q, M& H, const size_t& basis_size, cublasHandle_t& handle, cusolverDnHandle_t& solver_handle) {
-    ComplexMatrix Q_block(m, m);
-    ComplexMatrix H_square(N,m);
-    return reduceArnoldiPairInternal<ComplexMatrix, N, m>(Q, H, basis_size, handle, solver_handle, Q_block, H_square);
+template <typename M, size_t N, size_t m, typename BK = DefaultBackend>
+inline int reduceArnoldiPair(M& Q, M& H, const size_t& basis_size, typename BK::BlasHandle& handle, typename BK::SolverHandle& solver_handle) {
+    M Q_block(N, m);
+    M H_square(m, m);
+    return reduceArnoldiPairInternal<M, N, m, BK>(Q, H, basis_size, handle, solver_handle, Q_block, H_square);
 }
 
 // template <typename M>
 // int reduceArnoldiPair(
 
+#ifdef USE_CUDA
 int constructSMatrix(cusolverDnHandle_t solver_handle,
                             cublasHandle_t blas_handle,
                             const std::vector<DeviceComplexType*>& h_Aarray, 
@@ -324,4 +731,5 @@ int constructSMatrix(cusolverDnHandle_t solver_handle,
 
     return 0;
 }
+#endif // USE_CUDA
 #endif // SHIFT_HPP
\ No newline at end of file
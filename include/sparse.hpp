@@ -0,0 +1,416 @@
+// Compressed sparse row and sliced-ELLPACK (SELL-C-sigma) storage. Both satisfy LinearOperator, so KrylovIter/NaiveArnoldi/IRAM
+// take them directly and each Krylov step streams O(nnz) instead of O(N^2). apply() runs on host memory (CpuBackend).
+#ifndef SPARSE_HPP
+#define SPARSE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <eigen3/Eigen/Sparse>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "vector.hpp"
+#include "errormsg.hpp"
+
+namespace sparse {
+    // Merge-path coordinate: x indexes rows (row-end offsets), y indexes nonzeros
+    struct MergeCoord {
+        size_t x;
+        size_t y;
+    };
+
+    // Binary search along one cross-diagonal of the (rows x nnz) merge grid (Merrill & Garland)
+    template <typename I>
+    inline MergeCoord mergePathSearch(size_t diagonal, const I* row_end_offsets, size_t num_rows, size_t nnz) {
+        size_t x_min = diagonal > nnz ? diagonal - nnz : 0;
+        size_t x_max = std::min(diagonal, num_rows);
+        while (x_min < x_max) {
+            const size_t pivot = (x_min + x_max) / 2;
+            if (static_cast<size_t>(row_end_offsets[pivot]) <= diagonal - pivot - 1) {x_min = pivot + 1;}
+            else {x_max = pivot;}
+        }
+        return {std::min(x_min, num_rows), diagonal - x_min};
+    }
+
+    inline int maxThreads() {
+        #ifdef _OPENMP
+            return omp_get_max_threads();
+        #else
+            return 1;
+        #endif
+    }
+} // namespace sparse
+
+// T := stored value type, S := vector scalar. CSRMatrix<double, ComplexType> applies a real matrix to complex vectors
+template <typename T, typename S = T, typename I = int>
+class CSRMatrix {
+public:
+    using Scalar = S;
+    using ValueType = T;
+    using IndexType = I;
+    static_assert(std::is_same_v<T, S> || (!is_complex_v<T> && is_complex_v<S>),
+                  "CSR values must match the vector scalar or be real with complex vectors.");
+
+    CSRMatrix() : rows_(0), cols_(0) {}
+
+    CSRMatrix(size_t rows, size_t cols, std::vector<I> row_ptr, std::vector<I> col_ind, std::vector<T> values)
+        : rows_(rows), cols_(cols), row_ptr_(std::move(row_ptr)), col_ind_(std::move(col_ind)), values_(std::move(values)) {
+        if (row_ptr_.size() != rows_ + 1 || col_ind_.size() != values_.size()
+            || static_cast<size_t>(row_ptr_.back()) != values_.size()) {
+            throw std::invalid_argument("Inconsistent CSR arrays: " + std::to_string(row_ptr_.size()) + " row pointers, "
+                                        + std::to_string(col_ind_.size()) + " column indices, " + std::to_string(values_.size()) + " values");
+        }
+    }
+
+    // Accepts any Eigen sparse matrix (row- or column-major) with a convertible scalar
+    template <typename SparseType>
+    static CSRMatrix fromEigen(const SparseType& A) {
+        Eigen::SparseMatrix<T, Eigen::RowMajor, I> R = A.template cast<T>();
+        R.makeCompressed();
+        const size_t nnz = R.nonZeros();
+        std::vector<I> row_ptr(R.outerIndexPtr(), R.outerIndexPtr() + R.rows() + 1);
+        std::vector<I> col_ind(R.innerIndexPtr(), R.innerIndexPtr() + nnz);
+        std::vector<T> values(R.valuePtr(), R.valuePtr() + nnz);
+        return CSRMatrix(R.rows(), R.cols(), std::move(row_ptr), std::move(col_ind), std::move(values));
+    }
+
+    template <typename MatrixType>
+    static CSRMatrix fromDense(const MatrixType& A, const HostPrecision tol = 0) {
+        std::vector<I> row_ptr(A.rows() + 1, 0);
+        std::vector<I> col_ind;
+        std::vector<T> values;
+        for (Eigen::Index i = 0; i < A.rows(); ++i) {
+            for (Eigen::Index j = 0; j < A.cols(); ++j) {
+                if (std::abs(A(i, j)) > tol) {
+                    col_ind.push_back(static_cast<I>(j));
+                    values.push_back(static_cast<T>(A(i, j)));
+                }
+            }
+            row_ptr[i + 1] = static_cast<I>(values.size());
+        }
+        return CSRMatrix(A.rows(), A.cols(), std::move(row_ptr), std::move(col_ind), std::move(values));
+    }
+
+    inline size_t rows() const { return rows_; }
+    inline size_t cols() const { return cols_; }
+    inline size_t nnz() const { return values_.size(); }
+    inline const std::vector<I>& rowPtr() const { return row_ptr_; }
+    inline const std::vector<I>& colInd() const { return col_ind_; }
+    inline const std::vector<T>& values() const { return values_; }
+
+    // 0 := OpenMP default
+    inline void setNumThreads(int num_threads) const { num_threads_ = num_threads; }
+    inline int numThreads() const { return num_threads_; }
+
+    HostPrecision norm() const {
+        HostPrecision acc = 0;
+        for (const T& v : values_) {acc += std::norm(v);}
+        return std::sqrt(acc);
+    }
+
+    inline void apply(const S* x, S* y) const { spmv(x, y); }
+
+    // y = A x, work split evenly over rows + nnz so skewed rows never stall a thread
+    void spmv(const S* x, S* y) const {
+        const size_t num_rows = rows_;
+        const size_t nnz = values_.size();
+        const int threads = std::max(1, std::min<int>(num_threads_ > 0 ? num_threads_ : sparse::maxThreads(),
+                                                      static_cast<int>((num_rows + nnz) / MIN_MERGE_ITEMS) + 1));
+        const I* row_end_offsets = row_ptr_.data() + 1;
+        const I* col = col_ind_.data();
+        const T* val = values_.data();
+
+        size_t* carry_row = carryRows(threads);
+        S* carry_value = carryValues(threads);
+        const size_t path_length = num_rows + nnz;
+        const size_t items_per_thread = (path_length + threads - 1) / threads;
+
+        #pragma omp parallel for schedule(static, 1) num_threads(threads)
+        for (int tid = 0; tid < threads; ++tid) {
+            const size_t d0 = std::min(items_per_thread * tid, path_length);
+            const size_t d1 = std::min(d0 + items_per_thread, path_length);
+            sparse::MergeCoord coord = sparse::mergePathSearch<I>(d0, row_end_offsets, num_rows, nnz);
+            const sparse::MergeCoord coord_end = sparse::mergePathSearch<I>(d1, row_end_offsets, num_rows, nnz);
+
+            // Rows that end inside this thread's range are written outright
+            for (; coord.x < coord_end.x; ++coord.x) {
+                S running(0);
+                for (const size_t row_end = row_end_offsets[coord.x]; coord.y < row_end; ++coord.y) {
+                    running += val[coord.y] * x[col[coord.y]];
+                }
+                y[coord.x] = running;
+            }
+            // Trailing partial row is carried out and fixed up after the join
+            S running(0);
+            for (; coord.y < coord_end.y; ++coord.y) {running += val[coord.y] * x[col[coord.y]];}
+            carry_row[tid] = coord_end.x;
+            carry_value[tid] = running;
+        }
+
+        for (int tid = 0; tid < threads - 1; ++tid) {
+            if (carry_row[tid] < num_rows) {y[carry_row[tid]] += carry_value[tid];}
+        }
+    }
+
+    inline void applyBlock(const S* X, S* Y, size_t p) const { spmm(X, Y, p); }
+
+    // Y = A X for p column-major vectors (ld cols / rows), same merge-path split with p accumulators per row, so the
+    // row structure and values are streamed once for all p vectors
+    void spmm(const S* X, S* Y, size_t p) const {
+        if (p == 1) {spmv(X, Y); return;}
+        const size_t num_rows = rows_;
+        const size_t nnz = values_.size();
+        const int threads = std::max(1, std::min<int>(num_threads_ > 0 ? num_threads_ : sparse::maxThreads(),
+                                                      static_cast<int>(p * (num_rows + nnz) / MIN_MERGE_ITEMS) + 1));
+        const I* row_end_offsets = row_ptr_.data() + 1;
+        const I* col = col_ind_.data();
+        const T* val = values_.data();
+
+        // Each thread accumulates in its own slice of the carry buffer, which ends up holding its trailing partial row.
+        // Slices are padded to whole cache lines so the hot accumulators of neighbouring threads never share one
+        constexpr size_t LINE = std::max<size_t>(1, 64 / sizeof(S));
+        const size_t stride = (p + LINE - 1) / LINE * LINE;
+        size_t* carry_row = carryRows(threads);
+        S* carry_value = carryValues(threads * stride);
+        const size_t path_length = num_rows + nnz;
+        const size_t items_per_thread = (path_length + threads - 1) / threads;
+
+        #pragma omp parallel for schedule(static, 1) num_threads(threads)
+        for (int tid = 0; tid < threads; ++tid) {
+            const size_t d0 = std::min(items_per_thread * tid, path_length);
+            const size_t d1 = std::min(d0 + items_per_thread, path_length);
+            sparse::MergeCoord coord = sparse::mergePathSearch<I>(d0, row_end_offsets, num_rows, nnz);
+            const sparse::MergeCoord coord_end = sparse::mergePathSearch<I>(d1, row_end_offsets, num_rows, nnz);
+            S* running = carry_value + tid * stride;
+
+            for (; coord.x < coord_end.x; ++coord.x) {
+                std::fill(running, running + p, S(0));
+                for (const size_t row_end = row_end_offsets[coord.x]; coord.y < row_end; ++coord.y) {
+                    const T v = val[coord.y];
+                    const S* x = X + col[coord.y];
+                    for (size_t c = 0; c < p; ++c) {running[c] += v * x[c * cols_];}
+                }
+                for (size_t c = 0; c < p; ++c) {Y[coord.x + c * num_rows] = running[c];}
+            }
+            std::fill(running, running + p, S(0));
+            for (; coord.y < coord_end.y; ++coord.y) {
+                const T v = val[coord.y];
+                const S* x = X + col[coord.y];
+                for (size_t c = 0; c < p; ++c) {running[c] += v * x[c * cols_];}
+            }
+            carry_row[tid] = coord_end.x;
+        }
+
+        for (int tid = 0; tid < threads - 1; ++tid) {
+            if (carry_row[tid] >= num_rows) {continue;}
+            for (size_t c = 0; c < p; ++c) {Y[carry_row[tid] + c * num_rows] += carry_value[tid * stride + c];}
+        }
+    }
+
+    template <typename MatrixType = std::conditional_t<is_complex_v<S>, ComplexMatrix, Matrix>>
+    MatrixType toDense() const {
+        MatrixType D = MatrixType::Zero(rows_, cols_);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (I k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) {D(i, col_ind_[k]) += val(k);}
+        }
+        return D;
+    }
+
+private:
+    static constexpr size_t MIN_MERGE_ITEMS = 1 << 12; // Merge items per thread before splitting further pays off
+
+    inline S val(I k) const { return static_cast<S>(values_[k]); }
+
+    // Grow-only merge-path scratch, so a warm matvec makes no heap allocation. Every thread writes its own entries
+    inline size_t* carryRows(size_t threads) const {
+        if (carry_row_.size() < threads) {carry_row_.resize(threads);}
+        return carry_row_.data();
+    }
+    inline S* carryValues(size_t count) const {
+        if (carry_value_.size() < count) {carry_value_.resize(count);}
+        return carry_value_.data();
+    }
+
+    size_t rows_, cols_;
+    std::vector<I> row_ptr_;
+    std::vector<I> col_ind_;
+    std::vector<T> values_;
+    mutable int num_threads_ = 0;
+    mutable std::vector<size_t> carry_row_; // Row each thread's trailing partial sum belongs to
+    mutable std::vector<S> carry_value_;    // That partial sum, p per thread (cache-line strided) for spmm
+};
+
+using SparseMatrix = CSRMatrix<HostPrecision>;
+using ComplexSparseMatrix = CSRMatrix<ComplexType>;
+using MixedSparseMatrix = CSRMatrix<HostPrecision, ComplexType>; // Real storage, complex Krylov basis
+
+// ==================== SELL-C-SIGMA ====================
+
+constexpr size_t SELL_CHUNK = 64 / sizeof(HostPrecision); // Rows per slice, one AVX-512 register of doubles
+constexpr size_t SELL_SIGMA = 32 * SELL_CHUNK;             // Sorting window, keeps the permutation local to a few slices
+
+// Rows are sorted by length inside windows of sigma rows, then packed into slices of C rows padded to the longest row.
+// Each slice is stored column-major, so the inner loop over the C rows is a unit-stride SIMD lane sweep (Kreutzer et al.).
+// Complex values are split per slice column into C real parts followed by C imaginary parts.
+template <typename T, typename S = T, typename I = int, size_t C = SELL_CHUNK>
+class SELLMatrix {
+public:
+    using Scalar = S;
+    using ValueType = T;
+    using IndexType = I;
+    using Real = decltype(std::real(std::declval<T>()));
+    static_assert(std::is_same_v<T, S> || (!is_complex_v<T> && is_complex_v<S>),
+                  "SELL values must match the vector scalar or be real with complex vectors.");
+    static constexpr size_t CHUNK = C;
+
+    static SELLMatrix fromCSR(const CSRMatrix<T, S, I>& A, size_t sigma = SELL_SIGMA) {
+        SELLMatrix R;
+        R.rows_ = A.rows();
+        R.cols_ = A.cols();
+        R.nnz_ = A.nnz();
+        R.sigma_ = std::max<size_t>(C, ((sigma + C - 1) / C) * C);
+        const std::vector<I>& row_ptr = A.rowPtr();
+        auto row_len = [&row_ptr](size_t r) { return static_cast<size_t>(row_ptr[r + 1] - row_ptr[r]); };
+
+        const size_t num_chunks = (R.rows_ + C - 1) / C;
+        R.perm_.resize(num_chunks * C);
+        for (size_t k = 0; k < R.perm_.size(); ++k) {R.perm_[k] = static_cast<I>(std::min(k, R.rows_));} // Tail lanes point past the end
+        for (size_t w = 0; w < R.rows_; w += R.sigma_) {
+            const size_t w_end = std::min(w + R.sigma_, R.rows_);
+            std::stable_sort(R.perm_.begin() + w, R.perm_.begin() + w_end,
+                             [&row_len](I a, I b) { return row_len(a) > row_len(b); });
+        }
+
+        R.chunk_ptr_.assign(num_chunks + 1, 0);
+        R.chunk_len_.assign(num_chunks, 0);
+        for (size_t c = 0; c < num_chunks; ++c) {
+            size_t len = 0;
+            for (size_t r = 0; r < C && c * C + r < R.rows_; ++r) {len = std::max(len, row_len(R.perm_[c * C + r]));}
+            R.chunk_len_[c] = static_cast<I>(len);
+            R.chunk_ptr_[c + 1] = R.chunk_ptr_[c] + static_cast<I>(len * C);
+        }
+
+        // Padding lanes read x[0] with a zero value, so the kernel never branches on row length
+        const size_t padded = R.chunk_ptr_.back();
+        R.col_ind_.assign(padded, 0);
+        R.values_.assign(padded * VALUE_STRIDE, Real(0));
+        const std::vector<I>& col_ind = A.colInd();
+        const std::vector<T>& values = A.values();
+        for (size_t c = 0; c < num_chunks; ++c) {
+            for (size_t r = 0; r < C && c * C + r < R.rows_; ++r) {
+                const I row = R.perm_[c * C + r];
+                for (I k = row_ptr[row], j = 0; k < row_ptr[row + 1]; ++k, ++j) {
+                    const size_t slot = R.chunk_ptr_[c] + static_cast<size_t>(j) * C;
+                    R.col_ind_[slot + r] = col_ind[k];
+                    if constexpr (is_complex_v<T>) {
+                        R.values_[2 * slot + r] = values[k].real();
+                        R.values_[2 * slot + C + r] = values[k].imag();
+                    } else {
+                        R.values_[slot + r] = values[k];
+                    }
+                }
+            }
+        }
+        return R;
+    }
+
+    inline size_t rows() const { return rows_; }
+    inline size_t cols() const { return cols_; }
+    inline size_t nnz() const { return nnz_; }
+    inline size_t sigma() const { return sigma_; }
+    inline size_t paddedSize() const { return col_ind_.size(); }
+    // nnz / stored entries, 1 := no padding overhead
+    inline HostPrecision fillEfficiency() const { return col_ind_.empty() ? 1 : HostPrecision(nnz_) / col_ind_.size(); }
+
+    // 0 := OpenMP default
+    inline void setNumThreads(int num_threads) const { num_threads_ = num_threads; }
+    inline int numThreads() const { return num_threads_; }
+
+    HostPrecision norm() const {
+        HostPrecision acc = 0;
+        for (const Real& v : values_) {acc += v * v;}
+        return std::sqrt(acc);
+    }
+
+    inline void apply(const S* x, S* y) const { spmv(x, y); }
+
+    void spmv(const S* x, S* y) const {
+        const size_t num_chunks = chunk_len_.size();
+        const int threads = std::max(1, std::min<int>(num_threads_ > 0 ? num_threads_ : sparse::maxThreads(),
+                                                      static_cast<int>(col_ind_.size() / MIN_SLICE_ITEMS) + 1));
+        // Slices are short and similar in length after sorting, dynamic scheduling absorbs what the sort leaves over
+        #pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+        for (size_t c = 0; c < num_chunks; ++c) {
+            if constexpr (is_complex_v<S>) {sliceComplex(c, x, y);}
+            else {sliceReal(c, x, y);}
+        }
+    }
+
+private:
+    static constexpr size_t VALUE_STRIDE = is_complex_v<T> ? 2 : 1;
+    static constexpr size_t MIN_SLICE_ITEMS = 1 << 13; // Stored entries per thread before splitting further pays off
+
+    inline void sliceReal(size_t c, const S* x, S* y) const {
+        const Real* val = values_.data() + chunk_ptr_[c];
+        const I* col = col_ind_.data() + chunk_ptr_[c];
+        alignas(64) Real acc[C] = {};
+        for (I j = 0; j < chunk_len_[c]; ++j, val += C, col += C) {
+            #pragma omp simd
+            for (size_t r = 0; r < C; ++r) {acc[r] += val[r] * x[col[r]];}
+        }
+        scatter(c, acc, y);
+    }
+
+    // x is read as interleaved (re, im), lanes accumulate real and imaginary parts separately
+    inline void sliceComplex(size_t c, const S* x, S* y) const {
+        const Real* xr = reinterpret_cast<const Real*>(x);
+        const Real* val = values_.data() + VALUE_STRIDE * chunk_ptr_[c];
+        const I* col = col_ind_.data() + chunk_ptr_[c];
+        alignas(64) Real re[C] = {};
+        alignas(64) Real im[C] = {};
+        for (I j = 0; j < chunk_len_[c]; ++j, val += VALUE_STRIDE * C, col += C) {
+            if constexpr (is_complex_v<T>) {
+                #pragma omp simd
+                for (size_t r = 0; r < C; ++r) {
+                    const Real xre = xr[2 * static_cast<size_t>(col[r])];
+                    const Real xim = xr[2 * static_cast<size_t>(col[r]) + 1];
+                    re[r] += val[r] * xre - val[C + r] * xim;
+                    im[r] += val[r] * xim + val[C + r] * xre;
+                }
+            } else {
+                #pragma omp simd
+                for (size_t r = 0; r < C; ++r) {
+                    re[r] += val[r] * xr[2 * static_cast<size_t>(col[r])];
+                    im[r] += val[r] * xr[2 * static_cast<size_t>(col[r]) + 1];
+                }
+            }
+        }
+        for (size_t r = 0; r < C && c * C + r < rows_; ++r) {y[perm_[c * C + r]] = S(re[r], im[r]);}
+    }
+
+    inline void scatter(size_t c, const Real* acc, S* y) const {
+        for (size_t r = 0; r < C && c * C + r < rows_; ++r) {y[perm_[c * C + r]] = acc[r];}
+    }
+
+    size_t rows_ = 0, cols_ = 0, nnz_ = 0, sigma_ = SELL_SIGMA;
+    std::vector<I> chunk_ptr_;  // Offset of each slice in col_ind_ (values_ offset is VALUE_STRIDE times this)
+    std::vector<I> chunk_len_;  // Padded row length of each slice
+    std::vector<I> col_ind_;
+    std::vector<Real> values_;
+    std::vector<I> perm_;       // Sorted position -> original row
+    mutable int num_threads_ = 0;
+};
+
+using SellMatrix = SELLMatrix<HostPrecision>;
+using ComplexSellMatrix = SELLMatrix<ComplexType>;
+using MixedSellMatrix = SELLMatrix<HostPrecision, ComplexType>;
+
+#endif // SPARSE_HPP
@@ -0,0 +1,172 @@
+// Communication-avoiding (s-step) Arnoldi. Standard Arnoldi needs at least one global reduction after every matvec.
+// Here s Krylov vectors are generated back to back by a matrix-powers pass in the Newton basis
+//     v_{i+1} = (A - theta_i I) v_i / sigma,
+// with Leja-ordered Ritz values as shifts, and are orthogonalized as one block: BCGS2 against the basis (two Q^H V
+// products) followed by a TSQR of the panel (blockQR). That is three reductions per s vectors. The Hessenberg columns follow
+// from the change of basis: with [q_j, v_1 .. v_s] = W Rhat and A [q_j, v_1 .. v_{s-1}] = [q_j, v_1 .. v_s] B,
+//     H_new = (Rhat B - H_old X) U^{-1},   X = Rhat(0:j, 0:s),  U = Rhat(j:j+s, 0:s) upper triangular.
+// A block whose column-scaled Rhat is worse conditioned than SSTEP_MAX_CONDITION is discarded, and the rest of the
+// cycle falls back to standard Arnoldi steps.
+#ifndef SSTEP_HPP
+#define SSTEP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "arnoldi.hpp"
+#include "blockArnoldi.hpp"
+
+constexpr HostPrecision SSTEP_MAX_CONDITION = 1e6;
+
+// Leja ordering: start from the largest magnitude, then repeatedly take the candidate maximizing the product of
+// distances to those already taken (summed in logs). Consecutive Newton factors then spread over the spectrum and the
+// basis stays far better conditioned than the monomial one. Wraps around when count exceeds the candidates
+inline ComplexVector lejaOrder(const ComplexVector& candidates, size_t count) {
+    const Eigen::Index n = candidates.size();
+    ComplexVector ordered(count);
+    Vector score = Vector::Zero(n);
+    std::vector<bool> taken(n, false);
+    for (size_t i = 0; i < count; ++i) {
+        if (i % n == 0) {std::fill(taken.begin(), taken.end(), false); score.setZero();}
+        Eigen::Index best = -1;
+        for (Eigen::Index c = 0; c < n; ++c) {
+            if (taken[c]) {continue;}
+            const HostPrecision key = (i % n == 0) ? std::abs(candidates[c]) : score[c];
+            const HostPrecision best_key = best < 0 ? -std::numeric_limits<HostPrecision>::infinity()
+                                                    : ((i % n == 0) ? std::abs(candidates[best]) : score[best]);
+            if (best < 0 || key > best_key) {best = c;}
+        }
+        taken[best] = true;
+        ordered[i] = candidates[best];
+        for (Eigen::Index c = 0; c < n; ++c) {
+            score[c] += std::log(std::max(std::abs(candidates[c] - candidates[best]), std::numeric_limits<HostPrecision>::min()));
+        }
+    }
+    return ordered;
+}
+
+// Drop-in for KrylovIterDynamic (same buffers and results) that expands the basis s columns at a time. d_coeffs holds
+// (num_iters + 1) * s scalars. Shifts come from the Ritz values of the leading complete block of H (the kept block
+// after a restart), so only a cold start takes its first s columns with standard steps. Real bases use the real parts
+// of the shifts
+template <typename M, typename DS, typename BK = DefaultBackend>
+int SStepKrylovIterDynamic(const M& M_, DS* d_M, DS* d_y, DS* d_result, DS* d_evecs, DS* d_h, HostPrecision* norms, const size_t& ROWS,
+                           size_t N, size_t num_iters, size_t first_ind, size_t s, DS* d_coeffs, typename BK::BlasHandle& handle,
+                           const HostPrecision& matnorm = 1, const HostPrecision& tol = 1e-5,
+                           Orthogonalization orth = Orthogonalization::MGS, DS* d_work = nullptr, KrylovStats* stats = nullptr) {
+    using S = BasisScalar<DS>;
+    using OM = Eigen::Matrix<S, Eigen::Dynamic, Eigen::Dynamic>;
+    constexpr size_t ALLOC_SIZE = sizeof(DS);
+    constexpr BlasOp ADJ = is_complex_v<S> ? BlasOp::C : BlasOp::T;
+    const DS ONE = getOne<DS>();
+    const DS ZERO = getZero<DS>();
+    const DS NEG_ONE = getNegOne<DS>();
+    const size_t ld = num_iters + 1;
+
+    // Standard steps over [from, to), returns the complete column count and whether the basis broke down
+    auto standard = [&](size_t from, size_t to) -> std::pair<size_t, bool> {
+        for (size_t j = from; j < to; ++j) {
+            norms[j] = arnoldiStep<M, DS, BK>(M_, d_M, d_y, d_result, d_evecs, d_h, ROWS, N, N, num_iters, j, handle, orth, d_work, stats);
+            if (norms[j] < tol * matnorm) {return {j + 1, true};}
+        }
+        return {to, false};
+    };
+
+    size_t j = first_ind;
+    if (s < 2 || j == 0) {
+        const auto [done, broke] = standard(j, s < 2 ? num_iters : std::min(s, num_iters));
+        if (broke || done == num_iters) {return static_cast<int>(done);}
+        j = done;
+    }
+
+    // Host copy of H_{j+1,j}: restarted columns carry their subdiagonal in d_h, columns built in this call in norms
+    OM H = OM::Zero(ld, num_iters);
+    BK::memcpy(H.data(), d_h, ld * num_iters * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+    for (size_t c = first_ind; c < j; ++c) {H(c + 1, c) = norms[c];}
+
+    const ComplexVector ritz = Eigen::ComplexEigenSolver<ComplexMatrix>(H.topLeftCorner(j, j).template cast<ComplexType>(), false).eigenvalues();
+    const ComplexVector leja = lejaOrder(ritz, s);
+    Eigen::Matrix<S, Eigen::Dynamic, 1> theta(s);
+    for (size_t i = 0; i < s; ++i) {
+        if constexpr (is_complex_v<S>) {theta[i] = leja[i];}
+        else {theta[i] = leja[i].real();}
+    }
+    // Ritz radius as the per-step scaling keeps the powers O(1) without a norm, and hence a reduction, per vector
+    const HostPrecision ritz_radius = ritz.cwiseAbs().maxCoeff();
+    const HostPrecision sigma = ritz_radius > 0 ? ritz_radius : matnorm;
+    const DevicePrecision inv_sigma = 1.0 / sigma;
+    const HostPrecision drop_tol = 1e-12 * matnorm;
+
+    OM C(ld, s), coeffs(ld, s);
+    while (j < num_iters) {
+        const size_t sb = std::min(s, num_iters - j);
+        const size_t cols = j + 1;
+        if (sb < 2) {return static_cast<int>(standard(j, num_iters).first);}
+
+        // Matrix powers: columns j + 1 .. j + sb of the basis, no reduction in between
+        for (size_t i = 0; i < sb; ++i) {
+            DS* v = d_evecs + (j + i) * N;
+            applyOperator<M, DS, BK>(M_, d_M, v, v + N, ROWS, N, N, handle);
+            const S neg_theta = -theta[i];
+            BK::template axpy<DS>(handle, N, reinterpret_cast<const DS*>(&neg_theta), v, 1, v + N, 1);
+            BK::template scale<DS>(handle, N, &inv_sigma, v + N, 1);
+        }
+
+        // BCGS2 against q_0 .. q_j, then the panel QR
+        DS* d_P = d_evecs + cols * N;
+        C.topRows(cols).setZero();
+        for (int pass = 0; pass < 2; ++pass) {
+            BK::template gemm<DS>(handle, ADJ, BlasOp::N, cols, sb, N, &ONE, d_evecs, N, d_P, N, &ZERO, d_coeffs, cols);
+            BK::template gemm<DS>(handle, BlasOp::N, BlasOp::N, N, sb, cols, &NEG_ONE, d_evecs, N, d_coeffs, cols, &ONE, d_P, N);
+            BK::memcpy(coeffs.data(), d_coeffs, cols * sb * ALLOC_SIZE, MemcpyKind::DeviceToHost);
+            C.block(0, 0, cols, sb) += Eigen::Map<const OM>(coeffs.data(), cols, sb);
+        }
+        const OM R = blockQR<OM, DS, BK>(d_P, d_evecs, N, sb, cols, drop_tol, d_coeffs, handle, true);
+        if (stats) {stats->reductions += 3;}
+
+        // [q_j, v_1 .. v_sb] = W Rhat
+        OM Rhat = OM::Zero(cols + sb, sb + 1);
+        Rhat(j, 0) = S(1);
+        Rhat.block(0, 1, cols, sb) = C.block(0, 0, cols, sb);
+        Rhat.block(cols, 1, sb, sb) = R;
+        OM scaled = Rhat;
+        for (Eigen::Index c = 0; c < scaled.cols(); ++c) {scaled.col(c) /= scaled.col(c).norm();}
+        const Vector sv = Eigen::JacobiSVD<OM>(scaled).singularValues();
+        const HostPrecision condition = sv[0] / sv[sv.size() - 1];
+        if (!(condition <= SSTEP_MAX_CONDITION)) {
+            // The block is discarded: its matvecs are spent, standard steps overwrite the columns
+            if (stats) {
+                stats->s_step_fallbacks++;
+                stats->matvecs += sb;
+                stats->matrix_passes += sb;
+            }
+            return static_cast<int>(standard(j, num_iters).first);
+        }
+
+        // H_new = (Rhat B - H_old X) U^{-1}
+        OM B = OM::Zero(sb + 1, sb);
+        for (size_t i = 0; i < sb; ++i) {
+            B(i, i) = theta[i];
+            B(i + 1, i) = S(sigma);
+        }
+        OM Y = Rhat * B;
+        if (j > 0) {Y.topRows(cols) -= H.topLeftCorner(cols, j) * Rhat.topLeftCorner(j, sb);}
+        Rhat.block(j, 0, sb, sb).template triangularView<Eigen::Upper>().template solveInPlace<Eigen::OnTheRight>(Y);
+
+        // Store upper Hessenberg columns, the theoretically zero entries below the subdiagonal are rounding
+        for (size_t i = 0; i < sb; ++i) {
+            H.col(j + i).setZero();
+            H.block(0, j + i, j + i + 1, 1) = Y.block(0, i, j + i + 1, 1);
+            norms[j + i] = std::real(Y(j + i + 1, i));
+            H(j + i + 1, j + i) = norms[j + i];
+        }
+        BK::memcpy(d_h + j * ld, H.col(j).data(), sb * ld * ALLOC_SIZE, MemcpyKind::HostToDevice);
+        for (size_t i = 0; i < sb; ++i) {
+            if (norms[j + i] < tol * matnorm) {return static_cast<int>(j + i + 1);}
+        }
+        j += sb;
+    }
+    return static_cast<int>(num_iters);
+}
+
+#endif // SSTEP_HPP
@@ -0,0 +1,271 @@
+// Out-of-core dense operator. MappedMatrix memory-maps a row-major matrix file and streams it through the matvec in row
+// tiles: a reader thread faults tile k+1 in (madvise + page touch) while tile k is multiplied, and consumed tiles are
+// released again, so resident memory stays at about two tiles. Satisfies LinearOperator, apply() runs on host memory.
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vector.hpp"
+#include "backend.hpp"
+
+class MappedFileError : public std::runtime_error {
+public:
+    // err defaults to errno at the throw site, pass it explicitly when cleanup runs between the failure and the throw
+    explicit MappedFileError(const std::string& message, int err = errno) : std::runtime_error(message + ": " + std::strerror(err)) {}
+};
+
+// 64 byte header keeps the payload cache-line aligned inside the mapping
+struct MatrixFileHeader {
+    char magic[8] = {'A', 'R', 'N', 'M', 'A', 'T', '0', '1'};
+    uint64_t rows = 0;
+    uint64_t cols = 0;
+    uint32_t scalar_size = 0;
+    uint32_t is_complex = 0;
+    char reserved[32] = {};
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "Matrix file header must stay 64 bytes.");
+
+// Writes M row-major behind a MatrixFileHeader, the layout MappedMatrix streams from
+template <typename MatrixType>
+void writeMatrixFile(const std::string& path, const MatrixType& M) {
+    using S = typename MatrixType::Scalar;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {throw MappedFileError("Cannot open " + path + " for writing");}
+    MatrixFileHeader header;
+    header.rows = M.rows();
+    header.cols = M.cols();
+    header.scalar_size = sizeof(S);
+    header.is_complex = is_complex_v<S>;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<S> row(M.cols());
+    for (Eigen::Index i = 0; i < M.rows(); ++i) {
+        for (Eigen::Index j = 0; j < M.cols(); ++j) {row[j] = M(i, j);}
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(S));
+    }
+    if (!out) {throw MappedFileError("Short write to " + path);}
+}
+
+// Sequential read() throughput of a file with its page cache dropped first, the ceiling a streamed matvec can reach
+inline HostPrecision measureReadBandwidth(const std::string& path, size_t max_bytes = size_t(1) << 30) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {throw MappedFileError("Cannot open " + path);}
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<char> buffer(size_t(8) << 20);
+    size_t total = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    while (total < max_bytes) {
+        const ssize_t got = ::read(fd, buffer.data(), buffer.size());
+        if (got <= 0) {break;}
+        total += got;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    ::close(fd);
+    const HostPrecision seconds = std::chrono::duration<HostPrecision>(end - start).count();
+    return seconds > 0 ? total / seconds : 0;
+}
+
+struct StreamStats {
+    size_t passes = 0;
+    size_t bytes = 0;
+    HostPrecision seconds = 0;
+    HostPrecision stall_seconds = 0; // Consumer time spent waiting on the reader, > 0 means the pass is disk bound
+
+    inline HostPrecision throughput() const { return seconds > 0 ? bytes / seconds : 0; }
+};
+
+template <typename S>
+class MappedMatrix {
+public:
+    using Scalar = S;
+    static constexpr size_t DEFAULT_TILE_BYTES = size_t(64) << 20;
+
+    explicit MappedMatrix(const std::string& path, size_t tile_bytes = DEFAULT_TILE_BYTES, bool release_tiles = true)
+        : path_(path), release_tiles_(release_tiles) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {throw MappedFileError("Cannot open " + path);}
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            const int err = errno;
+            ::close(fd_);
+            throw MappedFileError("Cannot stat " + path, err);
+        }
+        file_bytes_ = st.st_size;
+
+        MatrixFileHeader header;
+        if (file_bytes_ < sizeof(header) || ::pread(fd_, &header, sizeof(header), 0) != sizeof(header)
+            || std::memcmp(header.magic, MatrixFileHeader{}.magic, sizeof(header.magic)) != 0) {
+            ::close(fd_);
+            throw std::invalid_argument(path + " is not a matrix file written by writeMatrixFile");
+        }
+        if (header.scalar_size != sizeof(S) || header.is_complex != is_complex_v<S>) {
+            ::close(fd_);
+            throw std::invalid_argument(path + " holds " + std::to_string(header.scalar_size) + " byte scalars, expected "
+                                        + std::to_string(sizeof(S)));
+        }
+        rows_ = header.rows;
+        cols_ = header.cols;
+        if (file_bytes_ < sizeof(header) + rows_ * cols_ * sizeof(S)) {::close(fd_); throw std::invalid_argument(path + " is truncated");}
+
+        base_ = ::mmap(nullptr, file_bytes_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (base_ == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd_);
+            throw MappedFileError("mmap failed for " + path, err);
+        }
+        ::madvise(base_, file_bytes_, MADV_SEQUENTIAL);
+        data_ = reinterpret_cast<const S*>(static_cast<const char*>(base_) + sizeof(header));
+
+        tile_rows_ = std::clamp<size_t>(tile_bytes / std::max<size_t>(1, cols_ * sizeof(S)), 1, std::max<size_t>(rows_, 1));
+        num_tiles_ = (rows_ + tile_rows_ - 1) / tile_rows_;
+        reader_ = std::thread(&MappedMatrix::readerLoop, this);
+    }
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    ~MappedMatrix() {
+        stop_.store(true);
+        pass_.fetch_add(1);
+        pass_.notify_one();
+        reader_.join();
+        ::munmap(base_, file_bytes_);
+        ::close(fd_);
+    }
+
+    inline size_t rows() const { return rows_; }
+    inline size_t cols() const { return cols_; }
+    inline size_t tileRows() const { return tile_rows_; }
+    inline size_t numTiles() const { return num_tiles_; }
+    inline const std::string& path() const { return path_; }
+    inline const StreamStats& stats() const { return stats_; }
+    inline void resetStats() { stats_ = StreamStats{}; }
+    inline void setNumThreads(int num_threads) const { handle_.num_threads = num_threads; }
+    inline int numThreads() const { return handle_.num_threads; }
+
+    // Frobenius norm, one streamed pass, computed on first use for the breakdown tolerance
+    HostPrecision norm() const {
+        if (norm_ < 0) {
+            HostPrecision acc = 0;
+            for (size_t i = 0; i < rows_ * cols_; ++i) {acc += std::norm(data_[i]);}
+            norm_ = std::sqrt(acc);
+        }
+        return norm_;
+    }
+
+    // y = A x. Tile k is a row-major block, i.e. a column-major cols x tile_rows matrix, so each is one transposed gemv
+    void apply(const S* x, S* y) const {
+        auto start = std::chrono::high_resolution_clock::now();
+        ready_.store(0);
+        consumed_.store(0);
+        pass_.fetch_add(1);
+        pass_.notify_one();
+
+        const S one(1), zero(0);
+        for (size_t k = 0; k < num_tiles_; ++k) {
+            if (ready_.load() <= k) {
+                auto wait_start = std::chrono::high_resolution_clock::now();
+                for (size_t r; (r = ready_.load()) <= k;) {ready_.wait(r);}
+                stats_.stall_seconds += std::chrono::duration<HostPrecision>(std::chrono::high_resolution_clock::now() - wait_start).count();
+            }
+            const size_t r0 = k * tile_rows_;
+            const size_t nr = std::min(tile_rows_, rows_ - r0);
+            cpublas::gemv<S>(handle_, cpublas::OP_T, cols_, nr, &one, data_ + r0 * cols_, cols_, x, 1, &zero, y + r0, 1);
+            if (release_tiles_) {advise(k, MADV_DONTNEED);}
+            consumed_.store(k + 1);
+            consumed_.notify_one();
+        }
+
+        stats_.passes++;
+        stats_.bytes += rows_ * cols_ * sizeof(S);
+        stats_.seconds += std::chrono::duration<HostPrecision>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Streamed matvec throughput next to raw sequential read bandwidth of the same file
+    void report(std::ostream& os = std::cout) const {
+        const HostPrecision disk = measureReadBandwidth(path_);
+        os << "Streamed " << stats_.passes << " passes of " << (rows_ * cols_ * sizeof(S)) / 1e6 << " MB in " << num_tiles_
+           << " tiles: " << stats_.throughput() / 1e9 << " GB/s (disk " << disk / 1e9 << " GB/s, "
+           << (disk > 0 ? 100 * stats_.throughput() / disk : 0) << "%), reader stalls " << stats_.stall_seconds * 1e3 << " ms" << std::endl;
+    }
+
+private:
+    static constexpr size_t PAGE_BYTES = 4096;
+
+    // madvise on the page-aligned span covering tile k. A release stops at the last page boundary inside the tile: the
+    // page it shares with tile k + 1 may already hold that tile's prefetched head
+    void advise(size_t k, int advice) const {
+        constexpr uintptr_t PAGE_MASK = ~(uintptr_t(PAGE_BYTES) - 1);
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(data_ + k * tile_rows_ * cols_);
+        uintptr_t end = reinterpret_cast<uintptr_t>(data_ + std::min(rows_, (k + 1) * tile_rows_) * cols_);
+        if (advice == MADV_DONTNEED && k + 1 < num_tiles_) {end &= PAGE_MASK;}
+        const uintptr_t aligned = begin & PAGE_MASK;
+        if (end > aligned) {::madvise(reinterpret_cast<void*>(aligned), end - aligned, advice);}
+    }
+
+    // Faults tile k in, one read per page, so the multiply never waits on I/O for a tile the reader has handed over
+    void prefetch(size_t k) const {
+        advise(k, MADV_WILLNEED);
+        const volatile char* begin = reinterpret_cast<const volatile char*>(data_ + k * tile_rows_ * cols_);
+        const volatile char* end = reinterpret_cast<const volatile char*>(data_ + std::min(rows_, (k + 1) * tile_rows_) * cols_);
+        char sink = 0;
+        for (const volatile char* p = begin; p < end; p += PAGE_BYTES) {sink ^= *p;}
+        if (end > begin) {sink ^= *(end - 1);}
+        (void)sink;
+    }
+
+    // Producer: stays exactly one tile ahead of the consumer. apply() only returns once every tile was handed over,
+    // so a pass never starts while the reader is still inside the previous one
+    void readerLoop() {
+        size_t seen_pass = 0;
+        while (true) {
+            for (size_t p; (p = pass_.load()) == seen_pass;) {pass_.wait(p);}
+            seen_pass = pass_.load();
+            if (stop_.load()) {return;}
+            for (size_t k = 0; k < num_tiles_; ++k) {
+                for (size_t c; (c = consumed_.load()) + 1 < k;) {consumed_.wait(c);}
+                prefetch(k);
+                ready_.store(k + 1);
+                ready_.notify_one();
+            }
+        }
+    }
+
+    std::string path_;
+    bool release_tiles_;
+    int fd_ = -1;
+    size_t file_bytes_ = 0;
+    void* base_ = nullptr;
+    const S* data_ = nullptr;
+    size_t rows_ = 0, cols_ = 0, tile_rows_ = 0, num_tiles_ = 0;
+
+    mutable cpublas::Handle handle_;
+    mutable HostPrecision norm_ = -1;
+    mutable StreamStats stats_;
+
+    // Single producer/consumer handshake, tiles handed over [0, ready_) and released [0, consumed_)
+    mutable std::atomic<size_t> pass_{0};
+    mutable std::atomic<size_t> ready_{0};
+    mutable std::atomic<size_t> consumed_{0};
+    std::atomic<bool> stop_{false};
+    std::thread reader_;
+};
+
+#endif // STREAM_HPP
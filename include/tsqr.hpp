@@ -0,0 +1,114 @@
+// Tall-skinny QR of N x p panels. Each thread takes a Householder QR of its row block. The p x p R factors are then
+// merged pairwise up a binary tree, one QR of a stacked 2p x p pair per node, and Q is rebuilt top-down: the root's
+// coefficients go down through each node's 2p x p Q factor, and every leaf applies its own reflectors to its block.
+// Each thread touches only its own rows, factored in place, and the only data crossing threads are p x p triangles. The
+// result is as stable as Householder QR, and block orthogonalization scales with the cores.
+#ifndef TSQR_HPP
+#define TSQR_HPP
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "backend.hpp"
+#include "vector.hpp"
+
+// Rows per TSQR leaf at least, below this a leaf's QR is too small to pay for a tree level
+constexpr size_t TSQR_MIN_LEAF_ROWS = 256;
+
+// In-place TSQR of the N x p column-major panel A (leading dimension lda): Q overwrites A and R (p x p, upper
+// triangular) is returned. positive_diagonal rotates column phases so R has a real nonnegative diagonal
+template <typename S>
+Eigen::Matrix<S, Eigen::Dynamic, Eigen::Dynamic> tsqrHost(const cpublas::Handle& handle, S* A, size_t N, size_t p, size_t lda,
+                                                         bool positive_diagonal = false) {
+    using Mat = Eigen::Matrix<S, Eigen::Dynamic, Eigen::Dynamic>;
+    using PanelMap = Eigen::Map<Mat, 0, Eigen::OuterStride<>>;
+    const size_t by_rows = N / std::max(p, TSQR_MIN_LEAF_ROWS);
+    const size_t leaves = std::max<size_t>(1, N * p < cpublas::PARALLEL_GRAIN ? 1 : std::min<size_t>(cpublas::threadCount(handle), by_rows));
+
+    // Leaves: local QR of each row block, factored in place so the block holds its own reflectors
+    using LeafQR = Eigen::HouseholderQR<Eigen::Ref<Mat, 0, Eigen::OuterStride<>>>;
+    std::vector<std::unique_ptr<LeafQR>> local(leaves);
+    std::vector<Mat> R(leaves);
+    cpublas::parallelRegion(static_cast<int>(leaves), [&](int tid, int nthreads) {
+        for (size_t leaf = tid; leaf < leaves; leaf += nthreads) {
+            const auto [r0, r1] = cpublas::chunkRange(N, static_cast<int>(leaf), static_cast<int>(leaves));
+            PanelMap block(A + r0, r1 - r0, p, Eigen::OuterStride<>(lda));
+            local[leaf] = std::make_unique<LeafQR>(block);
+            R[leaf] = local[leaf]->matrixQR().topRows(p).template triangularView<Eigen::Upper>();
+        }
+    });
+
+    // Reduction tree: node i of a level merges nodes 2i and 2i + 1 of the level below, an odd one out passes through
+    std::vector<std::vector<Mat>> merges; // Per level, the 2p x p Q factor of each merged node (empty when passed through)
+    std::vector<Mat> level = std::move(R);
+    while (level.size() > 1) {
+        std::vector<Mat> next((level.size() + 1) / 2);
+        std::vector<Mat> factors(next.size());
+        for (size_t i = 0; i < next.size(); ++i) {
+            if (2 * i + 1 == level.size()) {next[i] = std::move(level[2 * i]); continue;}
+            Mat stacked(2 * p, p);
+            stacked << level[2 * i], level[2 * i + 1];
+            const Eigen::HouseholderQR<Mat> qr(stacked);
+            next[i] = qr.matrixQR().topRows(p).template triangularView<Eigen::Upper>();
+            factors[i] = qr.householderQ() * Mat::Identity(2 * p, p);
+        }
+        merges.push_back(std::move(factors));
+        level = std::move(next);
+    }
+    Mat R_final = std::move(level[0]);
+
+    // Root coefficients: identity, or the phases that make R's diagonal real nonnegative
+    Mat root = Mat::Identity(p, p);
+    if (positive_diagonal) {
+        for (size_t i = 0; i < p; ++i) {
+            const auto mag = std::abs(R_final(i, i));
+            if (mag == 0) {continue;}
+            const S phase = R_final(i, i) / mag;
+            root(i, i) = phase;
+            R_final.row(i) *= cpublas::conjugate(phase);
+        }
+    }
+    std::vector<Mat> coeffs{std::move(root)};
+    for (size_t l = merges.size(); l-- > 0;) {
+        const std::vector<Mat>& factors = merges[l];
+        const size_t below = l == 0 ? leaves : merges[l - 1].size();
+        std::vector<Mat> down(below);
+        for (size_t i = 0; i < factors.size(); ++i) {
+            if (factors[i].size() == 0) {down[2 * i] = std::move(coeffs[i]); continue;}
+            down[2 * i] = factors[i].topRows(p) * coeffs[i];
+            down[2 * i + 1] = factors[i].bottomRows(p) * coeffs[i];
+        }
+        coeffs = std::move(down);
+    }
+
+    // Leaves: Q_leaf = H_leaf [C_leaf; 0], written over the panel
+    cpublas::parallelRegion(static_cast<int>(leaves), [&](int tid, int nthreads) {
+        for (size_t leaf = tid; leaf < leaves; leaf += nthreads) {
+            const auto [r0, r1] = cpublas::chunkRange(N, static_cast<int>(leaf), static_cast<int>(leaves));
+            Mat Y = Mat::Zero(r1 - r0, p);
+            Y.topRows(p) = coeffs[leaf];
+            Y.applyOnTheLeft(local[leaf]->householderQ());
+            PanelMap(A + r0, r1 - r0, p, Eigen::OuterStride<>(lda)) = Y;
+        }
+    });
+    return R_final;
+}
+
+// Backend-facing TSQR of the N x p panel d_A (leading dimension N): Q overwrites d_A, R is returned on the host. Host
+// resident backends factor in place, device backends stage the panel through host memory
+template <typename OM, typename DS, typename BK = DefaultBackend>
+OM tsqr(DS* d_A, size_t N, size_t p, typename BK::BlasHandle& handle, bool positive_diagonal = false) {
+    using S = typename OM::Scalar;
+    static_assert(sizeof(S) == sizeof(DS), "Panel scalar must match the backend scalar layout.");
+    if constexpr (BK::HOST_RESIDENT) {
+        return tsqrHost<S>(handle, reinterpret_cast<S*>(d_A), N, p, N, positive_diagonal);
+    } else {
+        OM panel(N, p);
+        BK::memcpy(panel.data(), d_A, N * p * sizeof(DS), MemcpyKind::DeviceToHost);
+        OM R = tsqrHost<S>(cpublas::Handle{}, panel.data(), N, p, N, positive_diagonal);
+        BK::memcpy(d_A, panel.data(), N * p * sizeof(DS), MemcpyKind::HostToDevice);
+        return R;
+    }
+}
+
+#endif // TSQR_HPP
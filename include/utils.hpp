@@ -36,7 +36,7 @@
 
 
     template <typename MatrixType>
-    inline bool isHessenberg(const MatrixType& mat, double tol = 1e-10) {
+    inline bool isHessenberg(const MatrixType& mat, HostPrecision tol = default_tol) {
         using Scalar = typename MatrixType::Scalar;
         constexpr bool isComplex = std::is_same_v<Scalar, std::complex<double>> || std::is_same_v<Scalar, std::complex<float>>;
 
@@ -55,12 +55,12 @@
     }
 
     template <typename MatrixType>
-    bool isOrthonormal(const MatrixType& Q, double tol = 1e-10) {
+    bool isOrthonormal(const MatrixType& Q, HostPrecision tol = default_tol) {
         using Scalar = typename MatrixType::Scalar;
         const size_t N = Q.cols();
         MatrixType product(N, N);
 
-        if constexpr (std::is_same_v<Scalar, std::complex<double>>) {
+        if constexpr (is_complex_v<Scalar>) {
             product = Q.adjoint() * Q;
         } else {
             product = Q.transpose() * Q;
@@ -109,7 +109,7 @@
 
     template <typename MatType>
     MatType generateRandomSymmetricMatrix(size_t N) {
-        static_assert(!std::is_same<typename MatType::Scalar, std::complex<double>>::value,
+        static_assert(!is_complex_v<typename MatType::Scalar>,
                         "generateRandomSymmetricMatrix only supports real-valued matrices.");
         MatType A = MatType::Random(N, N);       
         return A.template selfadjointView<Eigen::Upper>();
@@ -135,12 +135,12 @@
 
     
     // Helper function to check if a vector is zero
-    bool isZeroVector(const Vector& vec, const double tol = 1e-10) {
+    bool isZeroVector(const Vector& vec, const HostPrecision tol = default_tol) {
         return vec.norm() < tol;
     }
 
     // Helper function to check if two vectors are parallel
-    bool areVectorsParallel(const Vector& v1, const Vector& v2, const double tol = 1e-10) {
+    bool areVectorsParallel(const Vector& v1, const Vector& v2, const HostPrecision tol = default_tol) {
         if (isZeroVector(v1) || isZeroVector(v2)) return false;
         Vector normalized1 = v1.normalized();
         Vector normalized2 = v2.normalized();
@@ -9,29 +9,32 @@
 #include <vector> // No matter what, necessary
 
 #include <type_traits>
-#include <complex.h>
+#include <complex>
 #include <limits>
 
 
 
+// default_tol := relative residual the solvers converge to, a few thousand rounding units of the working precision
 #if defined(PRECISION_FLOAT)
     using HostPrecision = float;
     using DevicePrecision = float;
+    constexpr HostPrecision default_tol = 1e-4;
 #elif defined(PRECISION_DOUBLE)
     using HostPrecision = double;
     using DevicePrecision = double;
+    constexpr HostPrecision default_tol = 1e-10;
 #elif defined(PRECISION_FLOAT16)
     #include <cuda_fp16.h>
     #include <stdfloat>
     using HostPrecision = std::float16_t; // or use float16_t if defined
     using DevicePrecision = __half;
+    constexpr HostPrecision default_tol = 1e-2;
 #else
     #error "No precision defined! Please define PRECISION_FLOAT, PRECISION_DOUBLE, or PRECISION_FLOAT16."
 #endif
 
 using ComplexType = std::complex<HostPrecision>;
 constexpr size_t PRECISION_SIZE = sizeof(HostPrecision);
-constexpr HostPrecision default_tol = 1e-10;
 
 template <typename T>
 struct is_complex : std::false_type {};
@@ -56,7 +59,7 @@ constexpr bool is_complex_v = is_complex<T>::value;
     using ComplexMatrix = Eigen::Matrix<ComplexType, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>; // Complex matrix
     using MatrixRowMajor = Eigen::Matrix<HostPrecision, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>; // Row-major matrix
     using MatrixColMajor = Eigen::Matrix<HostPrecision, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>; // Column-major matrix
-    using ComplexRowMajorMatrix = Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using ComplexRowMajorMatrix = Eigen::Matrix<ComplexType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
     using ComplexColMajorMatrix = ComplexMatrix;
     // Mapped types (Eigen::Map)
     using VectorMap = Eigen::Map<Vector>;
@@ -93,7 +96,7 @@ constexpr bool is_complex_v = is_complex<T>::value;
 
 template <typename Scalar>
 void printScalar(const Scalar& value) {
-    if constexpr (std::is_same_v<Scalar, ComplexType> || std::is_same_v<Scalar, std::complex<double>>) {
+    if constexpr (is_complex_v<Scalar>) {
         std::cout << "(" << value.real() << ", " << value.imag() << ") ";
     } else {
         std::cout << value << " ";
@@ -175,10 +178,10 @@ void print(const MatrixType& mat, size_t n = std::numeric_limits<size_t>::max())
 
 #endif
 
-inline void mollify(Eigen::MatrixXcd& matrix, double tol=default_tol) noexcept {
+inline void mollify(Eigen::Ref<ComplexMatrix> matrix, HostPrecision tol=default_tol) noexcept {
     for (int i = 0; i < matrix.rows(); ++i) {
         for (int j = 0; j < matrix.cols(); ++j) {
-            std::complex<double>& elem = matrix(i, j);
+            ComplexType& elem = matrix(i, j);
             if (std::abs(elem.real()) <= tol) {
                 elem.real(0.0);
             }
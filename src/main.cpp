@@ -1,8 +1,26 @@
 #include "arnoldi.hpp"
 #include "IRAM.hpp"
 #include <gtest/gtest.h>
-
+#include "../tests/cpublas_test.hpp"
+#include "../tests/operator_test.hpp"
+#include "../tests/sparse_test.hpp"
+#include "../tests/reorder_test.hpp"
+#include "../tests/stream_test.hpp"
+#include "../tests/block_arnoldi_test.hpp"
+#include "../tests/solver_test.hpp"
+#include "../tests/arena_test.hpp"
+#include "../tests/lanczos_test.hpp"
+#include "../tests/restart_test.hpp"
+#include "../tests/sstep_test.hpp"
+#include "../tests/tsqr_test.hpp"
+#include "../tests/pipeline_test.hpp"
+#include "../tests/precision_test.hpp"
+
+#ifdef USE_CUDA
 constexpr size_t N = 10000; // Test Matrix Size
+#else
+constexpr size_t N = 1000; // Same test sized for host-thread turnaround on the CPU backend
+#endif
 constexpr size_t total_iters = 1000;
 constexpr size_t max_iters = 50;
 constexpr size_t basis_size = 10;
@@ -71,17 +89,17 @@ void checkRitzPairs(const MatrixType& M, const PT& ritzPairs, const double tol =
 // }
 
 TEST(ArnoldiTests, IRAMTest) {
-    cublasHandle_t handle;
-    cusolverDnHandle_t solver_handle;
-    cublasCreate(&handle);
-    cusolverDnCreate(&solver_handle);
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
     ArnoldiTestType M = ArnoldiTestType::Random(N, N);
     HostPrecision matnorm = M.norm();
     for (auto& x : M.reshaped()) {x /= matnorm;}
     ComplexEigenPairs ritzPairs = IRAM<ArnoldiTestType, N, total_iters, max_iters, basis_size>(M, handle, solver_handle);
     checkRitzPairs<ArnoldiTestType, ComplexEigenPairs, true>(M, ritzPairs);
-    cublasDestroy(handle);
-    cusolverDnDestroy(solver_handle);
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
 }
 
 
@@ -0,0 +1,45 @@
+// Heap allocation counter for the test binary. Replaces the C allocation entry points (operator new, Eigen and the
+// STL all end up here) with forwarders to glibc's internal allocator that bump a counter while counting is switched on.
+// Defines malloc & co, so include it from exactly one translation unit: the gtest runner.
+#ifndef ALLOC_HOOK_HPP
+#define ALLOC_HOOK_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace alloc_hook {
+    inline std::atomic<bool> counting{false};
+    inline std::atomic<size_t> allocations{0};
+
+    inline void record() {
+        if (counting.load(std::memory_order_relaxed)) {allocations.fetch_add(1, std::memory_order_relaxed);}
+    }
+
+    // Allocations on any thread between start() and the returned count
+    inline void start() { allocations.store(0); counting.store(true); }
+    inline size_t stop() { counting.store(false); return allocations.load(); }
+} // namespace alloc_hook
+
+extern "C" {
+    void* malloc(size_t size) { alloc_hook::record(); return __libc_malloc(size); }
+    void* calloc(size_t count, size_t size) { alloc_hook::record(); return __libc_calloc(count, size); }
+    void* realloc(void* ptr, size_t size) { alloc_hook::record(); return __libc_realloc(ptr, size); }
+    void* aligned_alloc(size_t alignment, size_t size) { alloc_hook::record(); return __libc_memalign(alignment, size); }
+    int posix_memalign(void** ptr, size_t alignment, size_t size) {
+        alloc_hook::record();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+    void free(void* ptr) { __libc_free(ptr); }
+}
+
+#endif // ALLOC_HOOK_HPP
@@ -0,0 +1,92 @@
+#ifndef ARENA_TEST_HPP
+#define ARENA_TEST_HPP
+
+#include <gtest/gtest.h>
+#include "IRAM.hpp"
+#include "alloc_hook.hpp"
+#include "solver_test.hpp"
+
+TEST(ArenaTests, SpillsFoldIntoOneBlock) {
+    WorkspaceArena arena(1024);
+    double* a = arena.allocate<double>(100);
+    ComplexType* b = arena.allocate<ComplexType>(100); // Past the first block, spills
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % WorkspaceArena::ALIGNMENT, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % WorkspaceArena::ALIGNMENT, 0u);
+    EXPECT_EQ(arena.blockAllocations(), 2u);
+
+    arena.reset();
+    EXPECT_GE(arena.capacity(), WorkspaceArena::footprint<double>(100) + WorkspaceArena::footprint<ComplexType>(100));
+    const size_t blocks = arena.blockAllocations();
+    alloc_hook::start();
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        arena.allocate<double>(100);
+        arena.allocate<ComplexType>(100);
+        arena.reset();
+    }
+    EXPECT_EQ(alloc_hook::stop(), 0u);
+    EXPECT_EQ(arena.blockAllocations(), blocks);
+}
+
+TEST(ArenaTests, HugePageArena) {
+    WorkspaceArena arena(3 << 20, true);
+    char* p = arena.allocate<char>(3 << 20);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % WorkspaceArena::HUGE_PAGE_BYTES, 0u);
+    p[0] = p[(3 << 20) - 1] = 1;
+}
+
+// Counts heap allocations between consecutive cycle hooks: after the first cycle nothing may allocate
+TEST(ArenaTests, WarmRestartCyclesDoNotAllocate) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+
+    const ComplexMatrix M = normalizedRandom(400);
+    IRAMSolver<ComplexType> solver({.rows = 400, .max_iters = 300, .basis_size = 50, .restart_size = 10, .num_pairs = 4});
+    std::vector<size_t> per_cycle;
+    per_cycle.reserve(16);
+    solver.setCycleHook([&per_cycle](size_t cycle) {
+        if (cycle > 0) {per_cycle.push_back(alloc_hook::stop());}
+        alloc_hook::start();
+    });
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle);
+    alloc_hook::stop();
+
+    ASSERT_GE(per_cycle.size(), 3u);
+    // Cycle 0 warms the eigensolver, every later restart cycle must run purely on the arena
+    for (size_t i = 1; i < per_cycle.size(); ++i) {EXPECT_EQ(per_cycle[i], 0u) << "restart cycle " << i + 1;}
+    EXPECT_LT(worstResidual(M, pairs, 4), 0.1);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Same for a real basis, through both restarts: the real Schur forms and block swaps run on the arena as well
+TEST(ArenaTests, WarmRealRestartCyclesDoNotAllocate) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+
+    const Matrix M = normalizedRandom(400).real();
+    for (RestartMethod restart : {RestartMethod::SHIFTED_QR, RestartMethod::KRYLOV_SCHUR}) {
+        IRAMSolver<HostPrecision> solver({.rows = 400, .max_iters = 300, .basis_size = 50, .restart_size = 10, .num_pairs = 4,
+                                          .restart = restart});
+        std::vector<size_t> per_cycle;
+        per_cycle.reserve(16);
+        solver.setCycleHook([&per_cycle](size_t cycle) {
+            if (cycle > 0) {per_cycle.push_back(alloc_hook::stop());}
+            alloc_hook::start();
+        });
+        solver.solve(M, handle, solver_handle);
+        alloc_hook::stop();
+
+        ASSERT_GE(per_cycle.size(), 3u);
+        for (size_t i = 1; i < per_cycle.size(); ++i) {EXPECT_EQ(per_cycle[i], 0u) << "restart cycle " << i + 1;}
+    }
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // ARENA_TEST_HPP
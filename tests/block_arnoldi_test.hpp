@@ -0,0 +1,59 @@
+#ifndef BLOCK_ARNOLDI_TEST_HPP
+#define BLOCK_ARNOLDI_TEST_HPP
+
+#include <gtest/gtest.h>
+#include "blockArnoldi.hpp"
+#include "sparse.hpp"
+
+constexpr size_t block_dims = 400;
+
+// Q diag(d) Q^T with a triple eigenvalue at the top and a double one right below it
+inline Matrix clusteredSpectrum() {
+    Vector d = Vector::LinSpaced(block_dims, 0.0, 5.0);
+    d.head(5) << 10.0, 10.0, 10.0, 9.5, 9.5;
+    const Matrix Q = Eigen::HouseholderQR<Matrix>(Matrix::Random(block_dims, block_dims)).householderQ();
+    return Q * d.asDiagonal() * Q.transpose();
+}
+
+TEST(BlockArnoldiTests, RepeatedEigenvalues) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const Matrix A = clusteredSpectrum();
+
+    KrylovStats stats;
+    BlockArnoldiParams params{.block_size = 4, .num_blocks = 10, .num_pairs = 5, .max_restarts = 50, .tol = 1e-8};
+    ComplexEigenPairs pairs = BlockArnoldi<Matrix>(A, handle, params, &stats);
+
+    // All three copies of 10 and both of 9.5: a single start vector only ever sees one direction per eigenvalue
+    const HostPrecision expected[] = {10.0, 10.0, 10.0, 9.5, 9.5};
+    ASSERT_EQ(pairs.num_pairs, 5u);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(pairs.values[i].real(), expected[i], 1e-6) << "Ritz value " << i;
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((A.cast<ComplexType>() * v - pairs.values[i] * v).norm(), 1e-6) << "Ritz pair " << i;
+    }
+    // The copies of 10 must be independent eigenvectors
+    const ComplexMatrix X = pairs.vectors.leftCols(3);
+    EXPECT_GT(Eigen::JacobiSVD<ComplexMatrix>(X).singularValues().minCoeff(), 0.5);
+    std::cout << "Block Arnoldi p = 4: " << stats << std::endl;
+    DefaultBackend::destroyHandle(handle);
+}
+
+// Matrix passes per converged pair for single-vector vs block expansion at equal basis size, on a sparse operator
+TEST(BlockArnoldiTests, PassesPerConvergedPair) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const Matrix A = clusteredSpectrum();
+    const SparseMatrix S = SparseMatrix::fromDense(A);
+
+    for (size_t p : {1, 2, 4, 8}) {
+        KrylovStats stats;
+        BlockArnoldiParams params{.block_size = p, .num_blocks = 40 / p, .num_pairs = 8, .max_restarts = 60, .tol = 1e-8};
+        BlockArnoldi<SparseMatrix>(S, handle, params, &stats);
+        std::cout << "Block size " << p << ": " << stats << std::endl;
+        if (p == 4) {EXPECT_EQ(stats.converged, 8u);}
+    }
+    DefaultBackend::destroyHandle(handle);
+}
+
+#endif // BLOCK_ARNOLDI_TEST_HPP
@@ -0,0 +1,134 @@
+#ifndef CPUBLAS_TEST_HPP
+#define CPUBLAS_TEST_HPP
+
+#include <random>
+#include <gtest/gtest.h>
+#include "backend.hpp"
+#include "utils.hpp"
+
+constexpr size_t cpu_test_m = 300;
+constexpr size_t cpu_test_n = 200;
+
+class CpublasTest : public ::testing::Test {
+protected:
+    CpuBackend::BlasHandle handle;
+
+    void SetUp() override {
+        CpuBackend::createHandle(handle);
+    }
+
+    void TearDown() override {
+        CpuBackend::destroyHandle(handle);
+    }
+};
+
+TEST_F(CpublasTest, GemvTest) {
+    ComplexMatrix A = ComplexMatrix::Random(cpu_test_m, cpu_test_n);
+    ComplexVector x = ComplexVector::Random(cpu_test_n);
+    ComplexVector xt = ComplexVector::Random(cpu_test_m);
+    ComplexVector y = ComplexVector::Zero(cpu_test_m);
+    ComplexVector yt = ComplexVector::Zero(cpu_test_n);
+
+    const DeviceComplexType alpha = getOne<DeviceComplexType>();
+    const DeviceComplexType beta = getZero<DeviceComplexType>();
+    CpuBackend::gemv<DeviceComplexType>(handle, BlasOp::N, cpu_test_m, cpu_test_n, &alpha, A.data(), cpu_test_m, x.data(), 1, &beta, y.data(), 1);
+    CpuBackend::gemv<DeviceComplexType>(handle, BlasOp::C, cpu_test_m, cpu_test_n, &alpha, A.data(), cpu_test_m, xt.data(), 1, &beta, yt.data(), 1);
+
+    ASSERT_LE((y - A * x).norm(), 1e-10);
+    ASSERT_LE((yt - A.adjoint() * xt).norm(), 1e-10);
+}
+
+TEST_F(CpublasTest, GemvRealTest) {
+    // Real matrix, complex vectors: must agree with the promoted matrix for both operations
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<HostPrecision> dist(-1, 1);
+    Matrix A(cpu_test_m, cpu_test_n);
+    ComplexVector x(cpu_test_n), xt(cpu_test_m);
+    for (Eigen::Index i = 0; i < A.size(); ++i) {A.data()[i] = dist(gen);}
+    for (Eigen::Index i = 0; i < x.size(); ++i) {x[i] = {dist(gen), dist(gen)};}
+    for (Eigen::Index i = 0; i < xt.size(); ++i) {xt[i] = {dist(gen), dist(gen)};}
+    ComplexVector y = ComplexVector::Ones(cpu_test_m), yt(cpu_test_n);
+    const ComplexVector y0 = y;
+
+    const DeviceComplexType alpha = getOne<DeviceComplexType>();
+    const DeviceComplexType beta = getNegOne<DeviceComplexType>();
+    const DeviceComplexType zero = getZero<DeviceComplexType>();
+    CpuBackend::gemvReal<DeviceComplexType>(handle, BlasOp::N, cpu_test_m, cpu_test_n, &alpha, A.data(), cpu_test_m, x.data(), 1, &beta, y.data(), 1);
+    CpuBackend::gemvReal<DeviceComplexType>(handle, BlasOp::T, cpu_test_m, cpu_test_n, &alpha, A.data(), cpu_test_m, xt.data(), 1, &zero, yt.data(), 1);
+
+    const ComplexMatrix promoted = A.cast<ComplexType>();
+    ASSERT_LE((y - (promoted * x - y0)).norm(), 1e-10);
+    ASSERT_LE((yt - promoted.transpose() * xt).norm(), 1e-10);
+}
+
+TEST_F(CpublasTest, GemmTest) {
+    constexpr int p = 5;
+    ComplexMatrix A = ComplexMatrix::Random(cpu_test_m, cpu_test_n);
+    ComplexMatrix X = ComplexMatrix::Random(cpu_test_n, p);
+    ComplexMatrix W = ComplexMatrix::Random(cpu_test_m, p);
+    ComplexMatrix Y = ComplexMatrix::Random(cpu_test_m, p);
+    const ComplexMatrix Y0 = Y;
+    ComplexMatrix C(cpu_test_n, p);
+
+    const DeviceComplexType alpha = getOne<DeviceComplexType>();
+    const DeviceComplexType beta = getNegOne<DeviceComplexType>();
+    const DeviceComplexType zero = getZero<DeviceComplexType>();
+    CpuBackend::gemm<DeviceComplexType>(handle, BlasOp::N, BlasOp::N, cpu_test_m, p, cpu_test_n, &alpha, A.data(), cpu_test_m, X.data(), cpu_test_n, &beta, Y.data(), cpu_test_m);
+    CpuBackend::gemm<DeviceComplexType>(handle, BlasOp::C, BlasOp::N, cpu_test_n, p, cpu_test_m, &alpha, A.data(), cpu_test_m, W.data(), cpu_test_m, &zero, C.data(), cpu_test_n);
+
+    ASSERT_LE((Y - (A * X - Y0)).norm(), 1e-10);
+    ASSERT_LE((C - A.adjoint() * W).norm(), 1e-10);
+}
+
+TEST_F(CpublasTest, NormScaleTest) {
+    Vector v = Vector::Random(cpu_test_m);
+    HostPrecision result = 0.0;
+    CpuBackend::norm<DevicePrecision>(handle, cpu_test_m, v.data(), 1, &result);
+    EXPECT_NEAR(result, v.norm(), 1e-10);
+
+    const DevicePrecision inv = 1.0 / result;
+    CpuBackend::scale<DevicePrecision>(handle, cpu_test_m, &inv, v.data(), 1);
+    EXPECT_NEAR(v.norm(), 1.0, 1e-10);
+}
+
+TEST_F(CpublasTest, MGSTest) {
+    constexpr int num_iters = 8;
+    ComplexMatrix Q = gramSchmidtOrthonormal<ComplexMatrix>(cpu_test_m).leftCols(num_iters + 1);
+    ComplexMatrix H = ComplexMatrix::Zero(num_iters + 1, num_iters);
+    ComplexVector w = ComplexVector::Random(cpu_test_m);
+
+    CpuBackend::MGS<DeviceComplexType>(handle, Q.data(), H.data(), w.data(), cpu_test_m, num_iters, num_iters - 1);
+
+    // Residual must be orthogonal to the basis columns it was projected against
+    ASSERT_LE((Q.leftCols(num_iters).adjoint() * w).norm(), 1e-10);
+}
+
+TEST_F(CpublasTest, OrthonormalizeInPlaceTest) {
+    constexpr int num_iters = 8;
+    // Own engine, so later tests still see the same std::rand stream
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<HostPrecision> uniform(-1, 1);
+    auto random = [&](Eigen::Index rows, Eigen::Index cols) {
+        return ComplexMatrix(ComplexMatrix::NullaryExpr(rows, cols, [&] {return ComplexType(uniform(gen), uniform(gen));}));
+    };
+    const ComplexMatrix basis = Eigen::HouseholderQR<ComplexMatrix>(random(cpu_test_m, num_iters)).householderQ() *
+                                ComplexMatrix::Identity(cpu_test_m, num_iters);
+    ComplexVector work(num_iters + 1);
+    // Generic w, and one almost inside span(Q) so the DGKS pass fires
+    const ComplexVector inputs[2] = {random(cpu_test_m, 1), basis * random(num_iters, 1) + 1e-6 * random(cpu_test_m, 1)};
+    for (const ComplexVector& w : inputs) {
+        ComplexMatrix Q(cpu_test_m, num_iters + 1);
+        Q << basis, w;
+        ComplexMatrix H = ComplexMatrix::Zero(num_iters + 1, num_iters);
+        bool again = false;
+        const HostPrecision h_next = CpuBackend::orthonormalize<DeviceComplexType>(handle, Q.data(), H.data(), work.data(),
+                                                                                    cpu_test_m, num_iters, num_iters - 1, &again);
+        EXPECT_EQ(again, &w == &inputs[1]);
+        // Arnoldi relation for this column: w = Q h + h_next q_next, with q_next written over w
+        ASSERT_LE((w - basis * H.col(num_iters - 1).head(num_iters) - h_next * Q.col(num_iters)).norm(), 1e-12 * w.norm());
+        ASSERT_LE((basis.adjoint() * Q.col(num_iters)).norm(), 1e-13);
+        EXPECT_NEAR(Q.col(num_iters).norm(), 1.0, 1e-13);
+    }
+}
+
+#endif // CPUBLAS_TEST_HPP
@@ -0,0 +1,145 @@
+#ifndef LANCZOS_TEST_HPP
+#define LANCZOS_TEST_HPP
+
+#include <random>
+#include <gtest/gtest.h>
+#include "lanczos.hpp"
+
+constexpr size_t lanczos_dims = 400;
+
+// U diag(d) U^H for a random unitary/orthogonal U
+template <typename OM>
+inline OM hermitianWithSpectrum(const Vector& d) {
+    const OM U = Eigen::HouseholderQR<OM>(OM::Random(d.size(), d.size())).householderQ();
+    return U * d.cast<typename OM::Scalar>().asDiagonal() * U.adjoint();
+}
+
+// Top end close enough together that a 20 vector basis needs several restarts
+inline Vector lanczosSpectrum() {
+    Vector d = Vector::LinSpaced(lanczos_dims, 0.0, 1.0);
+    d.head(6) << 1.2, 1.15, 1.12, 1.1, -1.09, 1.08;
+    return d;
+}
+
+TEST(LanczosTests, HermitianRealRitzValues) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const ComplexMatrix A = hermitianWithSpectrum<ComplexMatrix>(lanczosSpectrum());
+
+    KrylovStats stats;
+    LanczosSolver<ComplexType> solver({.max_iters = 3000, .basis_size = 20, .restart_size = 8, .num_pairs = 5, .tol = 1e-10});
+    MixedEigenPairs pairs = solver.solve(A, handle, &stats);
+
+    const HostPrecision expected[] = {1.2, 1.15, 1.12, 1.1, -1.09};
+    ASSERT_EQ(pairs.num_pairs, 5u);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(pairs.values[i], expected[i], 1e-8) << "Ritz value " << i;
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((A * v - pairs.values[i] * v).norm(), 1e-8) << "Ritz pair " << i;
+    }
+    EXPECT_GT(stats.restarts, 0u);
+    EXPECT_EQ(stats.converged, 5u);
+    // Partial reorthogonalization: far fewer full sweeps than steps
+    EXPECT_LT(solver.reorthogonalizations(), stats.matvecs / 2);
+    std::cout << "Thick-restart Lanczos (Hermitian): " << stats << ", " << solver.reorthogonalizations() << " reorthogonalizations" << std::endl;
+    DefaultBackend::destroyHandle(handle);
+}
+
+TEST(LanczosTests, SymmetricMatchesFullReorthogonalization) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const Matrix A = hermitianWithSpectrum<Matrix>(lanczosSpectrum());
+
+    RealEigenPairs pairs = IRAMSymmetric<Matrix, lanczos_dims, 3000, 20, 8>(A, handle, 1e-10);
+    LanczosSolver<HostPrecision> reorth({.max_iters = 3000, .basis_size = 20, .restart_size = 8, .num_pairs = 8,
+                                         .tol = 1e-10, .full_reorth = true});
+    RealEigenPairs reference = reorth.solve(A, handle);
+
+    ASSERT_EQ(pairs.num_pairs, 8u);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(pairs.values[i], reference.values[i], 1e-8) << "Ritz value " << i;
+        const Vector v = pairs.vectors.col(i);
+        EXPECT_LT((A * v - pairs.values[i] * v).norm(), 1e-8) << "Ritz pair " << i;
+    }
+    EXPECT_LT((pairs.vectors.transpose() * pairs.vectors - Matrix::Identity(8, 8)).norm(), 1e-8);
+    DefaultBackend::destroyHandle(handle);
+}
+
+// Lower triangle from a generator, upper triangle its conjugate
+template <typename OM>
+inline OM randomSelfAdjoint(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<HostPrecision> dist;
+    OM A(n, n);
+    for (Eigen::Index i = 0; i < A.size(); ++i) {
+        if constexpr (is_complex_v<typename OM::Scalar>) {A.data()[i] = {dist(gen), dist(gen)};}
+        else {A.data()[i] = dist(gen);}
+    }
+    return (A + A.adjoint()) / std::sqrt(HostPrecision(4 * n));
+}
+
+TEST(LanczosTests, PackedSelfAdjointMatvec) {
+    // Ragged last tile, and forced threads so the per-thread slices are summed
+    const size_t n = 2 * SELFADJOINT_TILE + 37;
+    const Matrix A = randomSelfAdjoint<Matrix>(n, 21);
+    const ComplexMatrix H = randomSelfAdjoint<ComplexMatrix>(n, 22);
+    SymmetricMatrix P(A);
+    HermitianMatrix Q(H);
+    EXPECT_NEAR(P.norm(), A.norm(), 1e-12 * A.norm());
+    EXPECT_NEAR(Q.norm(), H.norm(), 1e-12 * H.norm());
+    EXPECT_LT(P.bytes(), A.size() * sizeof(HostPrecision) * 3 / 4);
+    EXPECT_EQ(P.at(3, n - 1), A(n - 1, 3));
+    EXPECT_EQ(Q.at(3, n - 1), std::conj(H(n - 1, 3)));
+    // An imaginary part on the diagonal is dropped, the stored operator stays Hermitian
+    ComplexMatrix skewed = H;
+    skewed.diagonal() += ComplexVector::Constant(n, ComplexType(0, 1e-3));
+    EXPECT_TRUE(HermitianMatrix(skewed).toDense() == H);
+
+    std::mt19937 gen(23);
+    std::normal_distribution<HostPrecision> dist;
+    Vector x(n), y(n);
+    ComplexVector z(n), w(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = dist(gen);
+        z[i] = {dist(gen), dist(gen)};
+    }
+    for (int threads : {1, 3}) {
+        P.setNumThreads(threads);
+        Q.setNumThreads(threads);
+        P.apply(x.data(), y.data());
+        Q.apply(z.data(), w.data());
+        EXPECT_LT((y - A * x).norm(), 1e-13 * A.norm() * x.norm()) << threads << " threads";
+        EXPECT_LT((w - H * z).norm(), 1e-13 * H.norm() * z.norm()) << threads << " threads";
+    }
+}
+
+TEST(LanczosTests, PackedSelfAdjointSolve) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    constexpr size_t n = 600;
+    Matrix A = randomSelfAdjoint<Matrix>(n, 24);
+    ComplexMatrix H = randomSelfAdjoint<ComplexMatrix>(n, 25);
+    for (size_t i = 0; i < 5; ++i) {
+        A(i, i) += HostPrecision(2 + 0.2 * i);
+        H(i, i) += HostPrecision(2 + 0.2 * i);
+    }
+
+    // Same Ritz values as the dense matrix, from half the storage
+    const RealEigenPairs dense = IRAMSymmetric<Matrix, n, 3000, 30, 8>(A, handle, 1e-10);
+    const RealEigenPairs packed = IRAMSymmetric<SymmetricMatrix, n, 3000, 30, 8>(SymmetricMatrix(A), handle, 1e-10);
+    const MixedEigenPairs dense_h = IRAMHermitian<ComplexMatrix, n, 3000, 30, 8>(H, handle, 1e-10);
+    const MixedEigenPairs packed_h = IRAMHermitian<HermitianMatrix, n, 3000, 30, 8>(HermitianMatrix(H), handle, 1e-10);
+    ASSERT_EQ(packed.num_pairs, dense.num_pairs);
+    ASSERT_EQ(packed_h.num_pairs, dense_h.num_pairs);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(packed.values[i], dense.values[i], 1e-9) << "Ritz value " << i;
+        EXPECT_NEAR(packed_h.values[i], dense_h.values[i], 1e-9) << "Ritz value " << i;
+        const Vector v = packed.vectors.col(i);
+        const ComplexVector u = packed_h.vectors.col(i);
+        EXPECT_LT((A * v - packed.values[i] * v).norm(), 1e-8) << "Ritz pair " << i;
+        EXPECT_LT((H * u - packed_h.values[i] * u).norm(), 1e-8) << "Ritz pair " << i;
+    }
+    DefaultBackend::destroyHandle(handle);
+}
+
+#endif // LANCZOS_TEST_HPP
@@ -0,0 +1,102 @@
+#ifndef OPERATOR_TEST_HPP
+#define OPERATOR_TEST_HPP
+
+#include <random>
+#include <gtest/gtest.h>
+#include "operator.hpp"
+#include "IRAM.hpp" // Pulls in include/arnoldi.hpp, tests/arnoldi.hpp would shadow a direct include
+
+constexpr size_t op_dims = 400;
+constexpr size_t op_iters = 60;
+
+// y = D x for a 1D convection-diffusion stencil, never formed densely
+inline auto stencilOperator(size_t n) {
+    return makeOperator<ComplexType>(n, n, [n](const ComplexType* x, ComplexType* y) {
+        for (size_t i = 0; i < n; ++i) {
+            ComplexType acc = HostPrecision(2) * x[i];
+            if (i > 0) {acc -= HostPrecision(1.3) * x[i - 1];}
+            if (i + 1 < n) {acc -= HostPrecision(0.7) * x[i + 1];}
+            y[i] = acc;
+        }
+    }, 4.0);
+}
+
+inline ComplexMatrix stencilDense(size_t n) {
+    ComplexMatrix D = ComplexMatrix::Zero(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        D(i, i) = 2.0;
+        if (i > 0) {D(i, i - 1) = -1.3;}
+        if (i + 1 < n) {D(i, i + 1) = -0.7;}
+    }
+    return D;
+}
+
+TEST(OperatorTests, ConceptDispatch) {
+    static_assert(!is_linear_operator_v<ComplexMatrix>, "Dense matrices take the matmul_internal path");
+    static_assert(is_linear_operator_v<decltype(stencilOperator(1))>, "Stencil must satisfy LinearOperator");
+}
+
+TEST(OperatorTests, ArnoldiRelationMatrixFree) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    auto op = stencilOperator(op_dims);
+    const ComplexMatrix D = stencilDense(op_dims);
+
+    KrylovPair<ComplexType> q_h = KrylovIter<decltype(op), op_dims, op_dims, op_iters>(op, handle);
+    const ComplexMatrix& Q = q_h.Q;
+    const ComplexMatrix& H = q_h.H;
+
+    // A Q_m = Q_{m+1} H_{m+1,m}
+    ASSERT_LE((D * Q.leftCols(op_iters) - Q * H).norm(), 1e-8);
+    ASSERT_LE((Q.adjoint() * Q - ComplexMatrix::Identity(op_iters + 1, op_iters + 1)).norm(), 1e-8);
+    DefaultBackend::destroyHandle(handle);
+}
+
+TEST(OperatorTests, ProductOperator) {
+    auto a = stencilOperator(op_dims);
+    auto b = stencilOperator(op_dims);
+    ProductOperator<decltype(a), decltype(b)> ab(a, b);
+    const ComplexMatrix D = stencilDense(op_dims);
+
+    ComplexVector x = ComplexVector::Random(op_dims);
+    ComplexVector y(op_dims);
+    ab.apply(x.data(), y.data());
+    ASSERT_LE((y - D * (D * x)).norm(), 1e-10);
+}
+
+TEST(OperatorTests, RealMatrixBlockUnderComplexBasis) {
+    // A real dense matrix must not be read as complex by the resident-gemm shortcut
+    constexpr size_t p = 3;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<HostPrecision> dist(-1, 1);
+    Matrix A(op_dims, op_dims);
+    ComplexMatrix X(op_dims, p), Y(op_dims, p);
+    for (Eigen::Index i = 0; i < A.size(); ++i) {A.data()[i] = dist(gen);}
+    for (Eigen::Index i = 0; i < X.size(); ++i) {X.data()[i] = {dist(gen), dist(gen)};}
+
+    CpuBackend::BlasHandle handle;
+    CpuBackend::createHandle(handle);
+    applyOperatorBlock<Matrix, DeviceComplexType, CpuBackend>(A, nullptr, X.data(), Y.data(), 0, op_dims, op_dims, p, handle);
+    ASSERT_LE((Y - A.cast<ComplexType>() * X).norm(), 1e-10);
+    CpuBackend::destroyHandle(handle);
+}
+
+TEST(OperatorTests, IRAMMatrixFree) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    auto op = stencilOperator(op_dims);
+    const ComplexMatrix D = stencilDense(op_dims);
+
+    ComplexEigenPairs ritzPairs = IRAM<decltype(op), op_dims, 400, op_iters, 10>(op, handle, solver_handle);
+    for (size_t i = 0; i < 3; ++i) {
+        const ComplexVector v = ritzPairs.vectors.col(i);
+        const HostPrecision residual = (D * v - ritzPairs.values[i] * v).norm() / v.norm();
+        EXPECT_LT(residual, 0.1) << "Ritz pair " << i;
+    }
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // OPERATOR_TEST_HPP
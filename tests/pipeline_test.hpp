@@ -0,0 +1,161 @@
+#ifndef PIPELINE_TEST_HPP
+#define PIPELINE_TEST_HPP
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "IRAM.hpp"
+
+TEST(PipelineTests, WorkerPoolRunsInOrderAndRethrows) {
+    WorkerPool pool(2);
+    std::vector<int> seen;
+    for (int i = 0; i < 100; ++i) {pool.launch(0, [&seen, i] { seen.push_back(i); });}
+    int other = 0;
+    pool.launch(1, [&other] { other = 7; });
+    pool.synchronize(0);
+    pool.synchronize(1);
+    ASSERT_EQ(seen.size(), 100u);
+    for (int i = 0; i < 100; ++i) {EXPECT_EQ(seen[i], i);}
+    EXPECT_EQ(other, 7);
+
+    pool.launch(0, [] { throw std::runtime_error("lane failure"); });
+    EXPECT_THROW(pool.synchronize(0), std::runtime_error);
+    pool.launch(0, [&other] { other = 8; }); // The lane survives a failed task
+    pool.synchronize(0);
+    EXPECT_EQ(other, 8);
+}
+
+TEST(PipelineTests, MatchesStandardArnoldiWithOneReductionPerStep) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const size_t n = 800;
+    const ComplexMatrix M = ComplexMatrix::Random(n, n) / std::sqrt(n);
+
+    SolverConfig config{.rows = n, .max_iters = 1000, .basis_size = 40, .restart_size = 10, .num_pairs = 6,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .orthogonalization = Orthogonalization::CGS2};
+    IRAMSolver<ComplexType> standard(config);
+    config.pipelined = true;
+    IRAMSolver<ComplexType> pipelined(config);
+    KrylovStats standard_stats, pipelined_stats;
+    std::srand(3);
+    const ComplexEigenPairs expected = standard.solve(M, handle, solver_handle, &standard_stats);
+    std::srand(3);
+    const ComplexEigenPairs pairs = pipelined.solve(M, handle, solver_handle, &pipelined_stats);
+
+    ASSERT_EQ(pairs.num_pairs, expected.num_pairs);
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        EXPECT_LT(std::abs(pairs.values[i] - expected.values[i]), 1e-8) << "Ritz value " << i;
+        const ComplexVector v = pairs.vectors.col(i), u = expected.vectors.col(i);
+        EXPECT_LT((M * v - pairs.values[i] * v).norm(), 2 * (M * u - expected.values[i] * u).norm() + 1e-10) << "Ritz pair " << i;
+    }
+    EXPECT_EQ(pipelined_stats.matvecs, standard_stats.matvecs + pipelined_stats.pipeline_refreshes);
+    EXPECT_LE(pipelined_stats.reductions, standard_stats.reductions);
+    EXPECT_LT(pipelined_stats.orthogonality_loss, 1e-12);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Run with --gtest_also_run_disabled_tests --gtest_filter=PipelineBenchmarks.*
+TEST(PipelineBenchmarks, DISABLED_PipelinedVsCGS2) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const size_t n = 800;
+    const ComplexMatrix M = ComplexMatrix::Random(n, n) / std::sqrt(n);
+
+    SolverConfig config{.rows = n, .max_iters = 1000, .basis_size = 40, .restart_size = 10, .num_pairs = 6,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .orthogonalization = Orthogonalization::CGS2};
+    IRAMSolver<ComplexType> standard(config);
+    config.pipelined = true;
+    IRAMSolver<ComplexType> pipelined(config);
+    KrylovStats stats;
+    auto elapsed = [](auto&& f) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+    std::srand(3);
+    const double standard_ms = elapsed([&] {standard.solve(M, handle, solver_handle);});
+    std::srand(3);
+    const double pipelined_ms = elapsed([&] {pipelined.solve(M, handle, solver_handle, &stats);});
+    std::cout << "n = " << n << ": CGS2 " << standard_ms << " ms, pipelined " << pipelined_ms << " ms, " << stats.matvecs
+              << " matvecs, " << stats.reductions << " reductions, " << stats.pipeline_refreshes << " refreshes" << std::endl;
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(PipelineTests, RecurrenceSurvivesCancellation) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    // Graded spectrum: A q_j lies mostly in span(Q), so most steps reorthogonalize and beta << ||A||
+    const size_t n = 400;
+    const Matrix M = Vector::LinSpaced(n, -12, 0).array().exp().matrix().asDiagonal();
+
+    IRAMSolver<HostPrecision> solver({.rows = n, .max_iters = 400, .basis_size = 40, .restart_size = 10, .num_pairs = 6,
+                                      .orthogonalization = Orthogonalization::CGS2, .pipelined = true});
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle, &stats);
+    EXPECT_GT(stats.reorthogonalizations, 0u);
+    EXPECT_LT(stats.pipeline_refreshes * 4, stats.matvecs); // Most next-step products still come from the recurrence
+    EXPECT_LT(stats.orthogonality_loss, 1e-12);
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M.cast<ComplexType>() * v - pairs.values[i] * v).norm(), 1e-12) << "Ritz pair " << i;
+    }
+    // Pipelining is one vector per reduction, it does not combine with s-step blocks
+    IRAMSolver<HostPrecision> both({.rows = n, .max_iters = 400, .basis_size = 40, .restart_size = 10, .num_pairs = 6,
+                                    .orthogonalization = Orthogonalization::CGS2, .s_step = 4, .pipelined = true});
+    EXPECT_THROW(both.solve(M, handle, solver_handle), std::invalid_argument);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Diagonal operator that records the thread count each apply runs with, a stand-in for operators with their own team
+struct ThreadRecordingOperator {
+    using Scalar = HostPrecision;
+    size_t n;
+    mutable int num_threads = 0;
+    mutable std::vector<int> seen;
+
+    size_t rows() const { return n; }
+    size_t cols() const { return n; }
+    int numThreads() const { return num_threads; }
+    void setNumThreads(int threads) const { num_threads = threads; }
+    void apply(const Scalar* x, Scalar* y) const {
+        seen.push_back(num_threads);
+        for (size_t i = 0; i < n; ++i) {y[i] = HostPrecision(i + 1) * x[i];}
+    }
+};
+
+TEST(PipelineTests, ThreadedOperatorGetsTheApplyShare) {
+    static_assert(ThreadedOperator<ThreadRecordingOperator> && ThreadedOperator<SparseMatrix> && ThreadedOperator<FloatStorageMatrix>,
+                  "Operators with setNumThreads must take part in the thread split");
+    CpuBackend::BlasHandle handle;
+    CpuBackend::SolverHandle solver_handle;
+    CpuBackend::createHandle(handle);
+    CpuBackend::createHandle(solver_handle);
+    handle.num_threads = 4;
+    const ThreadRecordingOperator op{.n = 200};
+    op.setNumThreads(7);
+
+    IRAMSolver<HostPrecision, CpuBackend> solver({.rows = 200, .max_iters = 200, .basis_size = 20, .restart_size = 5,
+                                                  .num_pairs = 2, .orthogonalization = Orthogonalization::CGS2, .pipelined = true});
+    solver.solve(op, handle, solver_handle);
+    // One thread projects, the other three apply, and the caller's setting is back afterwards
+    ASSERT_FALSE(op.seen.empty());
+    for (const int threads : op.seen) {EXPECT_EQ(threads, 3);}
+    EXPECT_EQ(op.numThreads(), 7);
+
+    CpuBackend::destroyHandle(handle);
+    CpuBackend::destroyHandle(solver_handle);
+}
+
+#endif // PIPELINE_TEST_HPP
@@ -0,0 +1,226 @@
+#ifndef PRECISION_TEST_HPP
+#define PRECISION_TEST_HPP
+
+#include <chrono>
+#include <limits>
+#include <random>
+#include <gtest/gtest.h>
+#include "alloc_hook.hpp"
+#include "precision.hpp"
+#include "IRAM.hpp"
+
+TEST(PrecisionTests, NarrowRoundsToNearestEven) {
+    // Exactly representable values round-trip
+    for (const double v : {0.0, 1.0, -2.5, 0.375, 65504.0, 0x1p-24}) {
+        EXPECT_EQ(widen(narrow<float16>(v)), float(v)) << v;
+    }
+    for (const double v : {0.0, 1.0, -2.5, 0.375, 0x1p100, 0x1p-130}) {
+        EXPECT_EQ(widen(narrow<bfloat16>(v)), float(v)) << v;
+    }
+    // Halfway between 1 and the next value rounds to the even neighbour, just above it rounds up
+    EXPECT_EQ(widen(narrow<float16>(1 + 0x1p-11)), 1.0f);
+    EXPECT_EQ(widen(narrow<float16>(1 + 3 * 0x1p-11)), 1.0f + 0x1p-9f);
+    EXPECT_EQ(widen(narrow<float16>(1 + 0x1p-11 + 0x1p-20)), 1.0f + 0x1p-10f);
+    EXPECT_EQ(widen(narrow<bfloat16>(1 + 0x1p-8)), 1.0f);
+    EXPECT_EQ(widen(narrow<bfloat16>(1 + 3 * 0x1p-8)), 1.0f + 0x1p-6f);
+    // Overflow, subnormals, NaN
+    EXPECT_EQ(widen(narrow<float16>(70000.0)), std::numeric_limits<float>::infinity());
+    EXPECT_EQ(widen(narrow<float16>(-0x1p-25 * 3)), -0x1p-23f);
+    EXPECT_TRUE(std::isnan(widen(narrow<float16>(std::numeric_limits<double>::quiet_NaN()))));
+    EXPECT_TRUE(std::isnan(widen(narrow<bfloat16>(std::numeric_limits<double>::quiet_NaN()))));
+}
+
+template <typename Op, typename MatrixType>
+void expectStoredMatvec(const Op& A, const MatrixType& D, HostPrecision rounding) {
+    using V = Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>;
+    std::mt19937 gen(5);
+    std::normal_distribution<HostPrecision> dist;
+    V x(D.cols()), y(D.rows());
+    for (Eigen::Index j = 0; j < x.size(); ++j) {
+        if constexpr (is_complex_v<typename Op::Scalar>) {x[j] = {dist(gen), dist(gen)};}
+        else {x[j] = dist(gen);}
+    }
+    A.apply(x.data(), y.data());
+    // Exact for the stored matrix up to double accumulation, within the storage error of the original
+    EXPECT_LT((y - A.toDense() * x).norm(), 1e-12 * D.norm() * x.norm());
+    EXPECT_LT((y - D * x).norm(), 2 * A.storageError() * D.norm() * x.norm());
+    EXPECT_LT(A.storageError(), rounding);
+    EXPECT_NEAR(A.norm(), D.norm(), 1e-12 * D.norm());
+}
+
+TEST(PrecisionTests, StoredMatvecAccumulatesInDouble) {
+    const size_t n = 203; // Odd, so the row-block tails run
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<HostPrecision> dist(-1, 1);
+    Matrix D(n, n + 5);
+    ComplexMatrix C(n, n);
+    for (Eigen::Index i = 0; i < D.size(); ++i) {D.data()[i] = dist(gen);}
+    for (Eigen::Index i = 0; i < C.size(); ++i) {C.data()[i] = {dist(gen), dist(gen)};}
+    static_assert(NormedOperator<BFloat16Matrix>, "Reduced-precision matrices must satisfy NormedOperator");
+
+    expectStoredMatvec(FloatStorageMatrix(D), D, 1e-7);
+    expectStoredMatvec(BFloat16Matrix(D), D, 4e-3);
+    expectStoredMatvec(Float16Matrix(D), D, 5e-4);
+    expectStoredMatvec(ComplexFloatStorageMatrix(C), C, 1e-7);
+    expectStoredMatvec(ComplexBFloat16Matrix(C), C, 4e-3);
+    expectStoredMatvec(ComplexFloat16Matrix(C), C, 5e-4);
+    EXPECT_EQ(BFloat16Matrix(D).bytes() * 4, D.size() * sizeof(HostPrecision));
+
+    // Real storage under a complex vector, both parts from one sweep
+    const Float16Matrix H(D);
+    ComplexVector x(D.cols()), y(D.rows());
+    for (Eigen::Index j = 0; j < x.size(); ++j) {x[j] = {dist(gen), dist(gen)};}
+    H.apply(x.data(), y.data());
+    EXPECT_LT((y - H.toDense().cast<ComplexType>() * x).norm(), 1e-12 * D.norm() * x.norm());
+    EXPECT_EQ(ComplexFloatStorageMatrix(C).bytes() * 2, C.size() * sizeof(ComplexType));
+
+    // Re-rounding a same-sized matrix reuses the storage
+    ComplexFloatStorageMatrix F(C);
+    const ComplexMatrix C2 = C.adjoint();
+    alloc_hook::start();
+    F.assign(C2);
+    EXPECT_EQ(alloc_hook::stop(), 0u);
+    expectStoredMatvec(F, C2, 1e-7);
+}
+
+// Well-separated dominant eigenvalues, so the perturbed problem stays well conditioned
+inline ComplexMatrix storedSolveMatrix(size_t n) {
+    std::mt19937 gen(11);
+    std::normal_distribution<HostPrecision> dist;
+    ComplexMatrix M(n, n);
+    for (Eigen::Index i = 0; i < M.size(); ++i) {M.data()[i] = {dist(gen), dist(gen)};}
+    M /= std::sqrt(HostPrecision(n));
+    for (size_t i = 0; i < 4; ++i) {M(i, i) += HostPrecision(3 + i);}
+    return M;
+}
+
+template <typename Op>
+ComplexEigenPairs storedSolve(const Op& A, KrylovStats* stats = nullptr) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    IRAMSolver<ComplexType> solver({.rows = size_t(A.rows()), .max_iters = 1000, .basis_size = 40, .restart_size = 10,
+                                    .num_pairs = 4, .restart = RestartMethod::KRYLOV_SCHUR,
+                                    .orthogonalization = Orthogonalization::CGS2});
+    std::srand(3);
+    const ComplexEigenPairs pairs = solver.solve(A, handle, solver_handle, stats);
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+    return pairs;
+}
+
+// Ritz pairs of the stored matrix, checked against the original: residuals level off at the storage error
+template <typename T>
+void expectStoredSolve(const ComplexMatrix& M, const ComplexEigenPairs& reference) {
+    const ReducedMatrix<T, ComplexType> A(M);
+    const ComplexEigenPairs pairs = storedSolve(A);
+
+    HostPrecision worst = 0;
+    ASSERT_EQ(pairs.num_pairs, reference.num_pairs);
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        const ComplexVector v = pairs.vectors.col(i);
+        worst = std::max(worst, (M * v - pairs.values[i] * v).norm() / (M.norm() * v.norm()));
+        EXPECT_LT(std::abs(pairs.values[i] - reference.values[i]), 4 * A.storageError() * M.norm()) << "Ritz value " << i;
+    }
+    EXPECT_LT(worst, 2 * A.storageError());
+}
+
+TEST(PrecisionTests, StoredSolveResidualsTrackStorageError) {
+    const ComplexMatrix M = storedSolveMatrix(1000);
+    const ComplexEigenPairs reference = storedSolve(M);
+    expectStoredSolve<float>(M, reference);
+    expectStoredSolve<bfloat16>(M, reference);
+    expectStoredSolve<float16>(M, reference);
+}
+
+// Run with --gtest_also_run_disabled_tests --gtest_filter=PrecisionBenchmarks.*
+TEST(PrecisionBenchmarks, DISABLED_StoredSolve) {
+    const ComplexMatrix M = storedSolveMatrix(1000);
+    auto timed = [](const auto& A) {
+        KrylovStats stats;
+        const auto start = std::chrono::high_resolution_clock::now();
+        storedSolve(A, &stats);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "  " << ms << " ms, " << stats.matvecs << " matvecs" << std::endl;
+    };
+    std::cout << "double" << std::endl;
+    timed(M);
+    auto reduced = [&]<typename T>() {
+        const ReducedMatrix<T, ComplexType> A(M);
+        A.report();
+        timed(A);
+    };
+    reduced.template operator()<float>();
+    reduced.template operator()<bfloat16>();
+    reduced.template operator()<float16>();
+}
+
+// Adaptive precision: float cycles first, then the same Ritz pairs at full-precision residuals
+template <typename MatrixType>
+void expectAdaptiveSolve(const MatrixType& M) {
+    using S = typename MatrixType::Scalar;
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    SolverConfig config{.rows = size_t(M.rows()), .max_iters = 2000, .basis_size = 40, .restart_size = 10, .num_pairs = 4,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .orthogonalization = Orthogonalization::CGS2};
+    IRAMSolver<S> plain(config);
+    std::srand(3);
+    const ComplexEigenPairs reference = plain.solve(M, handle, solver_handle);
+    config.adaptive_precision = true;
+    IRAMSolver<S> adaptive(config);
+    KrylovStats stats;
+    std::srand(3);
+    const ComplexEigenPairs pairs = adaptive.solve(M, handle, solver_handle, &stats);
+
+    EXPECT_GT(stats.single_precision_cycles, 0u);
+    EXPECT_EQ(stats.converged, 4u);
+    ASSERT_EQ(pairs.num_pairs, reference.num_pairs);
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M * v - pairs.values[i] * v).norm() / (M.norm() * v.norm()), 1e-9) << "Ritz pair " << i;
+        EXPECT_LT(std::abs(pairs.values[i] - reference.values[i]), 1e-9 * M.norm()) << "Ritz value " << i;
+    }
+    // A second solve re-rounds into the kept float copy
+    const MatrixType shifted = M + MatrixType::Identity(M.rows(), M.cols());
+    std::srand(3);
+    const ComplexEigenPairs again = adaptive.solve(shifted, handle, solver_handle);
+    ASSERT_EQ(again.num_pairs, pairs.num_pairs);
+    for (size_t i = 0; i < again.num_pairs; ++i) {
+        EXPECT_LT(std::abs(again.values[i] - (pairs.values[i] + HostPrecision(1))), 1e-9 * M.norm()) << "Ritz value " << i;
+    }
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(PrecisionTests, AdaptiveSolveFinishesInDouble) {
+    const size_t n = 600;
+    std::mt19937 gen(13);
+    std::normal_distribution<HostPrecision> dist;
+    ComplexMatrix C(n, n);
+    Matrix R(n, n);
+    for (Eigen::Index i = 0; i < C.size(); ++i) {C.data()[i] = {dist(gen), dist(gen)};}
+    for (Eigen::Index i = 0; i < R.size(); ++i) {R.data()[i] = dist(gen);}
+    C /= std::sqrt(HostPrecision(n));
+    R /= std::sqrt(HostPrecision(n));
+    for (size_t i = 0; i < 4; ++i) {
+        C(i, i) += HostPrecision(1.5 + 0.2 * i);
+        R(i, i) += HostPrecision(1.5 + 0.2 * i);
+    }
+    expectAdaptiveSolve(C);
+    expectAdaptiveSolve(R);
+
+    // Matrix-free operators need a single-precision apply
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    const auto scale = makeOperator<ComplexType>(n, n, [n](const ComplexType* x, ComplexType* y) {
+        for (size_t i = 0; i < n; ++i) {y[i] = HostPrecision(i + 1) * x[i];}
+    });
+    IRAMSolver<ComplexType> solver({.rows = n, .max_iters = 200, .basis_size = 20, .restart_size = 5, .num_pairs = 2,
+                                    .adaptive_precision = true});
+    EXPECT_THROW(solver.solve(scale, handle, solver_handle), std::invalid_argument);
+}
+
+#endif // PRECISION_TEST_HPP
@@ -0,0 +1,332 @@
+#ifndef RESTART_TEST_HPP
+#define RESTART_TEST_HPP
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include "IRAM.hpp"
+
+// Unitarily similar to an upper triangular matrix with the given diagonal, so non-normal with a known spectrum
+inline ComplexMatrix nonNormalWithSpectrum(const ComplexVector& d) {
+    const Eigen::Index n = d.size();
+    ComplexMatrix T = 0.1 * ComplexMatrix::Random(n, n).triangularView<Eigen::StrictlyUpper>().toDenseMatrix() / std::sqrt(n);
+    T.diagonal() = d;
+    const ComplexMatrix U = Eigen::HouseholderQR<ComplexMatrix>(ComplexMatrix::Random(n, n)).householderQ();
+    return U * T * U.adjoint();
+}
+
+inline ComplexVector restartSpectrum(size_t n) {
+    ComplexVector d = Vector::LinSpaced(n, 0, 1).cast<ComplexType>();
+    d.head(5) << ComplexType(1.5, 0.2), ComplexType(-1.4, 0), ComplexType(0, 1.3), ComplexType(1.2, -0.3), ComplexType(-1.1, 0.1);
+    return d;
+}
+
+TEST(RestartTests, RestartModesKeepKrylovRelation) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const size_t N = 2000, m = 60, k = 12;
+    const ComplexMatrix M = ComplexMatrix::Random(N, N) / std::sqrt(N);
+    const KrylovPair<ComplexType> q_h = KrylovIter<ComplexMatrix>(M, handle, m);
+
+    WorkspaceArena arena(RestartWorkspace::footprint(m));
+    RestartWorkspace ws;
+    ws.bind(arena, m);
+    ComplexMatrix Q_block(N, m), H_square(m, m);
+
+    // Same factorization through every restart
+    ComplexMatrix Q_rot = q_h.Q, H_rot = q_h.H;
+    ws.update = BasisUpdate::ROTATE;
+    reduceArnoldiPairDynamic<ComplexMatrix>(Q_rot, H_rot, N, m, k, handle, solver_handle, Q_block, H_square, ws, false);
+    ComplexMatrix Q_qr = q_h.Q, H_qr = q_h.H;
+    ws.update = BasisUpdate::ACCUMULATE;
+    reduceArnoldiPairDynamic<ComplexMatrix>(Q_qr, H_qr, N, m, k, handle, solver_handle, Q_block, H_square, ws, false);
+    ComplexMatrix Q_ks = q_h.Q, H_ks = q_h.H;
+    krylovSchurRestart<ComplexMatrix>(Q_ks, H_ks, N, m, k, handle, Q_block, H_square, ws, false);
+
+    // Both basis updates apply the same transformation
+    EXPECT_LT((Q_rot.leftCols(k) - Q_qr.leftCols(k)).norm(), 1e-8);
+    EXPECT_LT((H_rot - H_qr).norm(), 1e-8);
+
+    // Shifted QR keeps the relation on k - 1 columns, Krylov-Schur on all k
+    EXPECT_LT((M * Q_qr.leftCols(k - 1) - Q_qr.leftCols(k) * H_qr.topLeftCorner(k, k - 1)).norm(), 1e-8);
+    EXPECT_LT((M * Q_ks.leftCols(k) - Q_ks.leftCols(k + 1) * H_ks.topLeftCorner(k + 1, k)).norm(), 1e-8);
+    EXPECT_LT((Q_ks.leftCols(k + 1).adjoint() * Q_ks.leftCols(k + 1) - ComplexMatrix::Identity(k + 1, k + 1)).norm(), 1e-10);
+
+    // T_k carries the k largest Ritz values of H_m, in order
+    ComplexEigenPairs ritz{};
+    eigSolver<ComplexMatrix>(q_h.H.topLeftCorner(m, m), ritz, m);
+    for (size_t i = 0; i < k; ++i) {EXPECT_LT(std::abs(H_ks(i, i) - ritz.values[i]), 1e-9);}
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(RestartTests, KrylovSchurSolveMatchesShiftedQR) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const ComplexVector d = restartSpectrum(400);
+    const ComplexMatrix M = nonNormalWithSpectrum(d);
+
+    SolverConfig config{.max_iters = 600, .basis_size = 16, .restart_size = 8, .num_pairs = 4};
+    IRAMSolver<ComplexType> qr_solver(config);
+    config.restart = RestartMethod::KRYLOV_SCHUR;
+    IRAMSolver<ComplexType> ks_solver(config);
+    KrylovStats qr_stats, ks_stats;
+    const ComplexEigenPairs qr = qr_solver.solve(M, handle, solver_handle, &qr_stats);
+    const ComplexEigenPairs ks = ks_solver.solve(M, handle, solver_handle, &ks_stats);
+    EXPECT_GT(ks_stats.restarts, 0u);
+
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_LT(std::abs(ks.values[i] - d[i]), 1e-8);
+        EXPECT_LT(std::abs(qr.values[i] - d[i]), 1e-8);
+        const ComplexVector v = ks.vectors.col(i);
+        EXPECT_LT((M * v - ks.values[i] * v).norm() / v.norm(), 1e-7);
+    }
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(RestartTests, ConvergenceStopsRestarting) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const ComplexVector d = restartSpectrum(400);
+    const ComplexMatrix M = nonNormalWithSpectrum(d);
+
+    // A budget of 500 cycles, the wanted pairs converge within a handful
+    IRAMSolver<ComplexType> solver({.max_iters = 8000, .basis_size = 16, .restart_size = 8, .num_pairs = 4, .tol = 1e-10});
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle, &stats);
+    EXPECT_GT(stats.restarts, 0u);
+    EXPECT_LT(stats.matvecs, 400u);
+    EXPECT_EQ(stats.converged, 4u);
+    ASSERT_EQ(stats.residuals.size(), 4);
+    const HostPrecision matnorm = M.norm();
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_LT(stats.residuals[i], 1e-10 * matnorm);
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M * v - pairs.values[i] * v).norm() / v.norm(), 1e-8);
+    }
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(RestartTests, LockingKeepsConvergedPairs) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    // Many wanted pairs converging at different rates, as in spectral clustering
+    const size_t n = 600, nev = 20;
+    ComplexVector d = Vector::LinSpaced(n, 0, 1).cast<ComplexType>();
+    for (size_t i = 0; i < nev; ++i) {d[i] = ComplexType(1.1 - 0.004 * i, 0.002 * i);}
+    const ComplexMatrix M = nonNormalWithSpectrum(d);
+
+    SolverConfig config{.max_iters = 20000, .basis_size = 50, .restart_size = 30, .num_pairs = nev,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .locking = false};
+    IRAMSolver<ComplexType> plain(config);
+    config.locking = true;
+    IRAMSolver<ComplexType> locking(config);
+    KrylovStats plain_stats, locking_stats;
+    const ComplexEigenPairs a = plain.solve(M, handle, solver_handle, &plain_stats);
+    const ComplexEigenPairs b = locking.solve(M, handle, solver_handle, &locking_stats);
+
+    EXPECT_EQ(plain_stats.converged, nev);
+    EXPECT_EQ(locking_stats.converged, nev);
+    EXPECT_GT(locking_stats.locked, 0u);
+    for (size_t i = 0; i < nev; ++i) {
+        EXPECT_LT(std::abs(a.values[i] - d[i]), 1e-8);
+        EXPECT_LT(std::abs(b.values[i] - d[i]), 1e-8);
+        const ComplexVector v = b.vectors.col(i);
+        EXPECT_LT((M * v - b.values[i] * v).norm() / v.norm(), 1e-8);
+    }
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Timings behind the README numbers, run with --gtest_also_run_disabled_tests --gtest_filter=RestartBenchmarks.*
+TEST(RestartBenchmarks, DISABLED_RestartAndLocking) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    auto elapsed = [](auto&& f) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    // One restart of the same factorization each way, best of three
+    const size_t N = 2000, m = 60, k = 12;
+    const ComplexMatrix M = ComplexMatrix::Random(N, N) / std::sqrt(N);
+    const KrylovPair<ComplexType> q_h = KrylovIter<ComplexMatrix>(M, handle, m);
+    WorkspaceArena arena(RestartWorkspace::footprint(m));
+    RestartWorkspace ws;
+    ws.bind(arena, m);
+    ComplexMatrix Q_block(N, m), H_square(m, m), Q, H;
+    double rotate_ms = 1e30, qr_ms = 1e30, ks_ms = 1e30;
+    for (int rep = 0; rep < 3; ++rep) {
+        Q = q_h.Q; H = q_h.H;
+        ws.update = BasisUpdate::ROTATE;
+        rotate_ms = std::min(rotate_ms, elapsed([&] {reduceArnoldiPairDynamic<ComplexMatrix>(Q, H, N, m, k, handle, solver_handle, Q_block, H_square, ws, false);}));
+        Q = q_h.Q; H = q_h.H;
+        ws.update = BasisUpdate::ACCUMULATE;
+        qr_ms = std::min(qr_ms, elapsed([&] {reduceArnoldiPairDynamic<ComplexMatrix>(Q, H, N, m, k, handle, solver_handle, Q_block, H_square, ws, false);}));
+        Q = q_h.Q; H = q_h.H;
+        ks_ms = std::min(ks_ms, elapsed([&] {krylovSchurRestart<ComplexMatrix>(Q, H, N, m, k, handle, Q_block, H_square, ws, false);}));
+    }
+    std::cout << "Restart N = " << N << ", m = " << m << ", k = " << k << ": shifted QR rotating the basis " << rotate_ms
+              << " ms, accumulated " << qr_ms << " ms, Krylov-Schur " << ks_ms << " ms" << std::endl;
+
+    // Many wanted pairs, Krylov-Schur with and without locking
+    const size_t n = 600, nev = 20;
+    ComplexVector d = Vector::LinSpaced(n, 0, 1).cast<ComplexType>();
+    for (size_t i = 0; i < nev; ++i) {d[i] = ComplexType(1.1 - 0.004 * i, 0.002 * i);}
+    const ComplexMatrix A = nonNormalWithSpectrum(d);
+    SolverConfig config{.max_iters = 20000, .basis_size = 50, .restart_size = 30, .num_pairs = nev,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .locking = false};
+    IRAMSolver<ComplexType> plain(config);
+    config.locking = true;
+    IRAMSolver<ComplexType> locking(config);
+    KrylovStats plain_stats, locking_stats;
+    const double plain_ms = elapsed([&] {plain.solve(A, handle, solver_handle, &plain_stats);});
+    const double locking_ms = elapsed([&] {locking.solve(A, handle, solver_handle, &locking_stats);});
+    std::cout << "Krylov-Schur, " << nev << " pairs: " << plain_ms << " ms (" << plain_stats << ") without locking, "
+              << locking_ms << " ms (" << locking_stats << ", " << locking_stats.locked << " locked) with" << std::endl;
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(RestartTests, FrancisStepDeflatesExactPair) {
+    const Eigen::Index m = 40;
+    // Hessenberg form of a random orthogonal matrix: normal, so exact shifts deflate to working accuracy
+    const Matrix O = Eigen::HouseholderQR<Matrix>(Matrix::Random(m, m)).householderQ();
+    const Matrix H0 = Eigen::HessenbergDecomposition<Matrix>(O).matrixH();
+    const ComplexVector values = Eigen::EigenSolver<Matrix>(H0, false).eigenvalues();
+    Eigen::Index pair = 0;
+    while (values[pair].imag() <= 0) {++pair;}
+
+    // An exact conjugate pair as the two shifts splits it off the bottom of H in one real step
+    Matrix H = H0;
+    Matrix Q = Matrix::Identity(m, m);
+    std::vector<Reflector3> reflectors(m);
+    Vector c(m), s(m);
+    francisDoubleStep(cpublas::Handle{}, H, Q, 2 * values[pair].real(), std::norm(values[pair]), reflectors.data(), c.data(), s.data());
+    EXPECT_TRUE(isHessenberg<Matrix>(H));
+    EXPECT_LT(std::abs(H(m - 2, m - 3)), 1e-8 * H0.norm());
+    EXPECT_LT((Q.transpose() * Q - Matrix::Identity(m, m)).norm(), 1e-12);
+    EXPECT_LT((Q * H * Q.transpose() - H0).norm(), 1e-12 * H0.norm());
+    const ComplexVector tail = Eigen::EigenSolver<Matrix>(H.bottomRightCorner(2, 2), false).eigenvalues();
+    EXPECT_LT(std::min(std::abs(tail[0] - values[pair]), std::abs(tail[1] - values[pair])), 1e-8);
+}
+
+// Real nonsymmetric, dominant spectrum 1.5 +- 0.4i, -1.3, 1.2 +- 0.2i, similarity-transformed upper triangular
+inline Matrix realWithConjugatePairs(Eigen::Index n) {
+    Matrix T = 0.1 * Matrix::Random(n, n).triangularView<Eigen::StrictlyUpper>().toDenseMatrix() / std::sqrt(n);
+    T.diagonal() = Vector::LinSpaced(n, 0, 1);
+    T.block(0, 0, 2, 2) << 1.5, 0.4, -0.4, 1.5;
+    T(2, 2) = -1.3;
+    T.block(3, 3, 2, 2) << 1.2, 0.2, -0.2, 1.2;
+    T(1, 0) = -0.4; T(4, 3) = -0.2;
+    const Matrix U = Eigen::HouseholderQR<Matrix>(Matrix::Random(n, n)).householderQ();
+    return U * T * U.transpose();
+}
+
+inline void expectRealConjugatePairs(const Matrix& M, const ComplexEigenPairs& pairs) {
+    const ComplexType expected[] = {{1.5, 0.4}, {1.5, -0.4}, {-1.3, 0}, {1.2, 0.2}, {1.2, -0.2}};
+    ASSERT_GE(pairs.num_pairs, 5u);
+    for (size_t i = 0; i < 5; ++i) {
+        HostPrecision err = 1e30;
+        for (const ComplexType& e : expected) {err = std::min(err, std::abs(pairs.values[i] - e));}
+        EXPECT_LT(err, 1e-8);
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M * v - pairs.values[i] * v).norm() / v.norm(), 1e-7);
+    }
+}
+
+TEST(RestartTests, RealRestartStaysReal) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const Matrix M = realWithConjugatePairs(400);
+
+    IRAMSolver<HostPrecision> solver({.max_iters = 600, .basis_size = 16, .restart_size = 8, .num_pairs = 5});
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle, &stats);
+    EXPECT_GT(stats.restarts, 0u);
+    expectRealConjugatePairs(M, pairs);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Real Krylov-Schur: T_k stays quasi-triangular, so a conjugate pair at the cut is kept whole or not at all
+TEST(RestartTests, RealKrylovSchurKeepsPairsWhole) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const size_t N = 1000, m = 40;
+    std::mt19937 gen(21);
+    std::normal_distribution<HostPrecision> normal;
+    const Matrix M = Matrix::NullaryExpr(N, N, [&] {return normal(gen);}) / std::sqrt(N);
+    const KrylovPair<HostPrecision> q_h = KrylovIter<Matrix>(M, handle, m);
+    ComplexEigenPairs ritz{};
+    eigSolver<Matrix>(q_h.H.topLeftCorner(m, m), ritz, m);
+
+    WorkspaceArena arena(RestartWorkspace::footprint(m));
+    RestartWorkspace ws;
+    ws.bind(arena, m);
+    Matrix Q_block(N, m), H_square(m, m);
+    size_t grown = 0;
+    for (size_t k = 8; k < 16; ++k) {
+        Matrix Q = q_h.Q, H = q_h.H;
+        const size_t kept = krylovSchurRestart<Matrix>(Q, H, N, m, k, handle, Q_block, H_square, ws, false);
+        ASSERT_TRUE(kept == k || kept == k + 1);
+        grown += kept > k;
+        EXPECT_LT((M * Q.leftCols(kept) - Q.leftCols(kept + 1) * H.topLeftCorner(kept + 1, kept)).norm(), 1e-8);
+        EXPECT_LT((Q.leftCols(kept + 1).transpose() * Q.leftCols(kept + 1) - Matrix::Identity(kept + 1, kept + 1)).norm(), 1e-10);
+        // T_k carries exactly the kept largest Ritz values of H_m, conjugate pairs included
+        ComplexEigenPairs t{};
+        eigSolver<Matrix>(H.topLeftCorner(kept, kept), t, kept);
+        for (size_t i = 0; i < kept; ++i) {EXPECT_LT(std::abs(std::abs(t.values[i]) - std::abs(ritz.values[i])), 1e-9) << "k = " << k;}
+        if (kept < m) {EXPECT_GT(std::abs(ritz.values[kept - 1] - std::conj(ritz.values[kept])), 1e-9) << "pair split at k = " << k;}
+    }
+    EXPECT_GT(grown, 0u);
+
+    DefaultBackend::destroyHandle(handle);
+}
+
+TEST(RestartTests, RealKrylovSchurSolve) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const Matrix M = realWithConjugatePairs(400);
+
+    // restart_size 4 cuts through the 1.2 +- 0.2i pair, every restart keeps 5 columns
+    SolverConfig config{.max_iters = 600, .basis_size = 16, .restart_size = 4, .num_pairs = 4, .restart = RestartMethod::KRYLOV_SCHUR};
+    IRAMSolver<HostPrecision> solver(config);
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle, &stats);
+    EXPECT_GT(stats.restarts, 0u);
+    EXPECT_EQ(stats.converged, 4u);
+    config.restart_size = 8;
+    config.num_pairs = 5;
+    IRAMSolver<HostPrecision> wide(config);
+    expectRealConjugatePairs(M, wide.solve(M, handle, solver_handle));
+    // The real solver's host workspace holds no complex N x B block
+    EXPECT_LT(IRAMSolver<HostPrecision>::hostFootprint(400, 16), 0.55 * IRAMSolver<ComplexType>::hostFootprint(400, 16));
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // RESTART_TEST_HPP
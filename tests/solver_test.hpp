@@ -0,0 +1,152 @@
+#ifndef SOLVER_TEST_HPP
+#define SOLVER_TEST_HPP
+
+#include <chrono>
+#include <random>
+#include <gtest/gtest.h>
+#include "IRAM.hpp"
+
+inline ComplexMatrix normalizedRandom(size_t n) {
+    ComplexMatrix M = ComplexMatrix::Random(n, n);
+    return M / M.norm();
+}
+
+inline HostPrecision worstResidual(const ComplexMatrix& M, const ComplexEigenPairs& pairs, size_t count) {
+    HostPrecision worst = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ComplexVector v = pairs.vectors.col(i);
+        worst = std::max(worst, (M * v - pairs.values[i] * v).norm() / v.norm());
+    }
+    return worst;
+}
+
+TEST(SolverTests, RuntimeSizesReuseWorkspaces) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+
+    IRAMSolver<ComplexType> solver({.rows = 300, .max_iters = 400, .basis_size = 40, .restart_size = 8, .num_pairs = 4});
+    const size_t warm = solver.workspaceAllocations();
+
+    const ComplexMatrix large = normalizedRandom(300);
+    ComplexEigenPairs pairs = solver.solve(large, handle, solver_handle);
+    ASSERT_EQ(pairs.num_pairs, 4u);
+    EXPECT_LT(worstResidual(large, pairs, 4), 0.1);
+
+    // Smaller problem, sizes only known at call time: no workspace may be reallocated
+    const ComplexMatrix small = normalizedRandom(200);
+    pairs = solver.solve(small, handle, solver_handle);
+    EXPECT_LT(worstResidual(small, pairs, 4), 0.1);
+    EXPECT_EQ(solver.workspaceAllocations(), warm);
+
+    // Growing the basis does reallocate
+    solver.configure({.max_iters = 400, .basis_size = 60, .restart_size = 8, .num_pairs = 4});
+    pairs = solver.solve(small, handle, solver_handle);
+    EXPECT_GT(solver.workspaceAllocations(), warm);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(SolverTests, RuntimeKrylovIter) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const ComplexMatrix M = normalizedRandom(150);
+    const size_t iters = 30;
+    KrylovPair<ComplexType> q_h = KrylovIter<ComplexMatrix>(M, handle, iters);
+    ASSERT_LE((M * q_h.Q.leftCols(iters) - q_h.Q * q_h.H).norm(), 1e-8);
+    DefaultBackend::destroyHandle(handle);
+}
+
+TEST(SolverTests, CGS2KeepsBasisOrthogonal) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+
+    // Graded spectrum: the Krylov basis is badly conditioned, which is where MGS drifts
+    const size_t N = 1500, m = 80;
+    const ComplexMatrix M = Vector::LinSpaced(N, -8, 0).array().exp().cast<ComplexType>().matrix().asDiagonal();
+    const KrylovPair<ComplexType> mgs = KrylovIter<ComplexMatrix>(M, handle, m, default_tol, Orthogonalization::MGS);
+    const KrylovPair<ComplexType> cgs2 = KrylovIter<ComplexMatrix>(M, handle, m, default_tol, Orthogonalization::CGS2);
+    const HostPrecision mgs_loss = orthogonalityLoss<ComplexMatrix>(mgs.Q.leftCols(m));
+    const HostPrecision cgs2_loss = orthogonalityLoss<ComplexMatrix>(cgs2.Q.leftCols(m));
+    EXPECT_LE((M * cgs2.Q.leftCols(m) - cgs2.Q * cgs2.H).norm(), 1e-8);
+    EXPECT_LT(cgs2_loss, 1e-12);
+    EXPECT_LE(cgs2_loss, mgs_loss);
+
+    // Selectable per solver, reported through KrylovStats
+    IRAMSolver<ComplexType> solver({.rows = 300, .max_iters = 400, .basis_size = 40, .restart_size = 8, .num_pairs = 4,
+                                    .orthogonalization = Orthogonalization::CGS2});
+    const ComplexMatrix A = normalizedRandom(300);
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(A, handle, solver_handle, &stats);
+    EXPECT_LT(worstResidual(A, pairs, 4), 1e-4);
+    EXPECT_LT(stats.orthogonality_loss, 1e-12);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+// Run with --gtest_also_run_disabled_tests --gtest_filter=SolverBenchmarks.*
+TEST(SolverBenchmarks, DISABLED_MGSvsCGS2) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    const size_t N = 1500, m = 80;
+    const ComplexMatrix M = Vector::LinSpaced(N, -8, 0).array().exp().cast<ComplexType>().matrix().asDiagonal();
+    auto timed = [&](Orthogonalization orth, double& ms) {
+        KrylovPair<ComplexType> q_h;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            q_h = KrylovIter<ComplexMatrix>(M, handle, m, default_tol, orth);
+            ms = std::min(ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+        return q_h;
+    };
+    double mgs_ms = 1e30, cgs2_ms = 1e30;
+    const KrylovPair<ComplexType> mgs = timed(Orthogonalization::MGS, mgs_ms);
+    const KrylovPair<ComplexType> cgs2 = timed(Orthogonalization::CGS2, cgs2_ms);
+    std::cout << "Arnoldi N = " << N << ", m = " << m << ": MGS " << mgs_ms << " ms, loss " << orthogonalityLoss<ComplexMatrix>(mgs.Q.leftCols(m))
+              << "; CGS2 " << cgs2_ms << " ms, loss " << orthogonalityLoss<ComplexMatrix>(cgs2.Q.leftCols(m)) << std::endl;
+    DefaultBackend::destroyHandle(handle);
+}
+
+TEST(SolverTests, RealMatrixInComplexBasis) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const size_t n = 400;
+    std::mt19937 gen(17);
+    std::normal_distribution<HostPrecision> dist;
+    Matrix R(n, n);
+    for (Eigen::Index i = 0; i < R.size(); ++i) {R.data()[i] = dist(gen);}
+    R /= std::sqrt(HostPrecision(n));
+    for (size_t i = 0; i < 4; ++i) {R(i, i) += HostPrecision(1.5 + 0.2 * i);}
+    const ComplexMatrix promoted = R.cast<ComplexType>();
+
+    // The real matrix is applied as is, every expansion path must match a solve on its complex copy
+    const SolverConfig base{.rows = n, .max_iters = 2000, .basis_size = 40, .restart_size = 10, .num_pairs = 4,
+                            .restart = RestartMethod::KRYLOV_SCHUR, .orthogonalization = Orthogonalization::CGS2};
+    SolverConfig mgs = base, sstep = base, pipelined = base;
+    mgs.orthogonalization = Orthogonalization::MGS;
+    sstep.s_step = 4;
+    pipelined.pipelined = true;
+    for (const SolverConfig& config : {base, mgs, sstep, pipelined}) {
+        IRAMSolver<ComplexType> real_solver(config), complex_solver(config);
+        std::srand(3);
+        const ComplexEigenPairs pairs = real_solver.solve(R, handle, solver_handle);
+        std::srand(3);
+        const ComplexEigenPairs reference = complex_solver.solve(promoted, handle, solver_handle);
+        ASSERT_EQ(pairs.num_pairs, reference.num_pairs);
+        for (size_t i = 0; i < pairs.num_pairs; ++i) {
+            EXPECT_LT(std::abs(pairs.values[i] - reference.values[i]), 1e-9) << "Ritz value " << i;
+        }
+        EXPECT_LT(worstResidual(promoted, pairs, pairs.num_pairs), 1e-8);
+    }
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // SOLVER_TEST_HPP
@@ -0,0 +1,177 @@
+#ifndef SPARSE_TEST_HPP
+#define SPARSE_TEST_HPP
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include "sparse.hpp"
+#include "IRAM.hpp" // Pulls in include/arnoldi.hpp, tests/arnoldi.hpp would shadow a direct include
+
+constexpr size_t sp_dims = 5000;
+constexpr size_t sp_iram_dims = 400;
+constexpr size_t sp_bench_grid = 200;
+constexpr size_t sp_bench_dims = sp_bench_grid * sp_bench_grid;
+constexpr size_t sp_bench_iters = 30;
+
+// Tridiagonal plus one dense row, so a row-split SpMV would leave every thread but one idle
+template <typename T>
+inline Eigen::SparseMatrix<T> skewedSparse(size_t n) {
+    std::vector<Eigen::Triplet<T>> triplets;
+    for (size_t i = 0; i < n; ++i) {
+        triplets.emplace_back(i, i, T(2.0));
+        if (i > 0) {triplets.emplace_back(i, i - 1, T(-1.3));}
+        if (i + 1 < n) {triplets.emplace_back(i, i + 1, T(-0.7));}
+    }
+    for (size_t j = 0; j < n; j += 2) {triplets.emplace_back(n / 3, j, T(0.01));}
+    Eigen::SparseMatrix<T> A(n, n);
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    return A;
+}
+
+TEST(SparseTests, MergePathSpMVReal) {
+    const Eigen::SparseMatrix<HostPrecision> E = skewedSparse<HostPrecision>(sp_dims);
+    SparseMatrix A = SparseMatrix::fromEigen(E);
+    A.setNumThreads(4); // Threads split rows mid-way, exercises the carry fix-up
+    static_assert(is_linear_operator_v<SparseMatrix>, "CSR must satisfy LinearOperator");
+
+    Vector x = Vector::Random(sp_dims);
+    Vector y(sp_dims);
+    A.apply(x.data(), y.data());
+    ASSERT_LE((y - E * x).norm(), 1e-10);
+}
+
+TEST(SparseTests, MergePathSpMVComplex) {
+    const Eigen::SparseMatrix<ComplexType> E = skewedSparse<ComplexType>(sp_dims) * ComplexType(0.5, 1.5);
+    ComplexSparseMatrix A = ComplexSparseMatrix::fromEigen(E);
+    MixedSparseMatrix R = MixedSparseMatrix::fromEigen(skewedSparse<HostPrecision>(sp_dims));
+    A.setNumThreads(3);
+    R.setNumThreads(3);
+
+    ComplexVector x = ComplexVector::Random(sp_dims);
+    ComplexVector y(sp_dims);
+    A.apply(x.data(), y.data());
+    ASSERT_LE((y - E * x).norm(), 1e-10);
+
+    // Real storage against a complex vector, the matrix is never promoted
+    R.apply(x.data(), y.data());
+    ASSERT_LE((y - skewedSparse<HostPrecision>(sp_dims).cast<ComplexType>() * x).norm(), 1e-10);
+}
+
+// 2D 5-point Laplacian, the short-row case SELL targets
+inline Eigen::SparseMatrix<HostPrecision> laplacian2D(size_t g) {
+    std::vector<Eigen::Triplet<HostPrecision>> triplets;
+    for (size_t i = 0; i < g; ++i) {
+        for (size_t j = 0; j < g; ++j) {
+            const size_t r = i * g + j;
+            triplets.emplace_back(r, r, 4.0);
+            if (i > 0) {triplets.emplace_back(r, r - g, -1.0);}
+            if (i + 1 < g) {triplets.emplace_back(r, r + g, -1.0);}
+            if (j > 0) {triplets.emplace_back(r, r - 1, -1.0);}
+            if (j + 1 < g) {triplets.emplace_back(r, r + 1, -1.0);}
+        }
+    }
+    Eigen::SparseMatrix<HostPrecision> A(g * g, g * g);
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    return A;
+}
+
+TEST(SparseTests, SELLMatchesCSR) {
+    // Window smaller than the matrix so the sort permutation crosses slices but not windows
+    const Eigen::SparseMatrix<HostPrecision> E = skewedSparse<HostPrecision>(sp_dims);
+    SellMatrix A = SellMatrix::fromCSR(SparseMatrix::fromEigen(E), 64);
+    MixedSellMatrix R = MixedSellMatrix::fromCSR(MixedSparseMatrix::fromEigen(E));
+    const Eigen::SparseMatrix<ComplexType> EC = E.cast<ComplexType>() * ComplexType(0.5, 1.5);
+    ComplexSellMatrix Z = ComplexSellMatrix::fromCSR(ComplexSparseMatrix::fromEigen(EC));
+    static_assert(is_linear_operator_v<SellMatrix>, "SELL must satisfy LinearOperator");
+
+    Vector x = Vector::Random(sp_dims);
+    Vector y(sp_dims);
+    A.apply(x.data(), y.data());
+    ASSERT_LE((y - E * x).norm(), 1e-10);
+    EXPECT_NEAR(A.norm(), E.norm(), 1e-10);
+
+    ComplexVector xc = ComplexVector::Random(sp_dims);
+    ComplexVector yc(sp_dims);
+    R.apply(xc.data(), yc.data());
+    ASSERT_LE((yc - E.cast<ComplexType>() * xc).norm(), 1e-10);
+    Z.apply(xc.data(), yc.data());
+    ASSERT_LE((yc - EC * xc).norm(), 1e-10);
+}
+
+// Times num_iters Arnoldi steps through KrylovIterInternal so the matvec is measured alongside the MGS it competes with
+template <typename Op>
+double krylovStepMillis(const Op& A, const Vector& v0, CpuBackend::BlasHandle& handle, Matrix& Q) {
+    Vector norms(sp_bench_iters);
+    Matrix H = Matrix::Zero(sp_bench_iters + 1, sp_bench_iters);
+    Vector y = v0;
+    Vector result(sp_bench_dims);
+    Q.col(0) = v0;
+    auto start = std::chrono::high_resolution_clock::now();
+    KrylovIterInternal<Op, DevicePrecision, sp_bench_dims, sp_bench_dims, sp_bench_iters, 0, CpuBackend>(
+        A, nullptr, y.data(), result.data(), Q.data(), H.data(), norms, 0, handle, A.norm());
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / sp_bench_iters;
+}
+
+TEST(SparseTests, SELLMatchesCSRKrylov) {
+    CpuBackend::BlasHandle handle;
+    CpuBackend::createHandle(handle);
+    const SparseMatrix csr = SparseMatrix::fromEigen(laplacian2D(sp_bench_grid));
+    const SellMatrix sell = SellMatrix::fromCSR(csr);
+    Vector v0 = Vector::Random(sp_bench_dims);
+    v0.normalize();
+
+    Matrix Q_csr(sp_bench_dims, sp_bench_iters + 1);
+    Matrix Q_sell(sp_bench_dims, sp_bench_iters + 1);
+    krylovStepMillis(csr, v0, handle, Q_csr);
+    krylovStepMillis(sell, v0, handle, Q_sell);
+    ASSERT_LE((Q_csr - Q_sell).norm(), 1e-8);
+    CpuBackend::destroyHandle(handle);
+}
+
+// Run with --gtest_also_run_disabled_tests --gtest_filter=SparseBenchmarks.*
+TEST(SparseBenchmarks, DISABLED_SELLvsCSRKrylov) {
+    CpuBackend::BlasHandle handle;
+    CpuBackend::createHandle(handle);
+    const SparseMatrix csr = SparseMatrix::fromEigen(laplacian2D(sp_bench_grid));
+    const SellMatrix sell = SellMatrix::fromCSR(csr);
+    Vector v0 = Vector::Random(sp_bench_dims);
+    v0.normalize();
+
+    Matrix Q(sp_bench_dims, sp_bench_iters + 1);
+    krylovStepMillis(csr, v0, handle, Q); // Warm-up
+    const double csr_ms = krylovStepMillis(csr, v0, handle, Q);
+    const double sell_ms = krylovStepMillis(sell, v0, handle, Q);
+    // Matvec alone, the part of the step the storage format changes
+    auto spmvMillis = [&v0](const auto& A) {
+        Vector y(sp_bench_dims);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t r = 0; r < sp_bench_iters; ++r) {A.apply(v0.data(), y.data());}
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / sp_bench_iters;
+    };
+    std::cout << "SpMV, CSR " << spmvMillis(csr) << " ms, SELL " << spmvMillis(sell) << " ms" << std::endl;
+    std::cout << "Krylov step, N = " << sp_bench_dims << ", nnz = " << csr.nnz() << ": CSR " << csr_ms
+              << " ms, SELL-" << SellMatrix::CHUNK << "-" << sell.sigma() << " " << sell_ms
+              << " ms (fill " << sell.fillEfficiency() << ")" << std::endl;
+    CpuBackend::destroyHandle(handle);
+}
+
+TEST(SparseTests, IRAMSparse) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    MixedSparseMatrix A = MixedSparseMatrix::fromEigen(skewedSparse<HostPrecision>(sp_iram_dims));
+    const ComplexMatrix D = A.toDense();
+
+    ComplexEigenPairs ritzPairs = IRAM<MixedSparseMatrix, sp_iram_dims, 400, 60, 10>(A, handle, solver_handle);
+    for (size_t i = 0; i < 3; ++i) {
+        const ComplexVector v = ritzPairs.vectors.col(i);
+        const HostPrecision residual = (D * v - ritzPairs.values[i] * v).norm() / v.norm();
+        EXPECT_LT(residual, 0.1) << "Ritz pair " << i;
+    }
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // SPARSE_TEST_HPP
@@ -0,0 +1,65 @@
+#ifndef SSTEP_TEST_HPP
+#define SSTEP_TEST_HPP
+
+#include <gtest/gtest.h>
+#include "IRAM.hpp"
+
+TEST(SStepTests, MatchesStandardArnoldiWithFewerReductions) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    const size_t n = 400, s = 8;
+    const ComplexMatrix M = ComplexMatrix::Random(n, n) / std::sqrt(n);
+
+    SolverConfig config{.rows = n, .max_iters = 1000, .basis_size = 40, .restart_size = 10, .num_pairs = 6,
+                        .restart = RestartMethod::KRYLOV_SCHUR, .orthogonalization = Orthogonalization::CGS2};
+    IRAMSolver<ComplexType> standard(config);
+    config.s_step = s;
+    IRAMSolver<ComplexType> blocked(config);
+    KrylovStats standard_stats, blocked_stats;
+    std::srand(3);
+    const ComplexEigenPairs expected = standard.solve(M, handle, solver_handle, &standard_stats);
+    std::srand(3);
+    const ComplexEigenPairs pairs = blocked.solve(M, handle, solver_handle, &blocked_stats);
+    std::cout << "Reductions, standard " << standard_stats.reductions << ", s = " << s << " " << blocked_stats.reductions << std::endl;
+
+    ASSERT_EQ(pairs.num_pairs, expected.num_pairs);
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        EXPECT_LT(std::abs(pairs.values[i] - expected.values[i]), 1e-8) << "Ritz value " << i;
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M * v - pairs.values[i] * v).norm(), 1e-6) << "Ritz pair " << i;
+    }
+    EXPECT_EQ(blocked_stats.s_step_fallbacks, 0u);
+    EXPECT_LT(blocked_stats.orthogonality_loss, 1e-12);
+    // Fused CGS2 needs one or two reductions per vector, a block three per s vectors (cold start aside)
+    EXPECT_LT(blocked_stats.reductions * 2, standard_stats.reductions);
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+TEST(SStepTests, IllConditionedBlocksFallBack) {
+    blasHandle_t handle;
+    solverHandle_t solver_handle;
+    DefaultBackend::createHandle(handle);
+    DefaultBackend::createHandle(solver_handle);
+    // Graded spectrum: high powers of A collapse onto the dominant eigenvectors, so long blocks lose rank
+    const size_t n = 400;
+    const Matrix M = Vector::LinSpaced(n, -12, 0).array().exp().matrix().asDiagonal();
+
+    IRAMSolver<HostPrecision> solver({.rows = n, .max_iters = 400, .basis_size = 40, .restart_size = 10, .num_pairs = 6, .s_step = 12});
+    KrylovStats stats;
+    const ComplexEigenPairs pairs = solver.solve(M, handle, solver_handle, &stats);
+    EXPECT_GT(stats.s_step_fallbacks, 0u);
+    EXPECT_LT(stats.orthogonality_loss, 1e-8); // Accepted blocks up to SSTEP_MAX_CONDITION cost some orthogonality
+    for (size_t i = 0; i < pairs.num_pairs; ++i) {
+        const ComplexVector v = pairs.vectors.col(i);
+        EXPECT_LT((M.cast<ComplexType>() * v - pairs.values[i] * v).norm(), 1e-8) << "Ritz pair " << i;
+    }
+
+    DefaultBackend::destroyHandle(handle);
+    DefaultBackend::destroyHandle(solver_handle);
+}
+
+#endif // SSTEP_TEST_HPP
@@ -0,0 +1,63 @@
+#ifndef STREAM_TEST_HPP
+#define STREAM_TEST_HPP
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include "stream.hpp"
+#include "IRAM.hpp" // Pulls in include/arnoldi.hpp, tests/arnoldi.hpp would shadow a direct include
+
+constexpr size_t stream_dims = 500;
+constexpr size_t stream_iters = 40;
+constexpr size_t stream_tile_bytes = 64 << 10; // 8 rows of complex doubles, many tiles per pass
+
+class StreamTest : public ::testing::Test {
+protected:
+    std::string path;
+    ComplexMatrix D;
+
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / ("arnoldi_stream_" + std::to_string(::getpid()) + ".bin")).string();
+        D = ComplexMatrix::Random(stream_dims, stream_dims) / std::sqrt(HostPrecision(stream_dims));
+        writeMatrixFile(path, D);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST_F(StreamTest, TiledMatvecMatchesDense) {
+    MappedMatrix<ComplexType> A(path, stream_tile_bytes);
+    static_assert(is_linear_operator_v<MappedMatrix<ComplexType>>, "Mapped matrices must satisfy LinearOperator");
+    ASSERT_EQ(A.rows(), stream_dims);
+    ASSERT_GT(A.numTiles(), 1u);
+
+    ComplexVector x = ComplexVector::Random(stream_dims);
+    ComplexVector y(stream_dims);
+    for (int pass = 0; pass < 3; ++pass) {
+        A.apply(x.data(), y.data());
+        ASSERT_LE((y - D * x).norm(), 1e-10) << "Pass " << pass;
+    }
+    EXPECT_NEAR(A.norm(), D.norm(), 1e-10);
+    EXPECT_THROW(MappedMatrix<HostPrecision>{path}, std::invalid_argument); // Scalar type mismatch
+    // The OS reason survives into the message
+    try {
+        MappedMatrix<ComplexType> missing(path + ".missing");
+        FAIL() << "Opened a missing file";
+    } catch (const MappedFileError& e) {
+        EXPECT_NE(std::string(e.what()).find(std::strerror(ENOENT)), std::string::npos) << e.what();
+    }
+}
+
+TEST_F(StreamTest, ArnoldiRelationStreamed) {
+    blasHandle_t handle;
+    DefaultBackend::createHandle(handle);
+    MappedMatrix<ComplexType> A(path, stream_tile_bytes);
+
+    KrylovPair<ComplexType> q_h = KrylovIter<MappedMatrix<ComplexType>, stream_dims, stream_dims, stream_iters>(A, handle);
+    ASSERT_LE((D * q_h.Q.leftCols(stream_iters) - q_h.Q * q_h.H).norm(), 1e-8);
+    A.report();
+    DefaultBackend::destroyHandle(handle);
+}
+
+#endif // STREAM_TEST_HPP
@@ -0,0 +1,76 @@
+#ifndef TSQR_TEST_HPP
+#define TSQR_TEST_HPP
+
+#include <chrono>
+#include <random>
+#include <gtest/gtest.h>
+#include "tsqr.hpp"
+
+template <typename Mat>
+inline Mat seededPanel(size_t rows, size_t cols, unsigned seed) {
+    std::mt19937 gen(seed); // Own engine, later tests keep their std::rand stream
+    std::uniform_real_distribution<HostPrecision> uniform(-1, 1);
+    if constexpr (is_complex_v<typename Mat::Scalar>) {
+        return Mat::NullaryExpr(rows, cols, [&] {return ComplexType(uniform(gen), uniform(gen));});
+    } else {
+        return Mat::NullaryExpr(rows, cols, [&] {return uniform(gen);});
+    }
+}
+
+template <typename Mat>
+inline void checkTsqr(size_t N, size_t p, int threads, bool positive) {
+    using S = typename Mat::Scalar;
+    const Mat A = seededPanel<Mat>(N, p, 11 + threads);
+    Mat Q = A;
+    const Mat R = tsqrHost<S>(cpublas::Handle{threads}, Q.data(), N, p, N, positive);
+    EXPECT_LE((Q * R - A).norm(), 1e-12 * A.norm()) << threads << " threads";
+    EXPECT_LE((Mat::Identity(p, p) - Q.adjoint() * Q).norm(), 1e-13) << threads << " threads";
+    EXPECT_EQ(R.template triangularView<Eigen::StrictlyLower>().toDenseMatrix().norm(), 0);
+    if (positive) {
+        for (size_t i = 0; i < p; ++i) {
+            EXPECT_GT(std::real(R(i, i)), 0);
+            EXPECT_EQ(std::imag(ComplexType(R(i, i))), 0);
+        }
+    }
+}
+
+TEST(TsqrTests, TreeShapesReproducePanel) {
+    // 1 leaf, an odd leaf passed through the tree, a full binary tree, and a deeper one
+    for (int threads : {1, 3, 4, 8}) {
+        checkTsqr<ComplexMatrix>(6000, 8, threads, true);
+        checkTsqr<Matrix>(6000, 5, threads, false);
+    }
+}
+
+TEST(TsqrTests, TallPanel) {
+    // Default thread count, many rows per leaf
+    checkTsqr<ComplexMatrix>(400000, 8, 0, false);
+}
+
+// Timing behind the README number, run with --gtest_also_run_disabled_tests --gtest_filter=TsqrBenchmarks.*
+TEST(TsqrBenchmarks, DISABLED_ParallelTsqrVsHouseholder) {
+    const size_t N = 400000, p = 8;
+    const ComplexMatrix A = seededPanel<ComplexMatrix>(N, p, 5);
+    auto best = [](auto&& f) {
+        double ms = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            f();
+            ms = std::min(ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+        return ms;
+    };
+    ComplexMatrix Q;
+    const double householder_ms = best([&] {
+        const Eigen::HouseholderQR<ComplexMatrix> qr(A);
+        Q = qr.householderQ() * ComplexMatrix::Identity(N, p);
+    });
+    const double tsqr_ms = best([&] {
+        Q = A;
+        tsqrHost<ComplexType>(cpublas::Handle{}, Q.data(), N, p, N);
+    });
+    std::cout << "QR of " << N << " x " << p << ": Householder " << householder_ms << " ms, TSQR (" << cpublas::threadCount(cpublas::Handle{})
+              << " threads) " << tsqr_ms << " ms" << std::endl;
+}
+
+#endif // TSQR_TEST_HPP